@@ -0,0 +1,85 @@
+
+// Shared by the denoiser compute passes, see Denoiser.hpp.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0, rgba32f) readonly uniform image2D AccumulationImage; // rgb sum + luminance squared sum
+layout(binding = 1, rgba16f) readonly uniform image2D NormalDepthImage; // first hit normal + distance (negative for the sky)
+layout(binding = 2, rgba16f) readonly uniform image2D AlbedoImage;
+layout(binding = 3, rgba32f) uniform image2D FilterImage0; // rgb + variance
+layout(binding = 4, rgba32f) uniform image2D FilterImage1;
+layout(binding = 5, rgba8) writeonly uniform image2D OutputImage;
+layout(binding = 6, r32f) readonly uniform image2D SampleCountImage;
+
+layout(push_constant) uniform PushConstants
+{
+	uint StepSize;
+	uint Source;
+	uint IsLastIteration;
+} Frame;
+
+// Edge-stopping strengths.
+const float NormalPhi = 128.0;
+const float DepthPhi = 1.0;
+const float LuminancePhi = 4.0;
+const float AlbedoPhi = 0.1;
+
+// Below this many samples the luminance moments of a single pixel are too noisy to be trusted.
+const uint MinTemporalSamples = 4;
+
+float Luminance(const vec3 color)
+{
+	return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+bool IsInside(const ivec2 pixel)
+{
+	return all(greaterThanEqual(pixel, ivec2(0))) && all(lessThan(pixel, imageSize(AccumulationImage)));
+}
+
+vec4 LoadFilter(const uint image, const ivec2 pixel)
+{
+	return image == 0 ? imageLoad(FilterImage0, pixel) : imageLoad(FilterImage1, pixel);
+}
+
+void StoreFilter(const uint image, const ivec2 pixel, const vec4 value)
+{
+	if (image == 0)
+	{
+		imageStore(FilterImage0, pixel, value);
+	}
+	else
+	{
+		imageStore(FilterImage1, pixel, value);
+	}
+}
+
+float DepthDifference(const ivec2 pixel, const float depth)
+{
+	const float neighbour = IsInside(pixel) ? imageLoad(NormalDepthImage, pixel).w : -1;
+	return neighbour < 0 ? 1e30 : abs(neighbour - depth);
+}
+
+// Change of depth per pixel, so that slanted surfaces are not mistaken for edges.
+float DepthGradient(const ivec2 pixel, const float depth)
+{
+	const float dx = min(DepthDifference(pixel + ivec2(1, 0), depth), DepthDifference(pixel - ivec2(1, 0), depth));
+	const float dy = min(DepthDifference(pixel + ivec2(0, 1), depth), DepthDifference(pixel - ivec2(0, 1), depth));
+	const float gradient = max(dx < 1e30 ? dx : 0, dy < 1e30 ? dy : 0);
+
+	return gradient;
+}
+
+// How likely a neighbour at the given distance (in pixels) lies on the same surface as the centre pixel.
+float GeometryWeight(const vec4 center, const float depthGradient, const vec4 neighbour, const float distance)
+{
+	// The sky only blends with the sky.
+	if (center.w < 0 || neighbour.w < 0)
+	{
+		return center.w < 0 && neighbour.w < 0 ? 1 : 0;
+	}
+
+	const float normalWeight = pow(max(dot(center.xyz, neighbour.xyz), 0), NormalPhi);
+	const float depthWeight = exp(-abs(center.w - neighbour.w) / (DepthPhi * depthGradient * distance + 1e-4));
+
+	return normalWeight * depthWeight;
+}
@@ -6,21 +6,30 @@
 
 layout(binding = 1) readonly buffer MaterialArray { Material[] Materials; };
 layout(binding = 2) uniform sampler2D[] TextureSamplers;
+layout(binding = 3) readonly buffer PrimitiveMaterialArray { uint[] PrimitiveMaterials; };
 
-layout(location = 0) in vec3 FragColor;
-layout(location = 1) in vec3 FragNormal;
-layout(location = 2) in vec2 FragTexCoord;
-layout(location = 3) in flat int FragMaterialIndex;
+layout(push_constant) uniform PushConstants
+{
+	mat4 Model;
+	int MaterialOverride;
+	uint PrimitiveOffset;
+} Instance;
+
+layout(location = 0) in vec3 FragNormal;
+layout(location = 1) in vec2 FragTexCoord;
 
 layout(location = 0) out vec4 OutColor;
 
 void main() 
 {
-	const int textureId = Materials[FragMaterialIndex].DiffuseTextureId;
+	// Materials are per primitive, gl_PrimitiveID restarts from 0 with each instance draw.
+	const uint materialIndex = Instance.MaterialOverride >= 0 ? uint(Instance.MaterialOverride) : PrimitiveMaterials[Instance.PrimitiveOffset + gl_PrimitiveID];
+	const Material m = Materials[materialIndex];
+	const int textureId = m.DiffuseTextureId;
 	const vec3 lightVector = normalize(vec3(5, 4, 3));
 	const float d = max(dot(lightVector, normalize(FragNormal)), 0.2);
 	
-	vec3 c = FragColor * d;
+	vec3 c = m.Diffuse.xyz * d;
 	if (textureId >= 0)
 	{
 		c *= texture(TextureSamplers[textureId], FragTexCoord).rgb;
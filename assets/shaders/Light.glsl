@@ -0,0 +1,9 @@
+
+// A world space light triangle, see Assets::Scene.
+struct LightTriangle
+{
+	vec4 Position0; // xyz + w (cumulative area of the lights up to and including this one)
+	vec4 Edge1;
+	vec4 Edge2;
+	vec4 Emission;
+};
@@ -0,0 +1,10 @@
+
+// Inverse of the octahedral normal encoding of Assets::VertexAttributes::Pack().
+vec3 OctahedralDecode(const vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	const float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
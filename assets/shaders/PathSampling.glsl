@@ -0,0 +1,73 @@
+
+// Path sampling shared by the ray generation shader and the wavefront compute shaders.
+// Expects Random.glsl, and the Camera uniform buffer and the Lights array to have been declared.
+
+const float Pi = 3.1415926535897932384626433832795;
+
+// Low discrepancy dimensions: the pixel and lens samples, then a fixed budget per bounce.
+// - 0: Russian roulette.
+// - 1-3: scattering (closest hit shaders, or wavefront shading stages).
+// - 4-6: light sampling.
+const uint FirstBounceDimension = 4;
+const uint DimensionsPerBounce = 8;
+
+uint BounceDimension(const uint bounce, const uint offset)
+{
+	return FirstBounceDimension + bounce * DimensionsPerBounce + offset;
+}
+
+// Once past the minimum depth, terminates the path with a probability that grows as its throughput drops.
+// Surviving paths are reweighted by the inverse of their survival probability, which keeps the estimate unbiased.
+bool RussianRoulette(const uint depth, inout vec3 throughput, inout uint seed)
+{
+	if (!Camera.RussianRoulette || depth < Camera.RussianRouletteMinDepth)
+	{
+		return false;
+	}
+
+	const float survival = min(max(throughput.r, max(throughput.g, throughput.b)), Camera.RussianRouletteMaxSurvival);
+
+	if (RandomFloat(seed) >= survival)
+	{
+		return true;
+	}
+
+	throughput /= survival;
+	return false;
+}
+
+float PowerHeuristic(const float pdf, const float otherPdf)
+{
+	return pdf * pdf / (pdf * pdf + otherPdf * otherPdf);
+}
+
+// Picks a light triangle proportionally to its area, then a uniformly distributed point on it.
+LightTriangle SampleLight(inout uint seed, out vec3 position, out vec3 normal)
+{
+	const float target = RandomFloat(seed) * Camera.TotalLightArea;
+	uint first = 0;
+	uint last = Camera.NumberOfLights - 1;
+
+	while (first < last)
+	{
+		const uint middle = (first + last) / 2;
+
+		if (Lights[middle].Position0.w < target)
+		{
+			first = middle + 1;
+		}
+		else
+		{
+			last = middle;
+		}
+	}
+
+	const LightTriangle light = Lights[first];
+	const float s = sqrt(RandomFloat(seed));
+	const float u = RandomFloat(seed);
+
+	position = light.Position0.xyz + s * (1 - u) * light.Edge1.xyz + s * u * light.Edge2.xyz;
+	normal = normalize(cross(light.Edge1.xyz, light.Edge2.xyz));
+
+	return light;
+}
@@ -0,0 +1,55 @@
+
+// One entry per procedural primitive, indexed by gl_PrimitiveID.
+struct ProceduralSphere
+{
+	vec4 Sphere; // xyz: center, w: radius
+	uint MaterialIndex;
+	uint Padding0;
+	uint Padding1;
+	uint Padding2;
+};
+
+// Closest intersection distance of the ray with the sphere in [tMin, tMax), negative if there is none.
+// https://en.wikipedia.org/wiki/Quadratic_formula
+float IntersectSphere(const vec4 sphere, const vec3 origin, const vec3 direction, const float tMin, const float tMax)
+{
+	const vec3 center = sphere.xyz;
+	const float radius = sphere.w;
+
+	const vec3 oc = origin - center;
+	const float a = dot(direction, direction);
+	const float b = dot(oc, direction);
+	const float c = dot(oc, oc) - radius * radius;
+	const float discriminant = b * b - a * c;
+
+	if (discriminant >= 0)
+	{
+		const float t1 = (-b - sqrt(discriminant)) / a;
+		const float t2 = (-b + sqrt(discriminant)) / a;
+
+		if (tMin <= t1 && t1 < tMax)
+		{
+			return t1;
+		}
+
+		if (tMin <= t2 && t2 < tMax)
+		{
+			return t2;
+		}
+	}
+
+	return -1;
+}
+
+vec2 GetSphereTexCoord(const vec3 point)
+{
+	const float phi = atan(point.x, point.z);
+	const float theta = asin(point.y);
+	const float pi = 3.1415926535897932384626433832795;
+
+	return vec2
+	(
+		(phi + pi) / (2* pi),
+		1 - (theta + pi /2) / pi
+	);
+}
@@ -1,5 +1,34 @@
 #extension GL_EXT_control_flow_attributes : require
 
+// The random state is a single uint threaded through the ray tracing shaders, its top bit selects the sampler.
+// - Pseudo random: the low 31 bits are the state of an LCG.
+// - Low discrepancy: an Owen scrambled Sobol sequence, decorrelated between pixels with RANDOM_PIXEL (gl_LaunchIDEXT by
+//   default, compute shaders define it before including this file).
+//   Bits 12-30 are the sample index, bits 0-11 the next dimension to be drawn.
+#ifndef RANDOM_PIXEL
+#define RANDOM_PIXEL gl_LaunchIDEXT.xy
+#endif
+
+const uint SamplerRandom = 0;
+const uint SamplerSobol = 1;
+
+const uint SobolStateBit = 0x80000000u;
+const uint SobolDimensionBits = 12;
+const uint SobolDimensionMask = (1u << SobolDimensionBits) - 1;
+
+// Direction numbers of the first four Sobol dimensions (Joe & Kuo), 32 per dimension.
+// Higher dimensions reuse them with independent scrambles (padding).
+const uint SobolDirections[4 * 32] = uint[](
+	0x80000000u, 0x40000000u, 0x20000000u, 0x10000000u, 0x08000000u, 0x04000000u, 0x02000000u, 0x01000000u, 0x00800000u, 0x00400000u, 0x00200000u, 0x00100000u, 0x00080000u, 0x00040000u, 0x00020000u, 0x00010000u,
+	0x00008000u, 0x00004000u, 0x00002000u, 0x00001000u, 0x00000800u, 0x00000400u, 0x00000200u, 0x00000100u, 0x00000080u, 0x00000040u, 0x00000020u, 0x00000010u, 0x00000008u, 0x00000004u, 0x00000002u, 0x00000001u,
+	0x80000000u, 0xc0000000u, 0xa0000000u, 0xf0000000u, 0x88000000u, 0xcc000000u, 0xaa000000u, 0xff000000u, 0x80800000u, 0xc0c00000u, 0xa0a00000u, 0xf0f00000u, 0x88880000u, 0xcccc0000u, 0xaaaa0000u, 0xffff0000u,
+	0x80008000u, 0xc000c000u, 0xa000a000u, 0xf000f000u, 0x88008800u, 0xcc00cc00u, 0xaa00aa00u, 0xff00ff00u, 0x80808080u, 0xc0c0c0c0u, 0xa0a0a0a0u, 0xf0f0f0f0u, 0x88888888u, 0xccccccccu, 0xaaaaaaaau, 0xffffffffu,
+	0x80000000u, 0xc0000000u, 0x60000000u, 0x90000000u, 0xe8000000u, 0x5c000000u, 0x8e000000u, 0xc5000000u, 0x68800000u, 0x9cc00000u, 0xee600000u, 0x55900000u, 0x80680000u, 0xc09c0000u, 0x60ee0000u, 0x90550000u,
+	0xe8808000u, 0x5cc0c000u, 0x8e606000u, 0xc5909000u, 0x6868e800u, 0x9c9c5c00u, 0xeeee8e00u, 0x5555c500u, 0x8000e880u, 0xc0005cc0u, 0x60008e60u, 0x9000c590u, 0xe8006868u, 0x5c009c9cu, 0x8e00eeeeu, 0xc5005555u,
+	0x80000000u, 0xc0000000u, 0x20000000u, 0x50000000u, 0xf8000000u, 0x74000000u, 0xa2000000u, 0x93000000u, 0xd8800000u, 0x25400000u, 0x59e00000u, 0xe6d00000u, 0x78080000u, 0xb40c0000u, 0x82020000u, 0xc3050000u,
+	0x208f8000u, 0x51474000u, 0xfbea2000u, 0x75d93000u, 0xa0858800u, 0x914e5400u, 0xdbe79e00u, 0x25db6d00u, 0x58800080u, 0xe54000c0u, 0x79e00020u, 0xb6d00050u, 0x800800f8u, 0xc00c0074u, 0x200200a2u, 0x50050093u
+);
+
 // Generates a seed for a random number generator from 2 inputs plus a backoff
 // https://github.com/nvpro-samples/optix_prime_baking/blob/332a886f1ac46c0b3eea9e89a59593470c755a0e/random.h
 // https://github.com/nvpro-samples/vk_raytracing_tutorial_KHR/tree/master/ray_tracing_jitter_cam
@@ -16,17 +45,94 @@ uint InitRandomSeed(uint val0, uint val1)
 		v1 += ((v0 << 4) + 0xad90777d) ^ (v0 + s0) ^ ((v0 >> 5) + 0x7e95761e);
 	}
 
-	return v0;
+	// The top bit is left clear, making it a pseudo random state.
+	return v0 & ~SobolStateBit;
+}
+
+// Low discrepancy state for the given sample of the pixel, starting at the given dimension.
+uint InitSobolSeed(const uint sampleIndex, const uint dimension)
+{
+	return SobolStateBit | ((sampleIndex << SobolDimensionBits) & ~SobolStateBit) | (dimension & SobolDimensionMask);
+}
+
+// Moves a low discrepancy state to the given dimension, so that each bounce draws from the same dimensions whatever
+// the number of values used by the previous ones. Pseudo random states are left unchanged.
+uint SeekDimension(const uint seed, const uint dimension)
+{
+	return (seed & SobolStateBit) != 0 ? (seed & ~SobolDimensionMask) | (dimension & SobolDimensionMask) : seed;
+}
+
+// https://github.com/skeeto/hash-prospector (lowbias32)
+uint Hash(uint x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+uint HashCombine(const uint seed, const uint value)
+{
+	return seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+}
+
+// Owen scrambling of the bits of x, most significant bit first.
+// https://www.jcgt.org/published/0009/04/01/ (Burley, Practical Hash-based Owen Scrambling)
+uint NestedUniformScramble(uint x, const uint seed)
+{
+	x = bitfieldReverse(x);
+	x += seed;
+	x ^= x * 0x6c50b47cu;
+	x ^= x * 0xb82f1e52u;
+	x ^= x * 0xc7afe638u;
+	x ^= x * 0x8d22f6e6u;
+	return bitfieldReverse(x);
+}
+
+float SobolFloat(const uint sampleIndex, const uint dimension)
+{
+	const uvec2 pixel = RANDOM_PIXEL;
+	const uint pixelSeed = Hash(pixel.x + Hash(pixel.y));
+	const uint seed = HashCombine(pixelSeed, Hash(dimension / 4));
+	const uint component = dimension % 4;
+
+	// Shuffling the sample order per pixel and group of four dimensions decorrelates the padded dimensions.
+	uint index = NestedUniformScramble(sampleIndex, seed);
+	uint x = 0;
+
+	for (uint bit = 0; index != 0; ++bit, index >>= 1)
+	{
+		if ((index & 1) != 0)
+		{
+			x ^= SobolDirections[component * 32 + bit];
+		}
+	}
+
+	x = NestedUniformScramble(x, HashCombine(seed, component));
+
+	return float(x >> 8) / float(0x01000000);
 }
 
 uint RandomInt(inout uint seed)
 {
-	// LCG values from Numerical Recipes
-    return (seed = 1664525 * seed + 1013904223);
+	// LCG values from Numerical Recipes, the top bit does not affect the others and is kept clear.
+    return (seed = (1664525 * seed + 1013904223) & ~SobolStateBit);
 }
 
 float RandomFloat(inout uint seed)
 {
+	if ((seed & SobolStateBit) != 0)
+	{
+		const uint sampleIndex = (seed & ~SobolStateBit) >> SobolDimensionBits;
+		const uint dimension = seed & SobolDimensionMask;
+
+		seed = (seed & ~SobolDimensionMask) | ((dimension + 1) & SobolDimensionMask);
+
+		return SobolFloat(sampleIndex, dimension);
+	}
+
 	//// Float version using bitmask from Numerical Recipes
 	//const uint one = 0x3f800000;
 	//const uint msk = 0x007fffff;
@@ -36,26 +142,39 @@ float RandomFloat(inout uint seed)
 	return (float(RandomInt(seed) & 0x00FFFFFF) / float(0x01000000));
 }
 
+vec3 RandomUnitVector(inout uint seed)
+{
+	const float pi = 3.1415926535897932384626433832795;
+	const float z = 2 * RandomFloat(seed) - 1;
+	const float a = 2 * pi * RandomFloat(seed);
+	const float r = sqrt(max(0, 1 - z * z));
+
+	return vec3(r * cos(a), r * sin(a), z);
+}
+
+// Concentric mapping of the square onto the disk (Shirley & Chiu). Unlike rejection sampling it draws exactly two values,
+// and keeps the stratification of low discrepancy samples.
 vec2 RandomInUnitDisk(inout uint seed)
 {
-	for (;;)
+	const float pi = 3.1415926535897932384626433832795;
+	const vec2 u = 2 * vec2(RandomFloat(seed), RandomFloat(seed)) - 1;
+
+	if (u.x == 0 && u.y == 0)
 	{
-		const vec2 p = 2 * vec2(RandomFloat(seed), RandomFloat(seed)) - 1;
-		if (dot(p, p) < 1)
-		{
-			return p;
-		}
+		return vec2(0);
 	}
+
+	const bool isMajorX = abs(u.x) > abs(u.y);
+	const float r = isMajorX ? u.x : u.y;
+	const float theta = isMajorX ? (pi / 4) * (u.y / u.x) : (pi / 2) - (pi / 4) * (u.x / u.y);
+
+	return r * vec2(cos(theta), sin(theta));
 }
 
+// Uniform in the ball: a uniform direction, with a radius distributed as the cube root of a uniform value.
 vec3 RandomInUnitSphere(inout uint seed)
 {
-	for (;;)
-	{
-		const vec3 p = 2 * vec3(RandomFloat(seed), RandomFloat(seed), RandomFloat(seed)) - 1;
-		if (dot(p, p) < 1)
-		{
-			return p;
-		}
-	}
+	const vec3 direction = RandomUnitVector(seed);
+
+	return direction * pow(RandomFloat(seed), 1.0 / 3.0);
 }
@@ -0,0 +1,31 @@
+
+// Texture level of detail with ray cones (Akenine-Moller et al., "Texture Level of Detail Strategies for Real-Time Ray
+// Tracing"). The cones keep the spread angle of a camera pixel (see UniformBufferObject), so that their width at a hit
+// is proportional to the length of the path so far. The footprints are in texture coordinates, see Scatter.glsl.
+
+// Width of the cone at the end of a segment, t along a direction that is not necessarily normalized.
+float ConeWidth(const float originWidth, const float spreadAngle, const vec3 direction, const float t)
+{
+	return originWidth + spreadAngle * t * length(direction);
+}
+
+// Footprint of a cone on a triangle, given its world space edges and the texture coordinates of its vertices.
+float TriangleTexCoordFootprint(const float coneWidth, const vec3 direction, const vec3 normal, const vec3 edge1, const vec3 edge2, const vec2 t0, const vec2 t1, const vec2 t2)
+{
+	const float worldArea = length(cross(edge1, edge2));
+	const vec2 texEdge1 = t1 - t0;
+	const vec2 texEdge2 = t2 - t0;
+	const float texCoordArea = abs(texEdge1.x * texEdge2.y - texEdge2.x * texEdge1.y);
+	const float cosine = max(abs(dot(normalize(direction), normal)), 0.01);
+
+	return worldArea > 0 ? coneWidth / cosine * sqrt(texCoordArea / worldArea) : 0;
+}
+
+// Footprint of a cone on a sphere of the given world space radius, the texture coordinates map the whole sphere once.
+float SphereTexCoordFootprint(const float coneWidth, const vec3 direction, const vec3 normal, const float radius)
+{
+	const float pi = 3.1415926535897932384626433832795;
+	const float cosine = max(abs(dot(normalize(direction), normal)), 0.01);
+
+	return coneWidth / cosine / (2 * radius * sqrt(pi));
+}
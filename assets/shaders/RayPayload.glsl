@@ -1,7 +1,8 @@
 
 struct RayPayload
 {
-	vec4 ColorAndDistance; // rgb + t
-	vec4 ScatterDirection; // xyz + w (is scatter needed)
+	vec4 ColorAndDistance; // rgb + t (on the way in, w is the ray cone width at the ray origin, see RayCone.glsl)
+	vec4 ScatterDirection; // xyz + w (1: scattered, 0: absorbed, -1: emitted)
+	vec4 NormalAndPdf; // world space normal + w (pdf of the scatter direction, 0 if specular; for lights, 1 if in the light list)
 	uint RandomSeed;
 };
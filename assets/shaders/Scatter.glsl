@@ -11,32 +11,51 @@ float Schlick(const float cosine, const float refractionIndex)
 	return r0 + (1 - r0) * pow(1 - cosine, 5);
 }
 
+// The mip level covers the footprint of the ray cone (see RayCone.glsl), in texture coordinates.
+vec4 DiffuseTexture(const Material m, const vec2 texCoord, const float texFootprint)
+{
+	if (m.DiffuseTextureId < 0)
+	{
+		return vec4(1);
+	}
+
+	const vec2 size = textureSize(TextureSamplers[nonuniformEXT(m.DiffuseTextureId)], 0);
+	const float lod = log2(max(texFootprint * sqrt(size.x * size.y), 1e-8));
+
+	return textureLod(TextureSamplers[nonuniformEXT(m.DiffuseTextureId)], texCoord, lod);
+}
+
 // Lambertian
-RayPayload ScatterLambertian(const Material m, const vec3 direction, const vec3 normal, const vec2 texCoord, const float t, inout uint seed)
+// Cosine weighted: a point on the unit sphere offset by the normal. The pdf is needed by next event estimation.
+RayPayload ScatterLambertian(const Material m, const vec3 direction, const vec3 normal, const vec2 texCoord, const float texFootprint, const float t, inout uint seed)
 {
+	const float pi = 3.1415926535897932384626433832795;
 	const bool isScattered = dot(direction, normal) < 0;
-	const vec4 texColor = m.DiffuseTextureId >= 0 ? texture(TextureSamplers[nonuniformEXT(m.DiffuseTextureId)], texCoord) : vec4(1);
+	const vec4 texColor = DiffuseTexture(m, texCoord, texFootprint);
 	const vec4 colorAndDistance = vec4(m.Diffuse.rgb * texColor.rgb, t);
-	const vec4 scatter = vec4(normal + RandomInUnitSphere(seed), isScattered ? 1 : 0);
+	const vec3 offset = normal + RandomUnitVector(seed);
+	const vec3 scatterDirection = dot(offset, offset) > 1e-8 ? normalize(offset) : normal;
+	const vec4 scatter = vec4(scatterDirection, isScattered ? 1 : 0);
+	const vec4 normalAndPdf = vec4(normal, max(dot(scatterDirection, normal), 0) / pi);
 
-	return RayPayload(colorAndDistance, scatter, seed);
+	return RayPayload(colorAndDistance, scatter, normalAndPdf, seed);
 }
 
 // Metallic
-RayPayload ScatterMetallic(const Material m, const vec3 direction, const vec3 normal, const vec2 texCoord, const float t, inout uint seed)
+RayPayload ScatterMetallic(const Material m, const vec3 direction, const vec3 normal, const vec2 texCoord, const float texFootprint, const float t, inout uint seed)
 {
 	const vec3 reflected = reflect(direction, normal);
 	const bool isScattered = dot(reflected, normal) > 0;
 
-	const vec4 texColor = m.DiffuseTextureId >= 0 ? texture(TextureSamplers[nonuniformEXT(m.DiffuseTextureId)], texCoord) : vec4(1);
+	const vec4 texColor = DiffuseTexture(m, texCoord, texFootprint);
 	const vec4 colorAndDistance = vec4(m.Diffuse.rgb * texColor.rgb, t);
 	const vec4 scatter = vec4(reflected + m.Fuzziness*RandomInUnitSphere(seed), isScattered ? 1 : 0);
 
-	return RayPayload(colorAndDistance, scatter, seed);
+	return RayPayload(colorAndDistance, scatter, vec4(normal, 0), seed);
 }
 
 // Dielectric
-RayPayload ScatterDieletric(const Material m, const vec3 direction, const vec3 normal, const vec2 texCoord, const float t, inout uint seed)
+RayPayload ScatterDieletric(const Material m, const vec3 direction, const vec3 normal, const vec2 texCoord, const float texFootprint, const float t, inout uint seed)
 {
 	const float dot = dot(direction, normal);
 	const vec3 outwardNormal = dot > 0 ? -normal : normal;
@@ -46,36 +65,54 @@ RayPayload ScatterDieletric(const Material m, const vec3 direction, const vec3 n
 	const vec3 refracted = refract(direction, outwardNormal, niOverNt);
 	const float reflectProb = refracted != vec3(0) ? Schlick(cosine, m.RefractionIndex) : 1;
 
-	const vec4 texColor = m.DiffuseTextureId >= 0 ? texture(TextureSamplers[nonuniformEXT(m.DiffuseTextureId)], texCoord) : vec4(1);
+	const vec4 texColor = DiffuseTexture(m, texCoord, texFootprint);
 	
 	return RandomFloat(seed) < reflectProb
-		? RayPayload(vec4(texColor.rgb, t), vec4(reflect(direction, normal), 1), seed)
-		: RayPayload(vec4(texColor.rgb, t), vec4(refracted, 1), seed);
+		? RayPayload(vec4(texColor.rgb, t), vec4(reflect(direction, normal), 1), vec4(normal, 0), seed)
+		: RayPayload(vec4(texColor.rgb, t), vec4(refracted, 1), vec4(normal, 0), seed);
+}
+
+// Isotropic
+// Scatters uniformly in every direction, as a participating medium would. Not light sampled, the pdf is left at 0.
+RayPayload ScatterIsotropic(const Material m, const vec3 normal, const vec2 texCoord, const float texFootprint, const float t, inout uint seed)
+{
+	const vec4 texColor = DiffuseTexture(m, texCoord, texFootprint);
+	const vec4 colorAndDistance = vec4(m.Diffuse.rgb * texColor.rgb, t);
+	const vec4 scatter = vec4(RandomUnitVector(seed), 1);
+
+	return RayPayload(colorAndDistance, scatter, vec4(normal, 0), seed);
 }
 
 // Diffuse Light
-RayPayload ScatterDiffuseLight(const Material m, const float t, inout uint seed)
+RayPayload ScatterDiffuseLight(const Material m, const vec3 normal, const float t, inout uint seed)
 {
 	const vec4 colorAndDistance = vec4(m.Diffuse.rgb, t);
-	const vec4 scatter = vec4(1, 0, 0, 0);
+	const vec4 scatter = vec4(1, 0, 0, -1);
 
-	return RayPayload(colorAndDistance, scatter, seed);
+	return RayPayload(colorAndDistance, scatter, vec4(normal, 0), seed);
 }
 
-RayPayload Scatter(const Material m, const vec3 direction, const vec3 normal, const vec2 texCoord, const float t, inout uint seed)
+// The switch folds away when the material model is known at compile time, e.g. a specialization constant.
+RayPayload ScatterModel(const uint materialModel, const Material m, const vec3 direction, const vec3 normal, const vec2 texCoord, const float texFootprint, const float t, inout uint seed)
 {
 	const vec3 normDirection = normalize(direction);
 
-	switch (m.MaterialModel)
+	switch (materialModel)
 	{
 	case MaterialLambertian:
-		return ScatterLambertian(m, normDirection, normal, texCoord, t, seed);
+		return ScatterLambertian(m, normDirection, normal, texCoord, texFootprint, t, seed);
 	case MaterialMetallic:
-		return ScatterMetallic(m, normDirection, normal, texCoord, t, seed);
+		return ScatterMetallic(m, normDirection, normal, texCoord, texFootprint, t, seed);
 	case MaterialDielectric:
-		return ScatterDieletric(m, normDirection, normal, texCoord, t, seed);
+		return ScatterDieletric(m, normDirection, normal, texCoord, texFootprint, t, seed);
+	case MaterialIsotropic:
+		return ScatterIsotropic(m, normal, texCoord, texFootprint, t, seed);
 	case MaterialDiffuseLight:
-		return ScatterDiffuseLight(m, t, seed);
+		return ScatterDiffuseLight(m, normal, t, seed);
 	}
 }
 
+RayPayload Scatter(const Material m, const vec3 direction, const vec3 normal, const vec2 texCoord, const float texFootprint, const float t, inout uint seed)
+{
+	return ScatterModel(m.MaterialModel, m, direction, normal, texCoord, texFootprint, t, seed);
+}
@@ -5,13 +5,24 @@ struct UniformBufferObject
 	mat4 Projection;
 	mat4 ModelViewInverse;
 	mat4 ProjectionInverse;
+	mat4 PreviousModelView;
+	mat4 PreviousProjection;
 	float Aperture;
 	float FocusDistance;
 	float HeatmapScale;
-	uint TotalNumberOfSamples;
-	uint NumberOfSamples;
 	uint NumberOfBounces;
-	uint RandomSeed;
 	bool HasSky;
 	bool ShowHeatmap;
+	bool NextEventEstimation;
+	uint NumberOfLights;
+	float TotalLightArea;
+	bool RussianRoulette;
+	uint RussianRouletteMinDepth;
+	float RussianRouletteMaxSurvival;
+	uint Sampler;
+	bool Denoise;
+	bool TemporalReprojection;
+	bool AdaptiveSampling;
+	bool ShowSampleDistribution;
+	float PixelSpreadAngle;
 };
@@ -1,23 +1,53 @@
+#include "Octahedral.glsl"
 
+// The including shader declares Vertices (float3 positions), VertexAttributes (see Assets::VertexAttributes),
+// Indices (16 and 32-bit indices, read as 32-bit words) and PrimitiveMaterials (one material index per triangle).
 struct Vertex
 {
-  vec3 Position;
   vec3 Normal;
   vec2 TexCoord;
-  int MaterialIndex;
 };
 
 Vertex UnpackVertex(uint index)
 {
-	const uint vertexSize = 9;
-	const uint offset = index * vertexSize;
-	
+	const uvec2 attributes = VertexAttributes[index];
+
 	Vertex v;
-	
-	v.Position = vec3(Vertices[offset + 0], Vertices[offset + 1], Vertices[offset + 2]);
-	v.Normal = vec3(Vertices[offset + 3], Vertices[offset + 4], Vertices[offset + 5]);
-	v.TexCoord = vec2(Vertices[offset + 6], Vertices[offset + 7]);
-	v.MaterialIndex = floatBitsToInt(Vertices[offset + 8]);
+
+	v.Normal = OctahedralDecode(unpackSnorm2x16(attributes.x));
+	v.TexCoord = unpackHalf2x16(attributes.y);
 
 	return v;
 }
+
+// Positions are only needed for the geometric normal of lights, the BLAS builds are their main reader.
+vec3 UnpackPosition(uint index)
+{
+	const uint offset = index * 3;
+
+	return vec3(Vertices[offset + 0], Vertices[offset + 1], Vertices[offset + 2]);
+}
+
+// Matches Assets::Scene::Index16BitFlag, in the w component of the instance offsets.
+const uint Index16BitFlag = 0x80000000u;
+
+// The vertices of a triangle, from the instance offsets (see Assets::Scene).
+uvec3 UnpackTriangle(const uvec4 offsets, const uint primitive)
+{
+	const uint first = offsets.x + primitive * 3;
+
+	if ((offsets.w & Index16BitFlag) != 0)
+	{
+		const uvec3 i = uvec3(first, first + 1, first + 2);
+		const uvec3 words = uvec3(Indices[i.x >> 1u], Indices[i.y >> 1u], Indices[i.z >> 1u]);
+
+		return offsets.y + ((words >> ((i & 1u) * 16u)) & 0xffffu);
+	}
+
+	return offsets.y + uvec3(Indices[first + 0], Indices[first + 1], Indices[first + 2]);
+}
+
+uint PrimitiveMaterial(const uvec4 offsets, const uint primitive)
+{
+	return PrimitiveMaterials[(offsets.w & ~Index16BitFlag) + primitive];
+}
@@ -0,0 +1,171 @@
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_EXT_ray_query : require
+
+// Wavefront path tracing, see WavefrontPathTracer.hpp. Every stage is a compute shader sharing the same descriptor set.
+// The samples of a frame are traced one after the other, with one path per pixel: the path index is the pixel index.
+
+// The low discrepancy samples of a path are decorrelated with its pixel (see Random.glsl).
+uvec2 RandomPixel;
+#define RANDOM_PIXEL RandomPixel
+
+#include "Light.glsl"
+#include "Material.glsl"
+#include "ProceduralSphere.glsl"
+#include "RayCone.glsl"
+#include "UniformBufferObject.glsl"
+
+layout(binding = 0) uniform accelerationStructureEXT Scene;
+layout(binding = 1, rgba32f) uniform image2D AccumulationImage;
+layout(binding = 2, rgba8) uniform image2D OutputImage;
+layout(binding = 3) readonly uniform UniformBufferObjectStruct { UniformBufferObject Camera; };
+layout(binding = 4) readonly buffer VertexArray { float Vertices[]; };
+layout(binding = 5) readonly buffer IndexArray { uint Indices[]; };
+layout(binding = 6) readonly buffer MaterialArray { Material[] Materials; };
+layout(binding = 7) readonly buffer OffsetArray { uvec4[] Offsets; };
+layout(binding = 8) uniform sampler2D[] TextureSamplers;
+layout(binding = 9) readonly buffer ProceduralArray { ProceduralSphere[] Procedurals; };
+layout(binding = 10) readonly buffer LightArray { LightTriangle[] Lights; };
+
+struct PathCounter
+{
+	uint Paths;
+	uint Segments;
+};
+
+layout(binding = 11) buffer PathCounterArray { PathCounter[] PathCounters; };
+layout(binding = 12, rgba16f) uniform image2D NormalDepthImage;
+layout(binding = 13, rgba16f) uniform image2D AlbedoImage;
+layout(binding = 14, r32f) uniform image2D SampleCountImage;
+layout(binding = 21) readonly buffer VertexAttributeArray { uvec2 VertexAttributes[]; };
+layout(binding = 22) readonly buffer PrimitiveMaterialArray { uint PrimitiveMaterials[]; };
+
+struct Path
+{
+	vec4 OriginAndPdf; // xyz + pdf of the direction (0 for camera rays and specular scatters that light sampling cannot reproduce)
+	vec4 Direction; // xyz + ray cone width at the origin (see RayCone.glsl)
+	vec3 Throughput;
+	uint RandomSeed;
+};
+
+// The surface found by the extension stage, for the shading stages.
+struct Hit
+{
+	vec4 NormalAndDistance; // world space shading normal + t
+	vec2 TexCoord;
+	uint MaterialIndex;
+	float LightCosine; // of the ray with the geometric normal of a light in the light list, 0 otherwise
+	float TexFootprint; // of the ray cone, 0 for untextured materials
+};
+
+// Light sample from the origin of a shaded path, its radiance is added if nothing occludes it.
+struct ShadowRay
+{
+	vec4 DirectionAndDistance;
+	vec4 Radiance;
+};
+
+// A queue of path indices, its count doubles as the indirect dispatch of the stage that consumes it.
+struct Queue
+{
+	uint Count;
+	uint GroupCountX;
+	uint GroupCountY;
+	uint GroupCountZ;
+};
+
+layout(binding = 15) buffer PathArray { Path[] Paths; };
+layout(binding = 16) buffer HitArray { Hit[] Hits; };
+layout(binding = 17) buffer ShadowRayArray { ShadowRay[] ShadowRays; };
+layout(binding = 18) buffer QueueArray { Queue[] Queues; };
+layout(binding = 19) buffer QueueItemArray { uint[] QueueItems; };
+layout(binding = 20) buffer RadianceArray { vec4[] Radiance; }; // of the current sample
+
+layout(push_constant) uniform PushConstants
+{
+	uint TotalNumberOfSamples;
+	uint NumberOfSamples;
+	uint SampleOffset;
+	uint Sample; // in the frame
+	uint Bounce;
+	uint Width;
+	uint Height;
+} Frame;
+
+// Must match WavefrontPathTracer.hpp.
+const uint WorkGroupSize = 64;
+const uint QueueExtend = 0; // two queues, the paths of the current and of the next bounce
+const uint QueueShade = 2; // one queue per shading stage
+const uint QueueShadow = 7;
+
+const uint NoPath = 0xffffffffu;
+const float TMin = 0.001;
+const float TMax = 10000.0;
+
+// The shading stage of a material model (see WavefrontPathTracer::ShadingModels), every model has one.
+uint ShadingStage(const uint materialModel)
+{
+	switch (materialModel)
+	{
+	case MaterialMetallic: return 1;
+	case MaterialDielectric: return 2;
+	case MaterialDiffuseLight: return 3;
+	case MaterialIsotropic: return 4;
+	}
+
+	return 0; // Lambertian
+}
+
+uvec2 PathPixel(const uint path)
+{
+	return uvec2(path % Frame.Width, path / Frame.Width);
+}
+
+// Whether the path writes the denoiser guides: the first hit of the first sample of the frame.
+bool IsGuidePath()
+{
+	return Camera.Denoise && Frame.Sample == 0 && Frame.Bounce == 0;
+}
+
+void Push(const uint queue, const uint path)
+{
+	const uint index = atomicAdd(Queues[queue].Count, 1);
+
+	QueueItems[queue * Frame.Width * Frame.Height + index] = path;
+
+	if (index % WorkGroupSize == 0)
+	{
+		atomicAdd(Queues[queue].GroupCountX, 1);
+	}
+}
+
+// The path of this invocation in the queue, NoPath past its end.
+uint Pop(const uint queue)
+{
+	const uint index = gl_GlobalInvocationID.x;
+
+	return index < Queues[queue].Count ? QueueItems[queue * Frame.Width * Frame.Height + index] : NoPath;
+}
+
+// Procedural spheres are the candidates left to the ray query, the equivalent of RayTracing.Procedural.rint.
+void ProceedRayQuery(inout rayQueryEXT rayQuery, const float tMax)
+{
+	while (rayQueryProceedEXT(rayQuery))
+	{
+		if (rayQueryGetIntersectionTypeEXT(rayQuery, false) == gl_RayQueryCandidateIntersectionAABBEXT)
+		{
+			const bool hasCommitted = rayQueryGetIntersectionTypeEXT(rayQuery, true) != gl_RayQueryCommittedIntersectionNoneEXT;
+			const vec4 sphere = Procedurals[rayQueryGetIntersectionPrimitiveIndexEXT(rayQuery, false)].Sphere;
+			const float t = IntersectSphere(
+				sphere,
+				rayQueryGetIntersectionObjectRayOriginEXT(rayQuery, false),
+				rayQueryGetIntersectionObjectRayDirectionEXT(rayQuery, false),
+				rayQueryGetRayTMinEXT(rayQuery),
+				hasCommitted ? rayQueryGetIntersectionTEXT(rayQuery, true) : tMax);
+
+			if (t >= 0)
+			{
+				rayQueryGenerateIntersectionEXT(rayQuery, t);
+			}
+		}
+	}
+}
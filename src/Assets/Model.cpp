@@ -1,5 +1,6 @@
 #include "Model.hpp"
 #include "CornellBox.hpp"
+#include "ModelCache.hpp"
 #include "Procedural.hpp"
 #include "Sphere.hpp"
 #include "Utilities/Exception.hpp"
@@ -10,9 +11,12 @@
 #include <glm/gtx/hash.hpp>
 
 #include <tiny_obj_loader.h>
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <filesystem>
 #include <iostream>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -42,11 +46,336 @@ namespace std
 
 namespace Assets {
 
+namespace
+{
+	uint32_t loaderThreads = 0;
+	bool useModelCache = true;
+
+	// Below this many indices, spinning up threads costs more than it saves.
+	constexpr size_t MinIndicesPerThread = 64 * 1024;
+
+	Vertex GetObjVertex(const tinyobj::attrib_t& objAttrib, const tinyobj::mesh_t& mesh, const size_t indexId)
+	{
+		const auto& index = mesh.indices[indexId];
+
+		Vertex vertex = {};
+
+		vertex.Position =
+		{
+			objAttrib.vertices[3 * index.vertex_index + 0],
+			objAttrib.vertices[3 * index.vertex_index + 1],
+			objAttrib.vertices[3 * index.vertex_index + 2],
+		};
+
+		if (!objAttrib.normals.empty())
+		{
+			vertex.Normal =
+			{
+				objAttrib.normals[3 * index.normal_index + 0],
+				objAttrib.normals[3 * index.normal_index + 1],
+				objAttrib.normals[3 * index.normal_index + 2]
+			};
+		}
+
+		if (!objAttrib.texcoords.empty())
+		{
+			vertex.TexCoord =
+			{
+				objAttrib.texcoords[2 * index.texcoord_index + 0],
+				1 - objAttrib.texcoords[2 * index.texcoord_index + 1]
+			};
+		}
+
+		// Material ids are per face of the current shape.
+		vertex.MaterialIndex = std::max(0, mesh.material_ids[indexId / 3]);
+
+		return vertex;
+	}
+
+	uint32_t GetNumberOfLoaderThreads(const std::vector<tinyobj::shape_t>& shapes)
+	{
+		size_t numberOfIndices = 0;
+
+		for (const auto& shape : shapes)
+		{
+			numberOfIndices += shape.mesh.indices.size();
+		}
+
+		const size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		const size_t requestedThreads = loaderThreads != 0 ? loaderThreads : hardwareThreads;
+		const size_t usefulThreads = std::max<size_t>(1, numberOfIndices / MinIndicesPerThread);
+
+		return static_cast<uint32_t>(std::min(requestedThreads, usefulThreads));
+	}
+
+	// Reference single threaded deduplication, vertices are numbered in order of first appearance.
+	void DeduplicateVertices(
+		const tinyobj::attrib_t& objAttrib,
+		const std::vector<tinyobj::shape_t>& shapes,
+		std::vector<Vertex>& vertices,
+		std::vector<uint32_t>& indices)
+	{
+		std::unordered_map<Vertex, uint32_t> uniqueVertices(objAttrib.vertices.size());
+
+		for (const auto& shape : shapes)
+		{
+			const auto& mesh = shape.mesh;
+
+			for (size_t i = 0; i != mesh.indices.size(); ++i)
+			{
+				const auto vertex = GetObjVertex(objAttrib, mesh, i);
+
+				if (uniqueVertices.count(vertex) == 0)
+				{
+					uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
+					vertices.push_back(vertex);
+				}
+
+				indices.push_back(uniqueVertices[vertex]);
+			}
+		}
+	}
+
+	// Open addressing (linear probing) table mapping vertices to their index in an external vertex array.
+	// Equality is Vertex::operator==, the hash treats -0.0 and +0.0 alike to stay consistent with it.
+	class VertexHashTable final
+	{
+	public:
+
+		explicit VertexHashTable(const size_t expectedSize)
+		{
+			Resize(std::max<size_t>(16, expectedSize * 2));
+		}
+
+		uint32_t FindOrInsert(const Vertex& vertex, std::vector<Vertex>& vertices)
+		{
+			const auto hash = Hash(vertex);
+
+			for (size_t slot = hash & mask_; ; slot = (slot + 1) & mask_)
+			{
+				auto& entry = slots_[slot];
+
+				if (entry.Index == Empty)
+				{
+					if ((vertices.size() + 1) * 2 > slots_.size())
+					{
+						Rehash(slots_.size() * 2);
+						return FindOrInsert(vertex, vertices);
+					}
+
+					entry.Hash = hash;
+					entry.Index = static_cast<uint32_t>(vertices.size());
+					vertices.push_back(vertex);
+					return entry.Index;
+				}
+
+				if (entry.Hash == hash && vertices[entry.Index] == vertex)
+				{
+					return entry.Index;
+				}
+			}
+		}
+
+	private:
+
+		static constexpr uint32_t Empty = ~0u;
+
+		struct Slot final
+		{
+			uint32_t Hash;
+			uint32_t Index;
+		};
+
+		static uint32_t Hash(const Vertex& vertex)
+		{
+			const float values[] =
+			{
+				vertex.Position.x, vertex.Position.y, vertex.Position.z,
+				vertex.Normal.x, vertex.Normal.y, vertex.Normal.z,
+				vertex.TexCoord.x, vertex.TexCoord.y
+			};
+
+			uint64_t hash = static_cast<uint32_t>(vertex.MaterialIndex);
+
+			for (const float value : values)
+			{
+				uint32_t bits = 0;
+				const float canonical = value == 0.0f ? 0.0f : value;
+				std::memcpy(&bits, &canonical, sizeof(bits));
+
+				hash = (hash ^ bits) * 0x9e3779b97f4a7c15ull;
+			}
+
+			return static_cast<uint32_t>(hash ^ (hash >> 32));
+		}
+
+		void Resize(const size_t capacity)
+		{
+			size_t size = 1;
+			while (size < capacity)
+			{
+				size *= 2;
+			}
+
+			slots_.assign(size, Slot{ 0, Empty });
+			mask_ = size - 1;
+		}
+
+		void Rehash(const size_t capacity)
+		{
+			const auto old = std::move(slots_);
+			Resize(capacity);
+
+			for (const auto& entry : old)
+			{
+				if (entry.Index != Empty)
+				{
+					size_t slot = entry.Hash & mask_;
+					while (slots_[slot].Index != Empty)
+					{
+						slot = (slot + 1) & mask_;
+					}
+
+					slots_[slot] = entry;
+				}
+			}
+		}
+
+		std::vector<Slot> slots_;
+		size_t mask_{};
+	};
+
+	// Multithreaded deduplication, bit-identical to DeduplicateVertices().
+	// 1. Each thread deduplicates a contiguous chunk of the index stream, keeping chunk local vertices in order of first appearance.
+	// 2. The chunk local vertices are merged in chunk order into the global table, which preserves the global order of first appearance.
+	// 3. Each thread remaps its chunk local indices to the global ones.
+	void DeduplicateVerticesParallel(
+		const tinyobj::attrib_t& objAttrib,
+		const std::vector<tinyobj::shape_t>& shapes,
+		const uint32_t numberOfThreads,
+		std::vector<Vertex>& vertices,
+		std::vector<uint32_t>& indices)
+	{
+		struct Chunk final
+		{
+			size_t Begin;
+			size_t End;
+			std::vector<Vertex> Vertices;
+			std::vector<uint32_t> Remap;
+		};
+
+		// Flatten the shapes into a single index stream.
+		std::vector<size_t> shapeOffsets;
+		shapeOffsets.reserve(shapes.size() + 1);
+		shapeOffsets.push_back(0);
+
+		for (const auto& shape : shapes)
+		{
+			shapeOffsets.push_back(shapeOffsets.back() + shape.mesh.indices.size());
+		}
+
+		const size_t numberOfIndices = shapeOffsets.back();
+		indices.resize(numberOfIndices);
+
+		std::vector<Chunk> chunks(numberOfThreads);
+
+		for (size_t i = 0; i != chunks.size(); ++i)
+		{
+			chunks[i].Begin = numberOfIndices * i / chunks.size();
+			chunks[i].End = numberOfIndices * (i + 1) / chunks.size();
+		}
+
+		const auto parallelFor = [&chunks](const auto& function)
+		{
+			std::vector<std::thread> threads;
+			threads.reserve(chunks.size());
+
+			for (auto& chunk : chunks)
+			{
+				threads.emplace_back([&function, &chunk]() { function(chunk); });
+			}
+
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+		};
+
+		parallelFor([&](Chunk& chunk)
+		{
+			VertexHashTable table((chunk.End - chunk.Begin) / 4);
+			size_t shapeId = std::upper_bound(shapeOffsets.begin(), shapeOffsets.end(), chunk.Begin) - shapeOffsets.begin() - 1;
+
+			for (size_t i = chunk.Begin; i != chunk.End; ++i)
+			{
+				while (i >= shapeOffsets[shapeId + 1])
+				{
+					++shapeId;
+				}
+
+				const auto vertex = GetObjVertex(objAttrib, shapes[shapeId].mesh, i - shapeOffsets[shapeId]);
+				indices[i] = table.FindOrInsert(vertex, chunk.Vertices);
+			}
+		});
+
+		size_t numberOfChunkVertices = 0;
+
+		for (const auto& chunk : chunks)
+		{
+			numberOfChunkVertices += chunk.Vertices.size();
+		}
+
+		VertexHashTable table(numberOfChunkVertices);
+		vertices.reserve(numberOfChunkVertices);
+
+		for (auto& chunk : chunks)
+		{
+			chunk.Remap.resize(chunk.Vertices.size());
+
+			for (size_t i = 0; i != chunk.Vertices.size(); ++i)
+			{
+				chunk.Remap[i] = table.FindOrInsert(chunk.Vertices[i], vertices);
+			}
+
+			chunk.Vertices = std::vector<Vertex>();
+		}
+
+		vertices.shrink_to_fit();
+
+		parallelFor([&](Chunk& chunk)
+		{
+			for (size_t i = chunk.Begin; i != chunk.End; ++i)
+			{
+				indices[i] = chunk.Remap[indices[i]];
+			}
+		});
+	}
+}
+
+void Model::SetLoaderOptions(const uint32_t numberOfThreads, const bool useCache)
+{
+	loaderThreads = numberOfThreads;
+	useModelCache = useCache;
+}
+
 Model Model::LoadModel(const std::string& filename)
 {
 	std::cout << "- loading '" << filename << "'... " << std::flush;
 
 	const auto timer = std::chrono::high_resolution_clock::now();
+
+	ModelCache::Contents cached;
+
+	if (useModelCache && ModelCache::Load(filename, cached))
+	{
+		const auto elapsed = std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - timer).count();
+
+		std::cout << "(cache hit, " << cached.SourceVertexCount << " vertices, " << cached.Vertices.size() << " unique vertices, " << cached.Materials.size() << " materials) ";
+		std::cout << elapsed << "s" << std::endl;
+
+		return Model(std::move(cached.Vertices), std::move(cached.Indices), std::move(cached.Materials), nullptr);
+	}
+
 	const std::string materialPath = std::filesystem::path(filename).parent_path().string();
 	
 	tinyobj::ObjReader objReader;
@@ -89,56 +418,19 @@ Model Model::LoadModel(const std::string& filename)
 
 	// Geometry
 	const auto& objAttrib = objReader.GetAttrib();
+	const auto& shapes = objReader.GetShapes();
+	const auto numberOfThreads = GetNumberOfLoaderThreads(shapes);
 
 	std::vector<Vertex> vertices;
 	std::vector<uint32_t> indices;
-	std::unordered_map<Vertex, uint32_t> uniqueVertices(objAttrib.vertices.size());
-	size_t faceId = 0;
 
-	for (const auto& shape : objReader.GetShapes())
+	if (numberOfThreads > 1)
 	{
-		const auto& mesh = shape.mesh;
-
-		for (const auto& index : mesh.indices)
-		{
-			Vertex vertex = {};
-
-			vertex.Position =
-			{
-				objAttrib.vertices[3 * index.vertex_index + 0],
-				objAttrib.vertices[3 * index.vertex_index + 1],
-				objAttrib.vertices[3 * index.vertex_index + 2],
-			};
-
-			if (!objAttrib.normals.empty())
-			{
-				vertex.Normal =
-				{
-					objAttrib.normals[3 * index.normal_index + 0],
-					objAttrib.normals[3 * index.normal_index + 1],
-					objAttrib.normals[3 * index.normal_index + 2]
-				};
-			}
-
-			if (!objAttrib.texcoords.empty())
-			{
-				vertex.TexCoord =
-				{
-					objAttrib.texcoords[2 * index.texcoord_index + 0],
-					1 - objAttrib.texcoords[2 * index.texcoord_index + 1]
-				};
-			}
-
-			vertex.MaterialIndex = std::max(0, mesh.material_ids[faceId++ / 3]);
-
-			if (uniqueVertices.count(vertex) == 0)
-			{
-				uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-				vertices.push_back(vertex);
-			}
-
-			indices.push_back(uniqueVertices[vertex]);
-		}
+		DeduplicateVerticesParallel(objAttrib, shapes, numberOfThreads, vertices, indices);
+	}
+	else
+	{
+		DeduplicateVertices(objAttrib, shapes, vertices, indices);
 	}
 
 	// If the model did not specify normals, then create smooth normals that conserve the same number of vertices.
@@ -167,10 +459,27 @@ Model Model::LoadModel(const std::string& filename)
 
 	const auto elapsed = std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - timer).count();
 
-	std::cout << "(" << objAttrib.vertices.size() << " vertices, " << uniqueVertices.size() << " unique vertices, " << materials.size() << " materials) ";
+	std::cout << "(cache miss, " << numberOfThreads << " threads, " << objAttrib.vertices.size() << " vertices, " << vertices.size() << " unique vertices, " << materials.size() << " materials) ";
 	std::cout << elapsed << "s" << std::endl;
 
-	return Model(std::move(vertices), std::move(indices), std::move(materials), nullptr);
+	// Write the cache for the next run.
+	cached.Vertices = std::move(vertices);
+	cached.Indices = std::move(indices);
+	cached.Materials = std::move(materials);
+	cached.SourceVertexCount = objAttrib.vertices.size();
+
+	if (useModelCache)
+	{
+		const auto cacheTimer = std::chrono::high_resolution_clock::now();
+		std::cout << "- writing '" << ModelCache::CachePath(filename) << "'... " << std::flush;
+
+		ModelCache::Save(filename, cached);
+
+		const auto cacheElapsed = std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - cacheTimer).count();
+		std::cout << cacheElapsed << "s" << std::endl;
+	}
+
+	return Model(std::move(cached.Vertices), std::move(cached.Indices), std::move(cached.Materials), nullptr);
 }
 
 Model Model::CreateCornellBox(const float scale)
@@ -243,6 +552,17 @@ Model Model::CreateBox(const vec3& p0, const vec3& p1, const Material& material)
 
 Model Model::CreateSphere(const vec3& center, float radius, const Material& material, const bool isProcedural)
 {
+	// Procedural spheres are only ever intersected analytically, do not bother tessellating them. The raster preview
+	// draws them with a mesh shared by the whole scene (see Scene::ProceduralProxyMesh()).
+	if (isProcedural)
+	{
+		return Model(
+			std::vector<Vertex>(),
+			std::vector<uint32_t>(),
+			std::vector<Material>{material},
+			new Sphere(center, radius));
+	}
+
 	const int slices = 32;
 	const int stacks = 16;
 	
@@ -308,7 +628,7 @@ Model Model::CreateSphere(const vec3& center, float radius, const Material& mate
 		std::move(vertices),
 		std::move(indices),
 		std::vector<Material>{material},
-		isProcedural ? new Sphere(center, radius) : nullptr);
+		nullptr);
 }
 
 void Model::SetMaterial(const Material& material)
@@ -13,6 +13,9 @@ namespace Assets
 	{
 	public:
 
+		// Options for all subsequent LoadModel() calls. Zero threads means one per hardware thread, one thread uses the serial path.
+		static void SetLoaderOptions(uint32_t numberOfThreads, bool useCache);
+
 		static Model LoadModel(const std::string& filename);
 		static Model CreateCornellBox(const float scale);
 		static Model CreateBox(const glm::vec3& p0, const glm::vec3& p1, const Material& material);
@@ -0,0 +1,364 @@
+#include "ModelCache.hpp"
+#include "Utilities/Console.hpp"
+#include "Utilities/MappedFile.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+
+namespace Assets {
+
+namespace
+{
+	// Bump the version whenever the layout of Vertex, Material or the file itself changes.
+	constexpr std::array<char, 8> Magic = { 'M', 'O', 'L', 'M', 'E', 'S', 'H', '\0' };
+	constexpr uint32_t Version = 2;
+	constexpr size_t SectionAlignment = 16;
+
+	struct Header final
+	{
+		std::array<char, 8> Magic;
+		uint32_t Version;
+		uint32_t VertexSize;
+		uint32_t IndexSize;
+		uint32_t MaterialSize;
+		uint64_t SourceSize;
+		int64_t SourceTime;
+		uint64_t SourceHash;
+		uint64_t SourceVertexCount;
+		uint64_t VertexCount;
+		uint64_t IndexCount;
+		uint64_t MaterialCount;
+		uint64_t LibraryCount;
+		uint64_t LibrarySize;
+	};
+
+	// Key of a material library referenced by the model, followed by its PathLength characters.
+	// A library that did not exist when the cache was written has a Size of MissingLibrary.
+	struct LibraryKey final
+	{
+		uint64_t Size;
+		int64_t Time;
+		uint64_t Hash;
+		uint64_t PathLength;
+	};
+
+	constexpr uint64_t MissingLibrary = ~0ull;
+
+	struct Layout final
+	{
+		size_t Vertices;
+		size_t Indices;
+		size_t Materials;
+		size_t Libraries;
+		size_t End;
+	};
+
+	size_t Align(const size_t offset)
+	{
+		return (offset + SectionAlignment - 1) & ~(SectionAlignment - 1);
+	}
+
+	Layout GetLayout(const Header& header)
+	{
+		Layout layout = {};
+		layout.Vertices = Align(sizeof(Header));
+		layout.Indices = Align(layout.Vertices + header.VertexCount * sizeof(Vertex));
+		layout.Materials = Align(layout.Indices + header.IndexCount * sizeof(uint32_t));
+		layout.Libraries = Align(layout.Materials + header.MaterialCount * sizeof(Material));
+		layout.End = layout.Libraries + header.LibrarySize;
+		return layout;
+	}
+
+	// 64-bit FNV-1a.
+	uint64_t Hash(const unsigned char* const data, const size_t size)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+
+		for (size_t i = 0; i != size; ++i)
+		{
+			hash ^= data[i];
+			hash *= 0x100000001b3ull;
+		}
+
+		return hash;
+	}
+
+	bool GetSourceKey(const std::string& filename, uint64_t& size, int64_t& time)
+	{
+		std::error_code error;
+
+		const auto fileSize = std::filesystem::file_size(filename, error);
+		if (error)
+		{
+			return false;
+		}
+
+		const auto writeTime = std::filesystem::last_write_time(filename, error);
+		if (error)
+		{
+			return false;
+		}
+
+		size = static_cast<uint64_t>(fileSize);
+		time = static_cast<int64_t>(writeTime.time_since_epoch().count());
+
+		return true;
+	}
+
+	// Whether the file still matches its key, only hashing it when the time stamp differs.
+	bool IsUpToDate(const std::string& filename, const uint64_t size, const int64_t time, const uint64_t hash)
+	{
+		uint64_t currentSize;
+		int64_t currentTime;
+
+		if (!GetSourceKey(filename, currentSize, currentTime) || currentSize != size)
+		{
+			return false;
+		}
+
+		if (currentTime != time)
+		{
+			const Utilities::MappedFile file(filename);
+
+			return file.IsOpen() && Hash(file.Data(), file.Size()) == hash;
+		}
+
+		return true;
+	}
+
+	// The material libraries (mtllib) referenced by an OBJ file, next to it as tinyobj::ObjReader looks them up.
+	std::vector<std::string> GetMaterialLibraries(const std::string& filename, const unsigned char* const data, const size_t size)
+	{
+		const auto directory = std::filesystem::path(filename).parent_path();
+		const char* const end = reinterpret_cast<const char*>(data) + size;
+		std::vector<std::string> libraries;
+
+		for (const char* line = reinterpret_cast<const char*>(data); line < end; )
+		{
+			const char* const lineEnd = std::find(line, end, '\n');
+			const char* const keyword = std::find_if(line, lineEnd, [](const char c) { return c != ' ' && c != '\t'; });
+
+			// Only the few mtllib lines are tokenized, the model can have millions of lines.
+			if (lineEnd - keyword > 6 && std::strncmp(keyword, "mtllib", 6) == 0 && (keyword[6] == ' ' || keyword[6] == '\t'))
+			{
+				std::istringstream names(std::string(keyword + 6, lineEnd));
+				std::string name;
+
+				while (names >> name)
+				{
+					libraries.push_back((directory / name).string());
+				}
+			}
+
+			line = lineEnd + 1;
+		}
+
+		return libraries;
+	}
+
+	void WriteWarning(const std::string& message)
+	{
+		Utilities::Console::Write(Utilities::Severity::Warning, [&message]()
+		{
+			std::cout << "\nWARNING: " << message << std::flush;
+		});
+	}
+}
+
+std::string ModelCache::CachePath(const std::string& filename)
+{
+	return filename + ".meshcache";
+}
+
+bool ModelCache::Load(const std::string& filename, Contents& contents)
+{
+	const Utilities::MappedFile cache(CachePath(filename));
+
+	if (!cache.IsOpen() || cache.Size() < sizeof(Header))
+	{
+		return false;
+	}
+
+	Header header;
+	std::memcpy(&header, cache.Data(), sizeof(Header));
+
+	if (header.Magic != Magic ||
+		header.Version != Version ||
+		header.VertexSize != sizeof(Vertex) ||
+		header.IndexSize != sizeof(uint32_t) ||
+		header.MaterialSize != sizeof(Material))
+	{
+		return false;
+	}
+
+	// Guard against overflows in the layout computation on corrupted headers.
+	if (header.VertexCount > cache.Size() || header.IndexCount > cache.Size() || header.MaterialCount > cache.Size() || header.LibrarySize > cache.Size())
+	{
+		return false;
+	}
+
+	const auto layout = GetLayout(header);
+
+	if (layout.End > cache.Size())
+	{
+		return false;
+	}
+
+	// A touched but otherwise identical source file is still a hit.
+	if (!IsUpToDate(filename, header.SourceSize, header.SourceTime, header.SourceHash))
+	{
+		return false;
+	}
+
+	// The materials come from the libraries, which can change on their own.
+	size_t offset = layout.Libraries;
+
+	for (uint64_t i = 0; i != header.LibraryCount; ++i)
+	{
+		LibraryKey library;
+
+		if (layout.End - offset < sizeof(LibraryKey))
+		{
+			return false;
+		}
+
+		std::memcpy(&library, cache.Data() + offset, sizeof(LibraryKey));
+		offset += sizeof(LibraryKey);
+
+		if (layout.End - offset < library.PathLength)
+		{
+			return false;
+		}
+
+		const std::string path(reinterpret_cast<const char*>(cache.Data() + offset), static_cast<size_t>(library.PathLength));
+		offset += static_cast<size_t>(library.PathLength);
+
+		const bool isUpToDate = library.Size == MissingLibrary
+			? !std::filesystem::exists(path)
+			: IsUpToDate(path, library.Size, library.Time, library.Hash);
+
+		if (!isUpToDate)
+		{
+			return false;
+		}
+	}
+
+	// Sections are aligned in the file and the mapping is page aligned, so the arrays can be copied as is.
+	const auto* const vertices = reinterpret_cast<const Vertex*>(cache.Data() + layout.Vertices);
+	const auto* const indices = reinterpret_cast<const uint32_t*>(cache.Data() + layout.Indices);
+	const auto* const materials = reinterpret_cast<const Material*>(cache.Data() + layout.Materials);
+
+	contents.Vertices.assign(vertices, vertices + header.VertexCount);
+	contents.Indices.assign(indices, indices + header.IndexCount);
+	contents.Materials.assign(materials, materials + header.MaterialCount);
+	contents.SourceVertexCount = header.SourceVertexCount;
+
+	return true;
+}
+
+void ModelCache::Save(const std::string& filename, const Contents& contents)
+{
+	Header header = {};
+	std::string libraries;
+	header.Magic = Magic;
+	header.Version = Version;
+	header.VertexSize = sizeof(Vertex);
+	header.IndexSize = sizeof(uint32_t);
+	header.MaterialSize = sizeof(Material);
+	header.SourceVertexCount = contents.SourceVertexCount;
+	header.VertexCount = contents.Vertices.size();
+	header.IndexCount = contents.Indices.size();
+	header.MaterialCount = contents.Materials.size();
+
+	if (!GetSourceKey(filename, header.SourceSize, header.SourceTime))
+	{
+		WriteWarning("cannot stat '" + filename + "', skipping mesh cache");
+		return;
+	}
+
+	{
+		const Utilities::MappedFile source(filename);
+
+		if (!source.IsOpen())
+		{
+			WriteWarning("cannot map '" + filename + "', skipping mesh cache");
+			return;
+		}
+
+		header.SourceHash = Hash(source.Data(), source.Size());
+
+		for (const auto& path : GetMaterialLibraries(filename, source.Data(), source.Size()))
+		{
+			LibraryKey library = {};
+			library.Size = MissingLibrary;
+			library.PathLength = path.size();
+
+			if (GetSourceKey(path, library.Size, library.Time))
+			{
+				const Utilities::MappedFile file(path);
+
+				if (!file.IsOpen() && library.Size != 0)
+				{
+					WriteWarning("cannot map '" + path + "', skipping mesh cache");
+					return;
+				}
+
+				library.Hash = Hash(file.Data(), file.Size());
+			}
+
+			libraries.append(reinterpret_cast<const char*>(&library), sizeof(LibraryKey));
+			libraries.append(path);
+			++header.LibraryCount;
+		}
+
+		header.LibrarySize = libraries.size();
+	}
+
+	const auto layout = GetLayout(header);
+	const auto cachePath = CachePath(filename);
+	const auto tempPath = cachePath + ".tmp";
+
+	// Write to a temporary file first so that a concurrent or interrupted run never sees a partial cache.
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+
+		const auto writeAt = [&file](const size_t offset, const void* const data, const size_t size)
+		{
+			const std::array<char, SectionAlignment> padding = {};
+			const auto position = static_cast<size_t>(file.tellp());
+			file.write(padding.data(), static_cast<std::streamsize>(offset - position));
+			file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+		};
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		writeAt(layout.Vertices, contents.Vertices.data(), contents.Vertices.size() * sizeof(Vertex));
+		writeAt(layout.Indices, contents.Indices.data(), contents.Indices.size() * sizeof(uint32_t));
+		writeAt(layout.Materials, contents.Materials.data(), contents.Materials.size() * sizeof(Material));
+		writeAt(layout.Libraries, libraries.data(), libraries.size());
+
+		if (!file)
+		{
+			file.close();
+			std::error_code error;
+			std::filesystem::remove(tempPath, error);
+			WriteWarning("failed to write mesh cache '" + cachePath + "'");
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, cachePath, error);
+
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+		WriteWarning("failed to write mesh cache '" + cachePath + "'");
+	}
+}
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Material.hpp"
+#include "Vertex.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Assets
+{
+	// Versioned binary cache of an already deduplicated OBJ model, stored next to the source file.
+	// The cache is keyed by the source file size, modification time and content hash, and by those of every
+	// material library (mtllib) the source references.
+	class ModelCache final
+	{
+	public:
+
+		struct Contents final
+		{
+			std::vector<Vertex> Vertices;
+			std::vector<uint32_t> Indices;
+			std::vector<Material> Materials;
+			uint64_t SourceVertexCount{};
+		};
+
+		static std::string CachePath(const std::string& filename);
+
+		// Returns false if there is no cache for the given model, or if it is stale or invalid.
+		static bool Load(const std::string& filename, Contents& contents);
+
+		// Failures to write the cache are reported as warnings, the cache is only an optimisation.
+		static void Save(const std::string& filename, const Contents& contents);
+	};
+
+}
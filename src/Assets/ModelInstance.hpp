@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Material.hpp"
+#include "Utilities/Glm.hpp"
+#include <cstdint>
+
+namespace Assets
+{
+	// A placement of one of the scene models. All instances of a model share its geometry and bottom level acceleration structure.
+	struct ModelInstance final
+	{
+		explicit ModelInstance(const uint32_t modelId, const glm::mat4& transform = glm::mat4(1)) :
+			ModelId(modelId),
+			Transform(transform),
+			HasMaterialOverride(false),
+			MaterialOverride{}
+		{
+		}
+
+		ModelInstance(const uint32_t modelId, const glm::mat4& transform, const Material& materialOverride) :
+			ModelId(modelId),
+			Transform(transform),
+			HasMaterialOverride(true),
+			MaterialOverride(materialOverride)
+		{
+		}
+
+		uint32_t ModelId;
+		glm::mat4 Transform;
+
+		// When set, replaces all the materials of the model for this instance.
+		bool HasMaterialOverride;
+		Material MaterialOverride;
+	};
+
+}
@@ -3,101 +3,420 @@
 #include "Sphere.hpp"
 #include "Texture.hpp"
 #include "TextureImage.hpp"
+#include "TextureLoader.hpp"
 #include "Vulkan/BufferUtil.hpp"
 #include "Vulkan/ImageView.hpp"
 #include "Vulkan/Sampler.hpp"
 #include "Utilities/Exception.hpp"
-#include "Vulkan/SingleTimeCommands.hpp"
+#include "Vulkan/UploadBatch.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
 
 
 namespace Assets {
 
-Scene::Scene(Vulkan::CommandPool& commandPool, std::vector<Model>&& models, std::vector<Texture>&& textures) :
+namespace
+{
+	// Matches the ProceduralSphere struct in ProceduralSphere.glsl (std430).
+	struct ProceduralSphere final
+	{
+		glm::vec4 Sphere;
+		uint32_t MaterialIndex;
+		uint32_t Padding[3];
+	};
+
+	static_assert(sizeof(ProceduralSphere) == 32, "ProceduralSphere must match its GLSL std430 layout");
+
+	// Matches the LightTriangle struct in Light.glsl (std430).
+	struct LightTriangle final
+	{
+		glm::vec4 Position0; // w: cumulative area, including this triangle
+		glm::vec4 Edge1;
+		glm::vec4 Edge2;
+		glm::vec4 Emission;
+	};
+
+	static_assert(sizeof(LightTriangle) == 64, "LightTriangle must match its GLSL std430 layout");
+
+	// Upper bound of the staging ring, bigger scenes are uploaded in several submissions.
+	constexpr VkDeviceSize MaxStagingSize = 64 * 1024 * 1024;
+
+	// Staging ring of the textures streamed after the scene creation, at most this much is uploaded per frame.
+	constexpr VkDeviceSize TextureStagingSize = 32 * 1024 * 1024;
+
+	// Spheres stay spheres only under rotations, translations and uniform scaling.
+	Sphere TransformSphere(const Sphere& sphere, const glm::mat4& transform)
+	{
+		const float scaleX = glm::length(glm::vec3(transform[0]));
+		const float scaleY = glm::length(glm::vec3(transform[1]));
+		const float scaleZ = glm::length(glm::vec3(transform[2]));
+		const float tolerance = 1e-4f * scaleX;
+
+		if (std::abs(scaleX - scaleY) > tolerance || std::abs(scaleX - scaleZ) > tolerance)
+		{
+			Throw(std::invalid_argument("procedural sphere instances only support uniform scaling"));
+		}
+
+		return Sphere(glm::vec3(transform * glm::vec4(sphere.Center, 1)), sphere.Radius * scaleX);
+	}
+}
+
+Scene::Scene(Vulkan::CommandPool& commandPool, std::vector<Model>&& models, std::vector<ModelInstance>&& instances, std::vector<Texture>&& textures) :
 	models_(std::move(models)),
+	instances_(std::move(instances)),
 	textures_(std::move(textures))
 {
-	// Concatenate all the models
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
+	// Concatenate all the models, splitting the vertices into positions (the only stream the BLAS builds read),
+	// packed attributes and per primitive materials.
+	std::vector<glm::vec3> positions;
+	std::vector<VertexAttributes> attributes;
+	std::vector<uint32_t> primitiveMaterials;
+	std::vector<uint16_t> indices; // mixed 16 and 32-bit indices
 	std::vector<Material> materials;
-	std::vector<glm::vec4> procedurals;
+	std::vector<ProceduralSphere> procedurals;
 	std::vector<VkAabbPositionsKHR> aabbs;
-	std::vector<glm::uvec2> offsets;
+	std::vector<LightTriangle> lights;
+	std::vector<glm::uvec2> modelOffsets;
+	std::vector<int32_t> modelMaterials;
 
 	for (const auto& model : models_)
 	{
-		// Remember the index, vertex offsets.
-		const auto indexOffset = static_cast<uint32_t>(indices.size());
-		const auto vertexOffset = static_cast<uint32_t>(vertices.size());
+		// Remember the vertex and material offsets.
+		const auto vertexOffset = static_cast<uint32_t>(positions.size());
 		const auto materialOffset = static_cast<uint32_t>(materials.size());
+		const auto primitiveOffset = primitiveMaterials.size();
 
-		offsets.emplace_back(indexOffset, vertexOffset);
+		modelOffsets.emplace_back(vertexOffset, materialOffset);
 
 		// Copy model data one after the other.
-		vertices.insert(vertices.end(), model.Vertices().begin(), model.Vertices().end());
-		indices.insert(indices.end(), model.Indices().begin(), model.Indices().end());
+		for (const auto& vertex : model.Vertices())
+		{
+			positions.push_back(vertex.Position);
+			attributes.push_back(VertexAttributes::Pack(vertex));
+		}
+
+		// Indices are relative to the model vertices, 16 bits are enough for most of them.
+		// 32-bit indices must be 4 bytes aligned, for the BLAS builds as much as for vkCmdBindIndexBuffer().
+		ModelIndices modelIndices = {};
+		modelIndices.FirstPrimitive = static_cast<uint32_t>(primitiveOffset);
+
+		if (model.NumberOfVertices() <= 0x10000)
+		{
+			modelIndices.IndexType = VK_INDEX_TYPE_UINT16;
+			modelIndices.FirstIndex = static_cast<uint32_t>(indices.size());
+
+			for (const auto index : model.Indices())
+			{
+				indices.push_back(static_cast<uint16_t>(index));
+			}
+		}
+		else
+		{
+			indices.resize(indices.size() + indices.size() % 2);
+
+			modelIndices.IndexType = VK_INDEX_TYPE_UINT32;
+			modelIndices.FirstIndex = static_cast<uint32_t>(indices.size() / 2);
+
+			indices.resize(indices.size() + model.Indices().size() * 2);
+			std::memcpy(indices.data() + modelIndices.FirstIndex * 2, model.Indices().data(), model.Indices().size() * sizeof(uint32_t));
+		}
+
+		modelIndices_.push_back(modelIndices);
+
 		materials.insert(materials.end(), model.Materials().begin(), model.Materials().end());
 
-		// Adjust the material id.
-		for (size_t i = vertexOffset; i != vertices.size(); ++i)
+		// The material is per face in the source models, the first vertex of each triangle carries it.
+		for (size_t i = 0; i + 2 < model.Indices().size(); i += 3)
 		{
-			vertices[i].MaterialIndex += materialOffset;
+			primitiveMaterials.push_back(model.Vertices()[model.Indices()[i]].MaterialIndex + materialOffset);
 		}
 
-		// Add optional procedurals.
-		const auto* const sphere = dynamic_cast<const Sphere*>(model.Procedural());
+		// Whether the whole model uses a single material.
+		const bool isUniform = !model.Procedural() && primitiveOffset != primitiveMaterials.size() && std::all_of(primitiveMaterials.begin() + primitiveOffset, primitiveMaterials.end(),
+			[&](const uint32_t material) { return material == primitiveMaterials[primitiveOffset]; });
+
+		modelMaterials.push_back(isUniform ? static_cast<int32_t>(primitiveMaterials[primitiveOffset]) : -1);
+	}
+
+	// A single unit sphere stands in for all the procedural spheres in the raster preview.
+	if (std::any_of(models_.begin(), models_.end(), [](const Model& model) { return model.Procedural() != nullptr; }))
+	{
+		const auto proxy = Model::CreateSphere(glm::vec3(0), 1, Material::Lambertian(glm::vec3(1)), false);
+
+		proxyMesh_.Indices.IndexType = VK_INDEX_TYPE_UINT16;
+		proxyMesh_.Indices.FirstIndex = static_cast<uint32_t>(indices.size());
+		proxyMesh_.Indices.FirstPrimitive = static_cast<uint32_t>(primitiveMaterials.size());
+		proxyMesh_.VertexOffset = static_cast<uint32_t>(positions.size());
+		proxyMesh_.IndexCount = static_cast<uint32_t>(proxy.Indices().size());
+
+		for (const auto& vertex : proxy.Vertices())
+		{
+			positions.push_back(vertex.Position);
+			attributes.push_back(VertexAttributes::Pack(vertex));
+		}
+
+		for (const auto index : proxy.Indices())
+		{
+			indices.push_back(static_cast<uint16_t>(index));
+		}
+	}
+
+	// Whole 32-bit words, for the shaders.
+	indices.resize(indices.size() + indices.size() % 2);
+
+	// Per instance data, indexed by gl_InstanceCustomIndexEXT in the shaders.
+	// x: first index (in units of the model index type), y: vertex offset, z: material override (-1 if none),
+	// w: first primitive in the primitive material buffer, ORed with Index16BitFlag for 16-bit indices.
+	for (const auto& instance : instances_)
+	{
+		if (instance.ModelId >= models_.size())
+		{
+			Throw(std::out_of_range("model instance refers to an unknown model"));
+		}
+
+		int32_t materialOverride = -1;
+
+		if (instance.HasMaterialOverride)
+		{
+			materialOverride = static_cast<int32_t>(materials.size());
+			materials.push_back(instance.MaterialOverride);
+		}
+
+		const auto& offsets = modelOffsets[instance.ModelId];
+		const auto& modelIndices = modelIndices_[instance.ModelId];
+		const auto primitiveFlags = modelIndices.IndexType == VK_INDEX_TYPE_UINT16 ? Index16BitFlag : 0;
+		instanceOffsets_.emplace_back(modelIndices.FirstIndex, offsets.x, static_cast<uint32_t>(materialOverride), modelIndices.FirstPrimitive | primitiveFlags);
+		instanceMaterials_.push_back(models_[instance.ModelId].Procedural() ? -1 : materialOverride >= 0 ? materialOverride : modelMaterials[instance.ModelId]);
+
+		// All procedural instances are flattened into a single list of primitives, indexed by gl_PrimitiveID in the shaders.
+		const auto* const sphere = dynamic_cast<const Sphere*>(models_[instance.ModelId].Procedural());
 		if (sphere != nullptr)
 		{
-			const auto aabb = sphere->BoundingBox();
+			const auto transformed = TransformSphere(*sphere, instance.Transform);
+			const auto materialIndex = materialOverride >= 0 ? static_cast<uint32_t>(materialOverride) : offsets.y;
+			const auto aabb = transformed.BoundingBox();
+
 			aabbs.push_back({aabb.first.x, aabb.first.y, aabb.first.z, aabb.second.x, aabb.second.y, aabb.second.z});
-			procedurals.emplace_back(sphere->Center, sphere->Radius);
+			procedurals.push_back({glm::vec4(transformed.Center, transformed.Radius), materialIndex, {}});
+			proceduralProxies_.push_back({glm::scale(glm::translate(glm::mat4(1), transformed.Center), glm::vec3(transformed.Radius)), materialIndex});
 		}
-		else
+
+		// Flatten the emissive triangles into world space. Procedural lights are only found by BSDF sampling.
+		const auto& model = models_[instance.ModelId];
+
+		for (size_t i = 0; i + 2 < model.Indices().size(); i += 3)
 		{
-			aabbs.emplace_back();
-			procedurals.emplace_back();
+			const auto& material = materials[materialOverride >= 0 ? static_cast<uint32_t>(materialOverride) : primitiveMaterials[modelIndices.FirstPrimitive + i / 3]];
+
+			if (material.MaterialModel != Material::Enum::DiffuseLight)
+			{
+				continue;
+			}
+
+			const glm::vec3 p0 = instance.Transform * glm::vec4(positions[offsets.x + model.Indices()[i + 0]], 1);
+			const glm::vec3 p1 = instance.Transform * glm::vec4(positions[offsets.x + model.Indices()[i + 1]], 1);
+			const glm::vec3 p2 = instance.Transform * glm::vec4(positions[offsets.x + model.Indices()[i + 2]], 1);
+			const float area = 0.5f * glm::length(glm::cross(p1 - p0, p2 - p0));
+
+			if (area <= 0)
+			{
+				continue;
+			}
+
+			totalLightArea_ += area;
+			lights.push_back({glm::vec4(p0, totalLightArea_), glm::vec4(p1 - p0, 0), glm::vec4(p2 - p0, 0), glm::vec4(glm::vec3(material.Diffuse), 0)});
 		}
 	}
 
+	numberOfLights_ = static_cast<uint32_t>(lights.size());
+
+	if (lights.empty())
+	{
+		lights.push_back({});
+	}
+
+	// Record all the uploads into a single batch, sized to fit the whole scene if it is small enough.
+	const auto& device = commandPool.Device();
+	const auto sizeOf = [](const auto& content) { return static_cast<VkDeviceSize>(sizeof(content[0]) * content.size()) + 16; };
+
+	VkDeviceSize uploadSize = sizeOf(positions) + sizeOf(attributes) + sizeOf(primitiveMaterials) + sizeOf(indices) + sizeOf(materials) + sizeOf(instanceOffsets_) + sizeOf(aabbs) + sizeOf(procedurals) + sizeOf(lights);
+
+	for (const auto& texture : textures_)
+	{
+		uploadSize += texture.IsLoaded() ? static_cast<VkDeviceSize>(texture.Width()) * texture.Height() * 4 + 16 : 0;
+	}
+
+	uploadBatch_.reset(new Vulkan::UploadBatch(commandPool, std::min(uploadSize, MaxStagingSize)));
+
 	constexpr auto flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
 
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Vertices", VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, vertices, vertexBuffer_, vertexBufferMemory_);
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Indices", VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, indices, indexBuffer_, indexBufferMemory_);
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Materials", flags, materials, materialBuffer_, materialBufferMemory_);
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Offsets", flags, offsets, offsetBuffer_, offsetBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(*uploadBatch_, device, "Vertices", VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, positions, vertexBuffer_, vertexBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(*uploadBatch_, device, "VertexAttributes", VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | flags, attributes, vertexAttributeBuffer_, vertexAttributeBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(*uploadBatch_, device, "Indices", VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, indices, indexBuffer_, indexBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(*uploadBatch_, device, "Materials", flags, materials, materialBuffer_, materialBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(*uploadBatch_, device, "PrimitiveMaterials", flags, primitiveMaterials, primitiveMaterialBuffer_, primitiveMaterialBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(*uploadBatch_, device, "Offsets", flags, instanceOffsets_, offsetBuffer_, offsetBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(*uploadBatch_, device, "Lights", flags, lights, lightBuffer_, lightBufferMemory_);
+
+	if (!procedurals.empty())
+	{
+		Vulkan::BufferUtil::CreateDeviceBuffer(*uploadBatch_, device, "AABBs", VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, aabbs, aabbBuffer_, aabbBufferMemory_);
+		Vulkan::BufferUtil::CreateDeviceBuffer(*uploadBatch_, device, "Procedurals", flags, procedurals, proceduralBuffer_, proceduralBufferMemory_);
+	}
+
+	numberOfProcedurals_ = static_cast<uint32_t>(procedurals.size());
+	materials_ = std::move(materials);
 
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "AABBs", VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, aabbs, aabbBuffer_, aabbBufferMemory_);
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Procedurals", flags, procedurals, proceduralBuffer_, proceduralBufferMemory_);
+	// Upload the textures already in memory. The others are bound to a placeholder until their file has been decoded
+	// and uploaded in the background (see UpdateTextures()).
+	std::vector<std::pair<size_t, Texture>> deferredTextures;
 
-	
-	// Upload all textures
-	textureImages_.reserve(textures_.size());
+	textureImages_.resize(textures_.size());
 	textureImageViewHandles_.resize(textures_.size());
 	textureSamplerHandles_.resize(textures_.size());
 
 	for (size_t i = 0; i != textures_.size(); ++i)
 	{
-	   textureImages_.emplace_back(new TextureImage(commandPool, textures_[i]));
-	   textureImageViewHandles_[i] = textureImages_[i]->ImageView().Handle();
-	   textureSamplerHandles_[i] = textureImages_[i]->Sampler().Handle();
+		if (!textures_[i].IsLoaded())
+		{
+			if (!placeholderImage_)
+			{
+				placeholderImage_.reset(new TextureImage(*uploadBatch_, device, Texture::Placeholder()));
+			}
+
+			textureImageViewHandles_[i] = placeholderImage_->ImageView().Handle();
+			textureSamplerHandles_[i] = placeholderImage_->Sampler().Handle();
+			deferredTextures.emplace_back(i, Texture::FromFile(textures_[i].Filename(), textures_[i].SamplerConfig()));
+			continue;
+		}
+
+		textureImages_[i].reset(new TextureImage(*uploadBatch_, device, textures_[i]));
+		textureImageViewHandles_[i] = textureImages_[i]->ImageView().Handle();
+		textureSamplerHandles_[i] = textureImages_[i]->Sampler().Handle();
+	}
+
+	if (!deferredTextures.empty())
+	{
+		textureLoader_.reset(new TextureLoader(std::move(deferredTextures)));
+		textureUploadBatch_.reset(new Vulkan::UploadBatch(commandPool, TextureStagingSize));
+	}
+
+	// Submit without waiting, work later submitted on the same queue is ordered after the uploads.
+	uploadBatch_->Submit();
+}
+
+bool Scene::IsUploadComplete() const
+{
+	return !uploadBatch_ || uploadBatch_->IsComplete();
+}
+
+void Scene::WaitForUpload()
+{
+	uploadBatch_.reset();
+}
+
+bool Scene::UpdateTextures()
+{
+	// Only one upload in flight, poll it without blocking.
+	if (!textureLoader_ || !textureUploadBatch_->IsComplete())
+	{
+		return false;
+	}
+
+	const bool updated = !uploadingTextures_.empty();
+
+	for (auto& uploaded : uploadingTextures_)
+	{
+		const auto i = uploaded.first;
+
+		textureImages_[i] = std::move(uploaded.second);
+		textureImageViewHandles_[i] = textureImages_[i]->ImageView().Handle();
+		textureSamplerHandles_[i] = textureImages_[i]->Sampler().Handle();
+	}
+
+	uploadingTextures_.clear();
+	textureUploadBatch_->Wait(); // already complete, only recycles the staging ring
+
+	// Stage the decoded textures that fit in the ring, filling it up would block until the GPU catches up.
+	for (auto& texture : textureLoader_->TakeDecoded())
+	{
+		decodedTextures_.push_back(std::move(texture));
+	}
+
+	const auto& device = textureUploadBatch_->Device();
+	VkDeviceSize stagedSize = 0;
+	size_t staged = 0;
+
+	for (; staged != decodedTextures_.size(); ++staged)
+	{
+		const auto& texture = decodedTextures_[staged];
+		const auto size = static_cast<VkDeviceSize>(texture.second.Width()) * texture.second.Height() * 4;
+
+		if (stagedSize != 0 && stagedSize + size > TextureStagingSize)
+		{
+			break;
+		}
+
+		uploadingTextures_.emplace_back(texture.first, std::unique_ptr<TextureImage>(new TextureImage(*textureUploadBatch_, device, texture.second)));
+		stagedSize += size;
+	}
+
+	decodedTextures_.erase(decodedTextures_.begin(), decodedTextures_.begin() + staged);
+	textureUploadBatch_->Submit();
+
+	// The placeholder is kept, descriptors still in use may refer to it until the caller rebinds them.
+	if (textureLoader_->IsDone() && decodedTextures_.empty() && uploadingTextures_.empty())
+	{
+		textureLoader_.reset();
+		textureUploadBatch_.reset();
+	}
+
+	return updated;
+}
+
+void Scene::WaitForTextures()
+{
+	while (textureLoader_)
+	{
+		textureUploadBatch_->Wait();
+
+		if (!UpdateTextures())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
 	}
 }
 
 Scene::~Scene()
 {
+	uploadBatch_.reset(); // waits for any pending upload
+	textureLoader_.reset();
+	textureUploadBatch_.reset(); // waits for any pending texture upload
+	uploadingTextures_.clear();
+	decodedTextures_.clear();
 	textureSamplerHandles_.clear();
 	textureImageViewHandles_.clear();
 	textureImages_.clear();
+	placeholderImage_.reset();
+	lightBuffer_.reset();
+	lightBufferMemory_.reset(); // release memory after bound buffer has been destroyed
 	proceduralBuffer_.reset();
 	proceduralBufferMemory_.reset(); // release memory after bound buffer has been destroyed
 	aabbBuffer_.reset();
 	aabbBufferMemory_.reset(); // release memory after bound buffer has been destroyed
 	offsetBuffer_.reset();
 	offsetBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+	primitiveMaterialBuffer_.reset();
+	primitiveMaterialBufferMemory_.reset(); // release memory after bound buffer has been destroyed
 	materialBuffer_.reset();
 	materialBufferMemory_.reset(); // release memory after bound buffer has been destroyed
 	indexBuffer_.reset();
 	indexBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+	vertexAttributeBuffer_.reset();
+	vertexAttributeBufferMemory_.reset(); // release memory after bound buffer has been destroyed
 	vertexBuffer_.reset();
 	vertexBufferMemory_.reset(); // release memory after bound buffer has been destroyed
 }
@@ -1,7 +1,11 @@
 #pragma once
 
+#include "Material.hpp"
+#include "ModelInstance.hpp"
+#include "Utilities/Glm.hpp"
 #include "Vulkan/Vulkan.hpp"
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace Vulkan
@@ -10,6 +14,7 @@ namespace Vulkan
 	class CommandPool;
 	class DeviceMemory;
 	class Image;
+	class UploadBatch;
 }
 
 namespace Assets
@@ -17,45 +22,140 @@ namespace Assets
 	class Model;
 	class Texture;
 	class TextureImage;
+	class TextureLoader;
 
 	class Scene final
 	{
 	public:
 
+		// Where the triangles of a model are in the index and primitive material buffers. The index buffer mixes widths,
+		// models with few enough vertices get 16-bit indices.
+		struct ModelIndices final
+		{
+			VkIndexType IndexType;
+			uint32_t FirstIndex; // in units of the index type
+			uint32_t FirstPrimitive;
+
+			VkDeviceSize ByteOffset() const { return static_cast<VkDeviceSize>(FirstIndex) * (IndexType == VK_INDEX_TYPE_UINT16 ? 2 : 4); }
+		};
+
+		// The unit sphere mesh the rasterizer draws in place of every procedural sphere, uploaded once per scene after all
+		// the models. It has no primitive materials and is never traced.
+		struct ProxyMesh final
+		{
+			ModelIndices Indices;
+			uint32_t VertexOffset;
+			uint32_t IndexCount;
+		};
+
+		// Placement of the proxy mesh and material of a procedural sphere, in the order of the procedural buffer.
+		struct ProceduralProxy final
+		{
+			glm::mat4 Transform;
+			uint32_t MaterialIndex;
+		};
+
+		// Set in the w component of the instance offsets for 16-bit indices, along with the first primitive.
+		static constexpr uint32_t Index16BitFlag = 0x80000000u;
+
 		Scene(const Scene&) = delete;
 		Scene(Scene&&) = delete;
 		Scene& operator = (const Scene&) = delete;
 		Scene& operator = (Scene&&) = delete;
 
-		Scene(Vulkan::CommandPool& commandPool, std::vector<Model>&& models, std::vector<Texture>&& textures);
+		Scene(Vulkan::CommandPool& commandPool, std::vector<Model>&& models, std::vector<ModelInstance>&& instances, std::vector<Texture>&& textures);
 		~Scene();
 
+		// The constructor submits all the uploads without waiting for them, which is fine for anything
+		// submitted afterwards on the same queue. Waiting releases the staging memory.
+		bool IsUploadComplete() const;
+		void WaitForUpload();
+
+		// Textures given as files (see Texture::FromFile()) are decoded in the background and bound to a placeholder
+		// meanwhile. Polled once per frame, uploads the newly decoded textures and returns true when some of the
+		// texture image views and samplers have changed; descriptors referring to them then have to be rebound.
+		bool UpdateTextures();
+		bool IsTextureLoadComplete() const { return !textureLoader_; }
+
+		// Blocks until all the textures are loaded, for renders that must not see placeholders.
+		void WaitForTextures();
+
 		const std::vector<Model>& Models() const { return models_; }
+		const std::vector<ModelInstance>& Instances() const { return instances_; }
+
+		// Host copy of the per instance offsets buffer, see Scene::Scene().
+		const std::vector<glm::uvec4>& InstanceOffsets() const { return instanceOffsets_; }
+
+		// One entry per model, procedural models included (without any index).
+		const std::vector<ModelIndices>& ModelIndexRanges() const { return modelIndices_; }
+
+		// Host copy of the material buffer.
+		const std::vector<Material>& Materials() const { return materials_; }
+
+		// Material index of each instance whose triangles all share the same material, -1 otherwise (always for procedurals).
+		const std::vector<int32_t>& InstanceMaterials() const { return instanceMaterials_; }
+
 		bool HasProcedurals() const { return static_cast<bool>(proceduralBuffer_); }
 
+		// All procedural instances share a single AABB geometry, one primitive each.
+		uint32_t NumberOfProcedurals() const { return numberOfProcedurals_; }
+
+		// Only valid with HasProcedurals().
+		const ProxyMesh& ProceduralProxyMesh() const { return proxyMesh_; }
+		const std::vector<ProceduralProxy>& ProceduralProxies() const { return proceduralProxies_; }
+
+		// World space triangles with a DiffuseLight material, sampled proportionally to their area by next event estimation.
+		// The light buffer is never empty, a scene without lights gets a single zero area entry.
+		uint32_t NumberOfLights() const { return numberOfLights_; }
+		float TotalLightArea() const { return totalLightArea_; }
+
+		// Tightly packed float3 positions, the vertex buffer of the BLAS builds.
 		const Vulkan::Buffer& VertexBuffer() const { return *vertexBuffer_; }
+		// Normals and texture coordinates of each vertex, see VertexAttributes.
+		const Vulkan::Buffer& VertexAttributeBuffer() const { return *vertexAttributeBuffer_; }
+		// 16 and 32-bit indices, see ModelIndexRanges(). Shaders read it as 32-bit words.
 		const Vulkan::Buffer& IndexBuffer() const { return *indexBuffer_; }
 		const Vulkan::Buffer& MaterialBuffer() const { return *materialBuffer_; }
+		// Material index of each triangle, indexed by the index offset / 3 + gl_PrimitiveID.
+		const Vulkan::Buffer& PrimitiveMaterialBuffer() const { return *primitiveMaterialBuffer_; }
 		const Vulkan::Buffer& OffsetsBuffer() const { return *offsetBuffer_; }
 		const Vulkan::Buffer& AabbBuffer() const { return *aabbBuffer_; }
 		const Vulkan::Buffer& ProceduralBuffer() const { return *proceduralBuffer_; }
+		const Vulkan::Buffer& LightBuffer() const { return *lightBuffer_; }
 		const std::vector<VkImageView> TextureImageViews() const { return textureImageViewHandles_; }
 		const std::vector<VkSampler> TextureSamplers() const { return textureSamplerHandles_; }
 
 	private:
 
 		const std::vector<Model> models_;
+		const std::vector<ModelInstance> instances_;
 		const std::vector<Texture> textures_;
 
+		std::vector<glm::uvec4> instanceOffsets_;
+		std::vector<ModelIndices> modelIndices_;
+		std::vector<Material> materials_;
+		std::vector<int32_t> instanceMaterials_;
+		uint32_t numberOfProcedurals_{};
+		ProxyMesh proxyMesh_{};
+		std::vector<ProceduralProxy> proceduralProxies_;
+		uint32_t numberOfLights_{};
+		float totalLightArea_{};
+
 		std::unique_ptr<Vulkan::Buffer> vertexBuffer_;
 		std::unique_ptr<Vulkan::DeviceMemory> vertexBufferMemory_;
 
+		std::unique_ptr<Vulkan::Buffer> vertexAttributeBuffer_;
+		std::unique_ptr<Vulkan::DeviceMemory> vertexAttributeBufferMemory_;
+
 		std::unique_ptr<Vulkan::Buffer> indexBuffer_;
 		std::unique_ptr<Vulkan::DeviceMemory> indexBufferMemory_;
 
 		std::unique_ptr<Vulkan::Buffer> materialBuffer_;
 		std::unique_ptr<Vulkan::DeviceMemory> materialBufferMemory_;
 
+		std::unique_ptr<Vulkan::Buffer> primitiveMaterialBuffer_;
+		std::unique_ptr<Vulkan::DeviceMemory> primitiveMaterialBufferMemory_;
+
 		std::unique_ptr<Vulkan::Buffer> offsetBuffer_;
 		std::unique_ptr<Vulkan::DeviceMemory> offsetBufferMemory_;
 
@@ -65,6 +165,17 @@ namespace Assets
 		std::unique_ptr<Vulkan::Buffer> proceduralBuffer_;
 		std::unique_ptr<Vulkan::DeviceMemory> proceduralBufferMemory_;
 
+		std::unique_ptr<Vulkan::Buffer> lightBuffer_;
+		std::unique_ptr<Vulkan::DeviceMemory> lightBufferMemory_;
+
+		std::unique_ptr<Vulkan::UploadBatch> uploadBatch_;
+
+		std::unique_ptr<TextureImage> placeholderImage_;
+		std::unique_ptr<TextureLoader> textureLoader_;
+		std::unique_ptr<Vulkan::UploadBatch> textureUploadBatch_;
+		std::vector<std::pair<size_t, Texture>> decodedTextures_;
+		std::vector<std::pair<size_t, std::unique_ptr<TextureImage>>> uploadingTextures_;
+
 		std::vector<std::unique_ptr<TextureImage>> textureImages_;
 		std::vector<VkImageView> textureImageViewHandles_;
 		std::vector<VkSampler> textureSamplerHandles_;
@@ -1,14 +1,15 @@
 #include "Texture.hpp"
 #include "Utilities/StbImage.hpp"
 #include "Utilities/Exception.hpp"
+#include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <sstream>
 
 namespace Assets {
 
 Texture Texture::LoadTexture(const std::string& filename, const Vulkan::SamplerConfig& samplerConfig)
 {
-	std::cout << "- loading '" << filename << "'... " << std::flush;
 	const auto timer = std::chrono::high_resolution_clock::now();
 
 	// Load the texture in normal host memory.
@@ -21,17 +22,47 @@ Texture Texture::LoadTexture(const std::string& filename, const Vulkan::SamplerC
 	}
 
 	const auto elapsed = std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - timer).count();
-	std::cout << "(" << width << " x " << height << " x " << channels << ") ";
-	std::cout << elapsed << "s" << std::endl;
 
-	return Texture(width, height, channels, pixels);
+	// A single write, textures are decoded by several threads at once (see TextureLoader).
+	std::ostringstream message;
+	message << "- loaded '" << filename << "' (" << width << " x " << height << " x " << channels << ") " << elapsed << "s\n";
+	std::cout << message.str() << std::flush;
+
+	Texture texture(width, height, channels, pixels, stbi_image_free);
+	texture.filename_ = filename;
+	texture.samplerConfig_ = samplerConfig;
+
+	return texture;
+}
+
+Texture Texture::FromFile(const std::string& filename, const Vulkan::SamplerConfig& samplerConfig)
+{
+	Texture texture;
+	texture.filename_ = filename;
+	texture.samplerConfig_ = samplerConfig;
+
+	return texture;
+}
+
+Texture Texture::Placeholder()
+{
+	auto* const pixels = static_cast<unsigned char*>(std::malloc(4));
+
+	if (pixels == nullptr)
+	{
+		Throw(std::bad_alloc());
+	}
+
+	std::fill(pixels, pixels + 4, static_cast<unsigned char>(255));
+
+	return Texture(1, 1, 4, pixels, std::free);
 }
 
-Texture::Texture(int width, int height, int channels, unsigned char* const pixels) :
+Texture::Texture(int width, int height, int channels, unsigned char* const pixels, void (*deleter) (void*)) :
 	width_(width),
 	height_(height),
 	channels_(channels),
-	pixels_(pixels, stbi_image_free)
+	pixels_(pixels, deleter)
 {
 }
 	
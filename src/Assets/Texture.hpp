@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Vulkan/Sampler.hpp"
+#include <cstdlib>
 #include <memory>
 #include <string>
 
@@ -12,6 +13,12 @@ namespace Assets
 
 		static Texture LoadTexture(const std::string& filename, const Vulkan::SamplerConfig& samplerConfig);
 
+		// Only records the file, the pixels are decoded later by a TextureLoader while the scene renders with a placeholder.
+		static Texture FromFile(const std::string& filename, const Vulkan::SamplerConfig& samplerConfig);
+
+		// A single white texel, the neutral texture until the real one is loaded.
+		static Texture Placeholder();
+
 		Texture& operator = (const Texture&) = delete;
 		Texture& operator = (Texture&&) = delete;
 
@@ -20,19 +27,23 @@ namespace Assets
 		Texture(Texture&&) = default;
 		~Texture() = default;
 
+		bool IsLoaded() const { return static_cast<bool>(pixels_); }
+		const std::string& Filename() const { return filename_; }
+		const Vulkan::SamplerConfig& SamplerConfig() const { return samplerConfig_; }
 		const unsigned char* Pixels() const { return pixels_.get(); }
 		int Width() const { return width_; }
 		int Height() const { return height_; }
 
 	private:
 
-		Texture(int width, int height, int channels, unsigned char* pixels);
+		Texture(int width, int height, int channels, unsigned char* pixels, void (*deleter) (void*));
 
+		std::string filename_;
 		Vulkan::SamplerConfig samplerConfig_;
-		int width_;
-		int height_;
-		int channels_;
-		std::unique_ptr<unsigned char, void (*) (void*)> pixels_;
+		int width_{};
+		int height_{};
+		int channels_{};
+		std::unique_ptr<unsigned char, void (*) (void*)> pixels_{ nullptr, std::free };
 	};
 
 }
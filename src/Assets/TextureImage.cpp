@@ -1,40 +1,33 @@
 #include "TextureImage.hpp"
 #include "Texture.hpp"
-#include "Vulkan/Buffer.hpp"
-#include "Vulkan/CommandPool.hpp"
+#include "Vulkan/DeviceMemory.hpp"
 #include "Vulkan/ImageView.hpp"
 #include "Vulkan/Image.hpp"
 #include "Vulkan/Sampler.hpp"
-#include <cstring>
+#include "Vulkan/UploadBatch.hpp"
 
 namespace Assets {
 
-TextureImage::TextureImage(Vulkan::CommandPool& commandPool, const Texture& texture)
+TextureImage::TextureImage(Vulkan::UploadBatch& uploadBatch, const Vulkan::Device& device, const Texture& texture)
 {
-	// Create a host staging buffer and copy the image into it.
 	const VkDeviceSize imageSize = texture.Width() * texture.Height() * 4;
-	const auto& device = commandPool.Device();
+	const VkExtent2D extent = { static_cast<uint32_t>(texture.Width()), static_cast<uint32_t>(texture.Height()) };
+	const uint32_t mipLevels = Vulkan::Image::MipLevelCount(extent);
 
-	auto stagingBuffer = std::make_unique<Vulkan::Buffer>(device, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-	auto stagingBufferMemory = stagingBuffer->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	const auto data = stagingBufferMemory.Map(0, imageSize);
-	std::memcpy(data, texture.Pixels(), imageSize);
-	stagingBufferMemory.Unmap();
-
-	// Create the device side image, memory, view and sampler.
-	image_.reset(new Vulkan::Image(device, VkExtent2D{ static_cast<uint32_t>(texture.Width()), static_cast<uint32_t>(texture.Height()) }, VK_FORMAT_R8G8B8A8_UNORM));
+	// Create the device side image, memory, view and sampler, with a full mip chain.
+	image_.reset(new Vulkan::Image(device, extent, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, mipLevels));
 	imageMemory_.reset(new Vulkan::DeviceMemory(image_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
-	imageView_.reset(new Vulkan::ImageView(device, image_->Handle(), image_->Format(), VK_IMAGE_ASPECT_COLOR_BIT));
-	sampler_.reset(new Vulkan::Sampler(device, Vulkan::SamplerConfig()));
+	imageView_.reset(new Vulkan::ImageView(device, image_->Handle(), image_->Format(), VK_IMAGE_ASPECT_COLOR_BIT, mipLevels));
 
-	// Transfer the data to device side.
-	image_->TransitionImageLayout(commandPool, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-	image_->CopyFrom(commandPool, *stagingBuffer);
-	image_->TransitionImageLayout(commandPool, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	Vulkan::SamplerConfig samplerConfig;
+	samplerConfig.MaxLod = static_cast<float>(mipLevels);
+	sampler_.reset(new Vulkan::Sampler(device, samplerConfig));
 
-	// Delete the buffer before the memory
-	stagingBuffer.reset();
+	// Record the transfer to device side, the other levels are downsampled from the first one on the GPU.
+	uploadBatch.TransitionImageLayout(*image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	uploadBatch.CopyToImage(texture.Pixels(), imageSize, *image_);
+	uploadBatch.GenerateMipmaps(*image_);
 }
 
 TextureImage::~TextureImage()
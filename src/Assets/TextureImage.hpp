@@ -4,11 +4,12 @@
 
 namespace Vulkan
 {
-	class CommandPool;
+	class Device;
 	class DeviceMemory;
 	class Image;
 	class ImageView;
 	class Sampler;
+	class UploadBatch;
 }
 
 namespace Assets
@@ -24,7 +25,8 @@ namespace Assets
 		TextureImage& operator = (const TextureImage&) = delete;
 		TextureImage& operator = (TextureImage&&) = delete;
 
-		TextureImage(Vulkan::CommandPool& commandPool, const Texture& texture);
+		// The pixels are copied into the batch staging memory, the texture can be released once this returns.
+		TextureImage(Vulkan::UploadBatch& uploadBatch, const Vulkan::Device& device, const Texture& texture);
 		~TextureImage();
 
 		const Vulkan::ImageView& ImageView() const { return *imageView_; }
@@ -0,0 +1,85 @@
+#include "TextureLoader.hpp"
+#include <algorithm>
+
+namespace Assets {
+
+namespace
+{
+	uint32_t loaderThreads = 0;
+}
+
+void TextureLoader::SetNumberOfThreads(const uint32_t numberOfThreads)
+{
+	loaderThreads = numberOfThreads;
+}
+
+TextureLoader::TextureLoader(std::vector<std::pair<size_t, Texture>>&& textures) :
+	textures_(std::move(textures))
+{
+	const size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	const size_t requestedThreads = loaderThreads != 0 ? loaderThreads : hardwareThreads;
+
+	for (size_t i = 0; i != std::min(requestedThreads, textures_.size()); ++i)
+	{
+		threads_.emplace_back(&TextureLoader::Decode, this);
+	}
+}
+
+TextureLoader::~TextureLoader()
+{
+	cancelled_ = true;
+
+	for (auto& thread : threads_)
+	{
+		thread.join();
+	}
+}
+
+std::vector<std::pair<size_t, Texture>> TextureLoader::TakeDecoded()
+{
+	std::vector<std::pair<size_t, Texture>> decoded;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		if (error_)
+		{
+			std::rethrow_exception(error_);
+		}
+
+		decoded.swap(decoded_);
+		taken_ += decoded.size();
+	}
+
+	return decoded;
+}
+
+bool TextureLoader::IsDone() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return taken_ == textures_.size();
+}
+
+void TextureLoader::Decode()
+{
+	for (size_t i = next_++; i < textures_.size() && !cancelled_; i = next_++)
+	{
+		const auto& texture = textures_[i].second;
+
+		try
+		{
+			auto loaded = Texture::LoadTexture(texture.Filename(), texture.SamplerConfig());
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			decoded_.emplace_back(textures_[i].first, std::move(loaded));
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			error_ = std::current_exception();
+			return;
+		}
+	}
+}
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Texture.hpp"
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Assets
+{
+	// Decodes texture files on a pool of worker threads, in the order given. The decoded textures are collected by the
+	// owner thread, which uploads them at its own pace (see Scene::UpdateTextures()).
+	class TextureLoader final
+	{
+	public:
+
+		TextureLoader(const TextureLoader&) = delete;
+		TextureLoader(TextureLoader&&) = delete;
+		TextureLoader& operator = (const TextureLoader&) = delete;
+		TextureLoader& operator = (TextureLoader&&) = delete;
+
+		// The number of worker threads, 0 for one per hardware thread.
+		static void SetNumberOfThreads(uint32_t numberOfThreads);
+
+		// Index of each texture to load (e.g. its descriptor index) and its file.
+		explicit TextureLoader(std::vector<std::pair<size_t, Texture>>&& textures);
+
+		// Textures not yet started are abandoned, the ones being decoded are finished first.
+		~TextureLoader();
+
+		// Textures decoded since the last call. A failure of any worker is rethrown here.
+		std::vector<std::pair<size_t, Texture>> TakeDecoded();
+
+		// Whether all the textures have been decoded and taken.
+		bool IsDone() const;
+
+	private:
+
+		void Decode();
+
+		std::vector<std::pair<size_t, Texture>> textures_;
+		std::atomic<size_t> next_{};
+		std::atomic<bool> cancelled_{};
+
+		mutable std::mutex mutex_;
+		std::vector<std::pair<size_t, Texture>> decoded_;
+		size_t taken_{};
+		std::exception_ptr error_;
+
+		std::vector<std::thread> threads_;
+	};
+
+}
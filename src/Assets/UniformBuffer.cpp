@@ -1,34 +1,39 @@
 #include "UniformBuffer.hpp"
 #include "Vulkan/Buffer.hpp"
+#include "Vulkan/Device.hpp"
 #include <cstring>
 
 namespace Assets {
 
-UniformBuffer::UniformBuffer(const Vulkan::Device& device)
+UniformBuffer::UniformBuffer(const Vulkan::Device& device, const size_t sliceCount) :
+	sliceCount_(sliceCount)
 {
-	const auto bufferSize = sizeof(UniformBufferObject);
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device.PhysicalDevice(), &properties);
+
+	// Dynamic offsets must be multiples of minUniformBufferOffsetAlignment, which is a power of two.
+	const auto alignment = properties.limits.minUniformBufferOffsetAlignment;
+	sliceStride_ = (sizeof(UniformBufferObject) + alignment - 1) & ~(alignment - 1);
+
+	const auto bufferSize = sliceStride_ * sliceCount;
 
 	buffer_.reset(new Vulkan::Buffer(device, bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT));
 	memory_.reset(new Vulkan::DeviceMemory(buffer_->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)));
-}
 
-UniformBuffer::UniformBuffer(UniformBuffer&& other) noexcept :
-	buffer_(other.buffer_.release()),
-	memory_(other.memory_.release())
-{
+	// Host visible pool blocks are persistently mapped, so this is just pointer arithmetic.
+	mappedData_ = memory_->Map(0, bufferSize);
 }
 
 UniformBuffer::~UniformBuffer()
 {
+	memory_->Unmap();
 	buffer_.reset();
 	memory_.reset(); // release memory after bound buffer has been destroyed
 }
 
-void UniformBuffer::SetValue(const UniformBufferObject& ubo)
+void UniformBuffer::SetValue(const size_t slice, const UniformBufferObject& ubo)
 {
-	const auto data = memory_->Map(0, sizeof(UniformBufferObject));
-	std::memcpy(data, &ubo, sizeof(ubo));
-	memory_->Unmap();
+	std::memcpy(static_cast<char*>(mappedData_) + SliceOffset(slice), &ubo, sizeof(ubo));
 }
 
 }
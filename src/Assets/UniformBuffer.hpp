@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Utilities/Glm.hpp"
+#include "Vulkan/Vulkan.hpp"
 #include <memory>
 
 namespace Vulkan
@@ -20,37 +21,58 @@ namespace Assets
 		glm::mat4 Projection;
 		glm::mat4 ModelViewInverse;
 		glm::mat4 ProjectionInverse;
+		glm::mat4 PreviousModelView;
+		glm::mat4 PreviousProjection;
 		float Aperture;
 		float FocusDistance;
 		float HeatmapScale;
-		uint32_t TotalNumberOfSamples;
-		uint32_t NumberOfSamples;
 		uint32_t NumberOfBounces;
-		uint32_t RandomSeed;
 		uint32_t HasSky; // bool
 		uint32_t ShowHeatmap; // bool
+		uint32_t NextEventEstimation; // bool
+		uint32_t NumberOfLights;
+		float TotalLightArea;
+		uint32_t RussianRoulette; // bool
+		uint32_t RussianRouletteMinDepth;
+		float RussianRouletteMaxSurvival;
+		uint32_t Sampler;
+		uint32_t Denoise; // bool
+		uint32_t TemporalReprojection; // bool
+		uint32_t AdaptiveSampling; // bool
+		uint32_t ShowSampleDistribution; // bool
+		float PixelSpreadAngle; // of the ray cones, for the texture level of detail
 	};
 
+	// A ring of UniformBufferObject slices, one per frame in flight, in a single persistently mapped host coherent buffer.
+	// Shaders see one slice at a time through a dynamic uniform buffer descriptor, selected with SliceOffset().
 	class UniformBuffer
 	{
 	public:
 
 		UniformBuffer(const UniformBuffer&) = delete;
+		UniformBuffer(UniformBuffer&&) = delete;
 		UniformBuffer& operator = (const UniformBuffer&) = delete;
 		UniformBuffer& operator = (UniformBuffer&&) = delete;
 
-		explicit UniformBuffer(const Vulkan::Device& device);
-		UniformBuffer(UniformBuffer&& other) noexcept;
+		UniformBuffer(const Vulkan::Device& device, size_t sliceCount);
 		~UniformBuffer();
 
 		const Vulkan::Buffer& Buffer() const { return *buffer_; }
 
-		void SetValue(const UniformBufferObject& ubo);
+		size_t SliceCount() const { return sliceCount_; }
+		VkDeviceSize SliceSize() const { return sizeof(UniformBufferObject); }
+		uint32_t SliceOffset(size_t slice) const { return static_cast<uint32_t>(slice * sliceStride_); }
+
+		void SetValue(size_t slice, const UniformBufferObject& ubo);
 
 	private:
 
+		const size_t sliceCount_;
+		VkDeviceSize sliceStride_{};
+		void* mappedData_{};
+
 		std::unique_ptr<Vulkan::Buffer> buffer_;
 		std::unique_ptr<Vulkan::DeviceMemory> memory_;
 	};
 
-}
\ No newline at end of file
+}
@@ -3,10 +3,13 @@
 #include "Utilities/Glm.hpp"
 #include "Vulkan/Vulkan.hpp"
 #include <array>
+#include <cmath>
 
 namespace Assets
 {
 
+	// Full precision vertex, as loaded and cached. The GPU gets it split into a position stream and packed attributes
+	// (see VertexAttributes), while the material index moves to a per primitive stream (see Scene).
 	struct Vertex final
 	{
 		glm::vec3 Position;
@@ -22,42 +25,70 @@ namespace Assets
 				TexCoord == other.TexCoord &&
 				MaterialIndex == other.MaterialIndex;
 		}
+	};
+
+	// Compressed vertex attributes, 8 bytes instead of the 20 of Vertex::Normal and Vertex::TexCoord.
+	// Matches UnpackVertexAttributes() in Vertex.glsl and the vertex inputs of Graphics.vert.
+	struct VertexAttributes final
+	{
+		uint32_t Normal; // octahedral encoding, 2x snorm16
+		uint32_t TexCoord; // 2x half
 
-		static VkVertexInputBindingDescription GetBindingDescription()
+		static VertexAttributes Pack(const Vertex& vertex)
 		{
-			VkVertexInputBindingDescription bindingDescription = {};
-			bindingDescription.binding = 0;
-			bindingDescription.stride = sizeof(Vertex);
-			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-			return bindingDescription;
+			// Project the normal onto the octahedron |x| + |y| + |z| = 1, and fold the lower hemisphere over the upper one.
+			const glm::vec3 n = vertex.Normal;
+			const float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+			glm::vec2 octahedral = sum > 0 ? glm::vec2(n.x, n.y) / sum : glm::vec2(0);
+
+			if (n.z < 0)
+			{
+				const glm::vec2 sign(octahedral.x >= 0 ? 1.0f : -1.0f, octahedral.y >= 0 ? 1.0f : -1.0f);
+				octahedral = (1.0f - glm::abs(glm::vec2(octahedral.y, octahedral.x))) * sign;
+			}
+
+			return VertexAttributes{ glm::packSnorm2x16(octahedral), glm::packHalf2x16(vertex.TexCoord) };
 		}
 
-		static std::array<VkVertexInputAttributeDescription, 4> GetAttributeDescriptions()
+		// The positions (binding 0) and the attributes (binding 1) are two separate vertex buffers.
+		static std::array<VkVertexInputBindingDescription, 2> GetBindingDescriptions()
 		{
-			std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions = {};
+			std::array<VkVertexInputBindingDescription, 2> bindingDescriptions = {};
+
+			bindingDescriptions[0].binding = 0;
+			bindingDescriptions[0].stride = sizeof(glm::vec3);
+			bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			bindingDescriptions[1].binding = 1;
+			bindingDescriptions[1].stride = sizeof(VertexAttributes);
+			bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			return bindingDescriptions;
+		}
+
+		static std::array<VkVertexInputAttributeDescription, 3> GetAttributeDescriptions()
+		{
+			std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions = {};
 
 			attributeDescriptions[0].binding = 0;
 			attributeDescriptions[0].location = 0;
 			attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-			attributeDescriptions[0].offset = offsetof(Vertex, Position);
+			attributeDescriptions[0].offset = 0;
 
-			attributeDescriptions[1].binding = 0;
+			attributeDescriptions[1].binding = 1;
 			attributeDescriptions[1].location = 1;
-			attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-			attributeDescriptions[1].offset = offsetof(Vertex, Normal);
+			attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+			attributeDescriptions[1].offset = offsetof(VertexAttributes, Normal);
 
-			attributeDescriptions[2].binding = 0;
+			attributeDescriptions[2].binding = 1;
 			attributeDescriptions[2].location = 2;
-			attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-			attributeDescriptions[2].offset = offsetof(Vertex, TexCoord);
-
-			attributeDescriptions[3].binding = 0;
-			attributeDescriptions[3].location = 3;
-			attributeDescriptions[3].format = VK_FORMAT_R32_SINT;
-			attributeDescriptions[3].offset = offsetof(Vertex, MaterialIndex);
+			attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+			attributeDescriptions[2].offset = offsetof(VertexAttributes, TexCoord);
 
 			return attributeDescriptions;
 		}
 	};
 
+	static_assert(sizeof(VertexAttributes) == 8, "VertexAttributes must match its GLSL layout");
+
 }
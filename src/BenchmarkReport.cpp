@@ -0,0 +1,259 @@
+#include "BenchmarkReport.hpp"
+#include "Utilities/Exception.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+#include <utility>
+
+namespace
+{
+	const char* BuildConfiguration()
+	{
+#ifdef NDEBUG
+		return "Release";
+#else
+		return "Debug";
+#endif
+	}
+
+	// Nearest-rank percentile of sorted values.
+	double Percentile(const std::vector<double>& sorted, const double percentile)
+	{
+		if (sorted.empty())
+		{
+			return 0;
+		}
+
+		const auto rank = static_cast<size_t>(std::ceil(percentile / 100.0 * sorted.size()));
+		return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+	}
+
+	std::string JsonString(const std::string& value)
+	{
+		std::ostringstream out;
+		out << '"';
+
+		for (const char c : value)
+		{
+			switch (c)
+			{
+			case '"': out << "\\\""; break;
+			case '\\': out << "\\\\"; break;
+			case '\n': out << "\\n"; break;
+			case '\r': out << "\\r"; break;
+			case '\t': out << "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+				{
+					out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+				}
+				else
+				{
+					out << c;
+				}
+			}
+		}
+
+		out << '"';
+		return out.str();
+	}
+
+	std::string CsvString(const std::string& value)
+	{
+		std::string quoted = "\"";
+
+		for (const char c : value)
+		{
+			quoted += c == '"' ? std::string("\"\"") : std::string(1, c);
+		}
+
+		return quoted + "\"";
+	}
+
+	bool EndsWith(const std::string& value, const std::string& suffix)
+	{
+		return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+	}
+}
+
+BenchmarkReport::BenchmarkReport(std::string filename, std::string deviceName, std::string driverVersion, const uint32_t warmupFrames) :
+	filename_(std::move(filename)),
+	deviceName_(std::move(deviceName)),
+	driverVersion_(std::move(driverVersion)),
+	warmupFrames_(warmupFrames)
+{
+}
+
+void BenchmarkReport::BeginScene(const SceneInfo& scene)
+{
+	scene_ = scene;
+	sceneFrames_ = 0;
+	frameTimes_.clear();
+	rays_ = 0;
+	pathLengths_ = 0;
+	gpuTimes_.clear();
+	inScene_ = true;
+}
+
+void BenchmarkReport::AddFrame(const double frameTime, const uint64_t rays, const double averagePathLength)
+{
+	if (!inScene_ || sceneFrames_++ < warmupFrames_)
+	{
+		return;
+	}
+
+	frameTimes_.push_back(frameTime);
+	rays_ += rays;
+	pathLengths_ += averagePathLength;
+}
+
+void BenchmarkReport::AddGpuTime(const std::string& pass, const double milliseconds)
+{
+	if (!inScene_ || sceneFrames_ <= warmupFrames_)
+	{
+		return;
+	}
+
+	auto gpuTime = std::find_if(gpuTimes_.begin(), gpuTimes_.end(), [&pass](const GpuTime& time) { return time.Pass == pass; });
+
+	if (gpuTime == gpuTimes_.end())
+	{
+		gpuTimes_.push_back({ pass, 0, 0 });
+		gpuTime = std::prev(gpuTimes_.end());
+	}
+
+	gpuTime->Milliseconds += milliseconds;
+	gpuTime->Count++;
+}
+
+void BenchmarkReport::EndScene()
+{
+	if (!inScene_)
+	{
+		return;
+	}
+
+	auto sorted = frameTimes_;
+	std::sort(sorted.begin(), sorted.end());
+
+	const double totalTime = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+
+	SceneRecord record = {};
+	record.Scene = scene_;
+	record.TotalFrames = static_cast<uint32_t>(sorted.size());
+	record.MeanFrameTime = sorted.empty() ? 0 : totalTime / sorted.size();
+	record.MedianFrameTime = Percentile(sorted, 50);
+	record.P95FrameTime = Percentile(sorted, 95);
+	record.P99FrameTime = Percentile(sorted, 99);
+	record.RaysPerSecond = totalTime > 0 ? rays_ / totalTime : 0;
+	record.MeanPathLength = sorted.empty() ? 0 : pathLengths_ / sorted.size();
+
+	for (const auto& gpuTime : gpuTimes_)
+	{
+		record.MeanGpuTimes.emplace_back(gpuTime.Pass, gpuTime.Milliseconds / gpuTime.Count);
+	}
+
+	records_.push_back(std::move(record));
+	inScene_ = false;
+}
+
+void BenchmarkReport::Write() const
+{
+	std::ofstream file(filename_, std::ios::trunc);
+
+	file << std::setprecision(9);
+
+	EndsWith(filename_, ".csv") ? WriteCsv(file) : WriteJson(file);
+
+	if (!file)
+	{
+		Throw(std::runtime_error("failed to write benchmark report '" + filename_ + "'"));
+	}
+}
+
+void BenchmarkReport::WriteJson(std::ostream& out) const
+{
+	out << "{\n";
+	out << "\t\"device\": " << JsonString(deviceName_) << ",\n";
+	out << "\t\"driver\": " << JsonString(driverVersion_) << ",\n";
+	out << "\t\"build\": " << JsonString(BuildConfiguration()) << ",\n";
+	out << "\t\"warmupFrames\": " << warmupFrames_ << ",\n";
+	out << "\t\"scenes\": [";
+
+	for (size_t i = 0; i != records_.size(); ++i)
+	{
+		const auto& record = records_[i];
+
+		out << (i == 0 ? "\n" : ",\n");
+		out << "\t\t{\n";
+		out << "\t\t\t\"scene\": " << JsonString(record.Scene.Name) << ",\n";
+		out << "\t\t\t\"engine\": " << JsonString(record.Scene.Engine) << ",\n";
+		out << "\t\t\t\"width\": " << record.Scene.Width << ",\n";
+		out << "\t\t\t\"height\": " << record.Scene.Height << ",\n";
+		out << "\t\t\t\"samples\": " << record.Scene.Samples << ",\n";
+		out << "\t\t\t\"bounces\": " << record.Scene.Bounces << ",\n";
+		out << "\t\t\t\"totalFrames\": " << record.TotalFrames << ",\n";
+		out << "\t\t\t\"meanFrameTimeMs\": " << record.MeanFrameTime * 1000 << ",\n";
+		out << "\t\t\t\"medianFrameTimeMs\": " << record.MedianFrameTime * 1000 << ",\n";
+		out << "\t\t\t\"p95FrameTimeMs\": " << record.P95FrameTime * 1000 << ",\n";
+		out << "\t\t\t\"p99FrameTimeMs\": " << record.P99FrameTime * 1000 << ",\n";
+		out << "\t\t\t\"raysPerSecond\": " << record.RaysPerSecond << ",\n";
+		out << "\t\t\t\"meanPathLength\": " << record.MeanPathLength << ",\n";
+		out << "\t\t\t\"meanGpuTimesMs\": {";
+
+		for (size_t j = 0; j != record.MeanGpuTimes.size(); ++j)
+		{
+			out << (j == 0 ? " " : ", ") << JsonString(record.MeanGpuTimes[j].first) << ": " << record.MeanGpuTimes[j].second;
+		}
+
+		out << (record.MeanGpuTimes.empty() ? "},\n" : " },\n");
+		out << "\t\t\t\"sceneLoadTimeS\": " << record.Scene.LoadTime << ",\n";
+		out << "\t\t\t\"accelerationStructureBuildTimeS\": " << record.Scene.AccelerationStructureBuildTime << "\n";
+		out << "\t\t}";
+	}
+
+	out << (records_.empty() ? "]\n" : "\n\t]\n");
+	out << "}\n";
+}
+
+void BenchmarkReport::WriteCsv(std::ostream& out) const
+{
+	out << "scene,engine,width,height,samples,bounces,totalFrames,meanFrameTimeMs,medianFrameTimeMs,p95FrameTimeMs,p99FrameTimeMs,raysPerSecond,meanPathLength,meanGpuTimesMs,sceneLoadTimeS,accelerationStructureBuildTimeS,device,driver,build\n";
+
+	for (const auto& record : records_)
+	{
+		// GPU passes vary with the render mode, pack them into a single "pass=ms;..." column.
+		std::ostringstream gpuTimes;
+		gpuTimes << std::setprecision(9);
+
+		for (size_t i = 0; i != record.MeanGpuTimes.size(); ++i)
+		{
+			gpuTimes << (i == 0 ? "" : ";") << record.MeanGpuTimes[i].first << '=' << record.MeanGpuTimes[i].second;
+		}
+
+		out
+			<< CsvString(record.Scene.Name) << ','
+			<< CsvString(record.Scene.Engine) << ','
+			<< record.Scene.Width << ','
+			<< record.Scene.Height << ','
+			<< record.Scene.Samples << ','
+			<< record.Scene.Bounces << ','
+			<< record.TotalFrames << ','
+			<< record.MeanFrameTime * 1000 << ','
+			<< record.MedianFrameTime * 1000 << ','
+			<< record.P95FrameTime * 1000 << ','
+			<< record.P99FrameTime * 1000 << ','
+			<< record.RaysPerSecond << ','
+			<< record.MeanPathLength << ','
+			<< CsvString(gpuTimes.str()) << ','
+			<< record.Scene.LoadTime << ','
+			<< record.Scene.AccelerationStructureBuildTime << ','
+			<< CsvString(deviceName_) << ','
+			<< CsvString(driverVersion_) << ','
+			<< CsvString(BuildConfiguration()) << '\n';
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Collects per scene benchmark statistics and writes them to a file, as CSV when the file name ends with ".csv" and as JSON otherwise.
+// The first frames of each scene are a warm-up period (pipeline creation, caches, clocks ramping up) and are left out of the statistics.
+class BenchmarkReport final
+{
+public:
+
+	struct SceneInfo final
+	{
+		std::string Name;
+		std::string Engine;
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t Samples;
+		uint32_t Bounces;
+		double LoadTime;
+		double AccelerationStructureBuildTime;
+	};
+
+	BenchmarkReport(std::string filename, std::string deviceName, std::string driverVersion, uint32_t warmupFrames);
+	~BenchmarkReport() = default;
+
+	void BeginScene(const SceneInfo& scene);
+	// The average path length is the mean number of segments per camera path, a few frames behind like the GPU times.
+	void AddFrame(double frameTime, uint64_t rays, double averagePathLength);
+
+	// GPU time of a named pass in the frame last given to AddFrame().
+	void AddGpuTime(const std::string& pass, double milliseconds);
+	void EndScene();
+
+	// Rewrites the whole report, so that it is complete after every scene.
+	void Write() const;
+
+private:
+
+	struct GpuTime final
+	{
+		std::string Pass;
+		double Milliseconds;
+		uint32_t Count;
+	};
+
+	struct SceneRecord final
+	{
+		SceneInfo Scene;
+		uint32_t TotalFrames;
+		double MeanFrameTime;
+		double MedianFrameTime;
+		double P95FrameTime;
+		double P99FrameTime;
+		double RaysPerSecond;
+		double MeanPathLength;
+		std::vector<std::pair<std::string, double>> MeanGpuTimes;
+	};
+
+	void WriteJson(std::ostream& out) const;
+	void WriteCsv(std::ostream& out) const;
+
+	const std::string filename_;
+	const std::string deviceName_;
+	const std::string driverVersion_;
+	const uint32_t warmupFrames_;
+
+	std::vector<SceneRecord> records_;
+
+	// Current scene.
+	SceneInfo scene_{};
+	uint32_t sceneFrames_{};
+	std::vector<double> frameTimes_;
+	uint64_t rays_{};
+	double pathLengths_{};
+	std::vector<GpuTime> gpuTimes_;
+	bool inScene_{};
+};
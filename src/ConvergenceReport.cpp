@@ -0,0 +1,77 @@
+#include "ConvergenceReport.hpp"
+#include "Utilities/Exception.hpp"
+#include "Utilities/StbImage.hpp"
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+
+ConvergenceReport::ConvergenceReport(const std::string& referenceFilename, std::string filename) :
+	filename_(std::move(filename))
+{
+	int width, height, channels;
+	const auto pixels = stbi_load(referenceFilename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+
+	if (!pixels)
+	{
+		Throw(std::runtime_error("failed to load reference image '" + referenceFilename + "'"));
+	}
+
+	width_ = static_cast<uint32_t>(width);
+	height_ = static_cast<uint32_t>(height);
+	reference_.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+
+	stbi_image_free(pixels);
+}
+
+void ConvergenceReport::AddImage(const uint32_t samples, const double seconds, const std::vector<uint8_t>& pixels)
+{
+	if (pixels.size() != reference_.size())
+	{
+		Throw(std::runtime_error("image and reference image sizes do not match"));
+	}
+
+	double sum = 0;
+
+	for (size_t i = 0; i != pixels.size(); i += 4)
+	{
+		for (size_t c = 0; c != 3; ++c)
+		{
+			const double error = (static_cast<double>(pixels[i + c]) - reference_[i + c]) / 255.0;
+			sum += error * error;
+		}
+	}
+
+	const auto rmse = pixels.empty() ? 0.0 : std::sqrt(sum / (pixels.size() / 4 * 3));
+
+	std::cout
+		<< "Convergence: " << std::setw(6) << samples << " spp, "
+		<< std::fixed << std::setprecision(3) << std::setw(8) << seconds << " s, "
+		<< "LDR RMSE " << std::setprecision(6) << rmse << std::defaultfloat << std::endl;
+
+	records_.push_back({ samples, seconds, rmse });
+}
+
+void ConvergenceReport::Write() const
+{
+	if (filename_.empty())
+	{
+		return;
+	}
+
+	std::ofstream file(filename_, std::ios::trunc);
+
+	file << std::setprecision(9);
+	file << "samples,seconds,rmse_ldr\n";
+
+	for (const auto& record : records_)
+	{
+		file << record.Samples << ',' << record.Seconds << ',' << record.Rmse << '\n';
+	}
+
+	if (!file)
+	{
+		Throw(std::runtime_error("failed to write convergence report '" + filename_ + "'"));
+	}
+}
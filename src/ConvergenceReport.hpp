@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Measures how fast a render converges: the error of the output image against a reference image at increasing sample counts.
+// The error is the RMSE of the 8-bit output in [0, 1], over the RGB channels, along with the render time it took to get there.
+// Both images are LDR: gamma corrected (square root) and clamped, like the PNG reference, so the error is not that of the
+// linear radiance. Results are printed, and written as CSV if a file is given, both labelled as such.
+class ConvergenceReport final
+{
+public:
+
+	ConvergenceReport(const std::string& referenceFilename, std::string filename);
+	~ConvergenceReport() = default;
+
+	uint32_t Width() const { return width_; }
+	uint32_t Height() const { return height_; }
+
+	// Tightly packed RGBA8 pixels, with the same size as the reference, after the given seconds of rendering.
+	void AddImage(uint32_t samples, double seconds, const std::vector<uint8_t>& pixels);
+
+	// Rewrites the whole report, so that it is complete after every image.
+	void Write() const;
+
+private:
+
+	struct Record final
+	{
+		uint32_t Samples;
+		double Seconds;
+		double Rmse;
+	};
+
+	const std::string filename_;
+
+	uint32_t width_{};
+	uint32_t height_{};
+	std::vector<uint8_t> reference_;
+
+	std::vector<Record> records_;
+};
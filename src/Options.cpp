@@ -14,6 +14,8 @@ Options::Options(const int argc, const char* argv[])
 	benchmark.add_options()
 		("next-scenes", bool_switch(&BenchmarkNextScenes)->default_value(false), "Load the next scene once the sample or time limit is reached.")
 		("max-time", value<uint32_t>(&BenchmarkMaxTime)->default_value(60), "The benchmark time limit per scene (in seconds).")
+		("warmup-frames", value<uint32_t>(&BenchmarkWarmupFrames)->default_value(30), "The number of frames per scene left out of the benchmark report statistics.")
+		("benchmark-report", value<std::string>(&BenchmarkReport), "Write per scene benchmark statistics to this file (CSV if it ends with .csv, JSON otherwise).")
 		;
 
 	options_description renderer("Renderer options", lineLength);
@@ -21,11 +23,26 @@ Options::Options(const int argc, const char* argv[])
 		("samples", value<uint32_t>(&Samples)->default_value(8), "The number of ray samples per pixel.")
 		("bounces", value<uint32_t>(&Bounces)->default_value(16), "The maximum number of bounces per ray.")
 		("max-samples", value<uint32_t>(&MaxSamples)->default_value(64 * 1024), "The maximum number of accumulated ray samples per pixel.")
+		("compact-blas", bool_switch(&CompactBlas)->default_value(false), "Compact the bottom level acceleration structures after building them.")
+		("nee", bool_switch(&NextEventEstimation)->default_value(false), "Sample the lights explicitly at diffuse hits (next event estimation), combined with BSDF sampling by multiple importance sampling.")
+		("sampler", value<uint32_t>(&Sampler)->default_value(1), "The sampler (0 = Random, 1 = Sobol).")
+		("engine", value<uint32_t>(&Engine)->default_value(0), "The path tracing engine (0 = Ray tracing pipeline, 1 = Wavefront compute with ray queries).")
+		("russian-roulette", bool_switch(&RussianRoulette)->default_value(false), "Randomly terminate paths with a low throughput, reweighting the surviving ones.")
+		("rr-min-depth", value<uint32_t>(&RussianRouletteMinDepth)->default_value(3), "The number of bounces before Russian roulette starts terminating paths.")
+		("rr-max-survival", value<float>(&RussianRouletteMaxSurvival)->default_value(0.95f), "The highest survival probability of a path under Russian roulette (0 to 1).")
+		("denoise", bool_switch(&Denoise)->default_value(false), "Filter the accumulated image with an edge-avoiding a-trous wavelet denoiser before displaying it.")
+		("denoise-iterations", value<uint32_t>(&DenoiseIterations)->default_value(5), "The number of a-trous denoiser iterations (1 to 5).")
+		("temporal-reprojection", bool_switch(&TemporalReprojection)->default_value(false), "Reproject the accumulated samples when the camera moves instead of discarding them.")
+		("max-history", value<uint32_t>(&MaxHistoryLength)->default_value(32), "The maximum number of samples per pixel carried over by the temporal reprojection.")
+		("adaptive", bool_switch(&AdaptiveSampling)->default_value(false), "Spend the samples of each frame on the tiles that are still noisy, converged tiles are no longer traced.")
+		("adaptive-threshold", value<float>(&AdaptiveThreshold)->default_value(0.01f), "The standard error of a pixel below which adaptive sampling considers it converged.")
 		;
 
 	options_description scene("Scene options", lineLength);
 	scene.add_options()
 		("scene", value<uint32_t>(&SceneIndex)->default_value(0), "The scene to start with.")
+		("loader-threads", value<uint32_t>(&LoaderThreads)->default_value(0), "The number of threads used to load models and decode textures (0 = one per hardware thread, 1 = serial).")
+		("no-model-cache", bool_switch(&NoModelCache)->default_value(false), "Always parse models from source instead of using or writing the binary mesh cache.")
 		;
 
 	options_description vulkan("Vulkan options", lineLength);
@@ -45,6 +62,10 @@ Options::Options(const int argc, const char* argv[])
 	desc.add_options()
 		("help", "Display help message.")
 		("benchmark", bool_switch(&Benchmark)->default_value(false), "Run the application in benchmark mode.")
+		("headless", bool_switch(&Headless)->default_value(false), "Render offscreen at --width x --height without a window until --max-samples is reached, then write the image to --output.")
+		("output", value<std::string>(&Output)->default_value("output.png"), "The PNG file written by a headless render.")
+		("reference", value<std::string>(&Reference), "Measure the error (RMSE of the gamma corrected 8-bit output) of a headless render against this PNG image at every power of two samples per pixel.")
+		("convergence-report", value<std::string>(&ConvergenceReport), "Write the errors measured against --reference to this CSV file.")
 		;
 
 	desc.add(benchmark);
@@ -73,5 +94,45 @@ Options::Options(const int argc, const char* argv[])
 	{
 		Throw(std::out_of_range("invalid present mode"));
 	}
+
+	if (Sampler > 1)
+	{
+		Throw(std::out_of_range("invalid sampler"));
+	}
+
+	if (Engine > 1)
+	{
+		Throw(std::out_of_range("invalid engine"));
+	}
+
+	if (DenoiseIterations == 0 || DenoiseIterations > 5)
+	{
+		Throw(std::out_of_range("invalid number of denoiser iterations"));
+	}
+
+	if (MaxHistoryLength == 0)
+	{
+		Throw(std::out_of_range("invalid maximum history length"));
+	}
+
+	if (AdaptiveThreshold <= 0)
+	{
+		Throw(std::out_of_range("invalid adaptive sampling threshold"));
+	}
+
+	if (!Reference.empty() && !Headless)
+	{
+		Throw(std::invalid_argument("measuring the error against a reference image requires headless rendering"));
+	}
+
+	if (RussianRouletteMaxSurvival <= 0 || RussianRouletteMaxSurvival > 1)
+	{
+		Throw(std::out_of_range("invalid Russian roulette survival probability"));
+	}
+
+	if (Headless && (MaxSamples == 0 || Samples == 0))
+	{
+		Throw(std::out_of_range("headless rendering requires a non-zero number of samples"));
+	}
 }
 
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <exception>
+#include <string>
 #include <vector>
 
 class Options final
@@ -21,18 +22,39 @@ public:
 
 	// Application options.
 	bool Benchmark{};
+	bool Headless{};
+	std::string Output{};
+	std::string Reference{};
+	std::string ConvergenceReport{};
 	
 	// Benchmark options.
 	bool BenchmarkNextScenes{};
 	uint32_t BenchmarkMaxTime{};
+	uint32_t BenchmarkWarmupFrames{};
+	std::string BenchmarkReport{};
 
 	// Renderer options.
 	uint32_t Samples{};
 	uint32_t Bounces{};
 	uint32_t MaxSamples{};
+	bool CompactBlas{};
+	bool NextEventEstimation{};
+	bool RussianRoulette{};
+	uint32_t RussianRouletteMinDepth{};
+	float RussianRouletteMaxSurvival{};
+	uint32_t Sampler{};
+	uint32_t Engine{};
+	bool Denoise{};
+	uint32_t DenoiseIterations{};
+	bool TemporalReprojection{};
+	uint32_t MaxHistoryLength{};
+	bool AdaptiveSampling{};
+	float AdaptiveThreshold{};
 
 	// Scene options.
 	uint32_t SceneIndex{};
+	uint32_t LoaderThreads{};
+	bool NoModelCache{};
 
 	// Vulkan options
 	std::vector<uint32_t> VisibleDevices{};
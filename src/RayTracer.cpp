@@ -1,4 +1,6 @@
 #include "RayTracer.hpp"
+#include "BenchmarkReport.hpp"
+#include "ConvergenceReport.hpp"
 #include "UserInterface.hpp"
 #include "UserSettings.hpp"
 #include "Assets/Model.hpp"
@@ -8,8 +10,12 @@
 #include "Utilities/Exception.hpp"
 #include "Utilities/Glm.hpp"
 #include "Vulkan/Device.hpp"
+#include "Vulkan/GpuProfiler.hpp"
 #include "Vulkan/SwapChain.hpp"
+#include "Vulkan/Version.hpp"
 #include "Vulkan/Window.hpp"
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <sstream>
 
@@ -49,19 +55,83 @@ Assets::UniformBufferObject RayTracer::GetUniformBufferObject(const VkExtent2D e
 	ubo.Projection[1][1] *= -1; // Inverting Y for Vulkan, https://matthewwellings.com/blog/the-new-vulkan-coordinate-system/
 	ubo.ModelViewInverse = glm::inverse(ubo.ModelView);
 	ubo.ProjectionInverse = glm::inverse(ubo.Projection);
+	ubo.PreviousModelView = previousModelView_;
+	ubo.PreviousProjection = previousProjection_;
 	ubo.Aperture = userSettings_.Aperture;
 	ubo.FocusDistance = userSettings_.FocusDistance;
-	ubo.TotalNumberOfSamples = totalNumberOfSamples_;
-	ubo.NumberOfSamples = numberOfSamples_;
 	ubo.NumberOfBounces = userSettings_.NumberOfBounces;
-	ubo.RandomSeed = 1;
 	ubo.HasSky = init.HasSky;
 	ubo.ShowHeatmap = userSettings_.ShowHeatmap;
 	ubo.HeatmapScale = userSettings_.HeatmapScale;
+	ubo.NextEventEstimation = userSettings_.NextEventEstimation && scene_->NumberOfLights() != 0;
+	ubo.NumberOfLights = scene_->NumberOfLights();
+	ubo.TotalLightArea = scene_->TotalLightArea();
+	ubo.RussianRoulette = userSettings_.RussianRoulette;
+	ubo.RussianRouletteMinDepth = userSettings_.RussianRouletteMinDepth;
+	ubo.RussianRouletteMaxSurvival = userSettings_.RussianRouletteMaxSurvival;
+	ubo.Sampler = userSettings_.Sampler;
+	ubo.Denoise = GetDenoiserSettings().Enabled;
+	ubo.TemporalReprojection = userSettings_.TemporalReprojection;
+	ubo.AdaptiveSampling = GetAdaptiveSamplingSettings().Enabled;
+	ubo.ShowSampleDistribution = userSettings_.ShowSampleDistribution;
+	ubo.PixelSpreadAngle = std::atan(2 * std::tan(glm::radians(userSettings_.FieldOfView) / 2) / extent.height);
 
 	return ubo;
 }
 
+Vulkan::RayTracing::RayTracingPipeline::PushConstants RayTracer::GetPushConstants() const
+{
+	Vulkan::RayTracing::RayTracingPipeline::PushConstants pushConstants = {};
+	pushConstants.TotalNumberOfSamples = totalNumberOfSamples_;
+	pushConstants.NumberOfSamples = numberOfSamples_;
+	pushConstants.RandomSeed = 1;
+	pushConstants.SampleOffset = sampleOffset_;
+
+	return pushConstants;
+}
+
+Vulkan::RayTracing::Denoiser::Settings RayTracer::GetDenoiserSettings() const
+{
+	// The heatmap and the sample distribution show raw per pixel data, there is nothing to filter.
+	Vulkan::RayTracing::Denoiser::Settings settings = {};
+	settings.Enabled = userSettings_.IsRayTraced && userSettings_.Denoise && !userSettings_.ShowHeatmap && !userSettings_.ShowSampleDistribution;
+	settings.Iterations = userSettings_.DenoiseIterations;
+
+	return settings;
+}
+
+Vulkan::RayTracing::TemporalReprojection::Settings RayTracer::GetTemporalReprojectionSettings() const
+{
+	Vulkan::RayTracing::TemporalReprojection::Settings settings = {};
+	settings.Reproject = reprojectHistory_;
+	settings.MaxHistoryLength = userSettings_.MaxHistoryLength;
+
+	return settings;
+}
+
+Vulkan::RayTracing::AdaptiveSampler::Settings RayTracer::GetAdaptiveSamplingSettings() const
+{
+	Vulkan::RayTracing::AdaptiveSampler::Settings settings = {};
+	settings.Enabled = userSettings_.IsRayTraced && userSettings_.AdaptiveSampling && !GetWavefrontSettings().Enabled;
+	settings.Threshold = userSettings_.AdaptiveThreshold;
+
+	return settings;
+}
+
+Vulkan::RayTracing::WavefrontPathTracer::Settings RayTracer::GetWavefrontSettings() const
+{
+	// The heatmap and the sample distribution are views of the ray generation shader.
+	Vulkan::RayTracing::WavefrontPathTracer::Settings settings = {};
+	settings.Enabled =
+		userSettings_.IsRayTraced &&
+		userSettings_.Engine == UserSettings::EngineWavefront &&
+		!userSettings_.ShowHeatmap &&
+		!userSettings_.ShowSampleDistribution;
+	settings.NumberOfBounces = userSettings_.NumberOfBounces;
+
+	return settings;
+}
+
 void RayTracer::SetPhysicalDevice(
 	VkPhysicalDevice physicalDevice, 
 	std::vector<const char*>& requiredExtensions,
@@ -92,15 +162,54 @@ void RayTracer::OnDeviceSet()
 {
 	Application::OnDeviceSet();
 
+	if (userSettings_.Engine == UserSettings::EngineWavefront && !HasRayQuery())
+	{
+		Throw(std::runtime_error("the wavefront engine requires a device with ray queries (VK_KHR_ray_query)"));
+	}
+
+	if (userSettings_.Benchmark && !userSettings_.BenchmarkReport.empty())
+	{
+		VkPhysicalDeviceDriverProperties driverProp{};
+		driverProp.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DRIVER_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 deviceProp{};
+		deviceProp.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		deviceProp.pNext = &driverProp;
+
+		vkGetPhysicalDeviceProperties2(Device().PhysicalDevice(), &deviceProp);
+
+		const auto& prop = deviceProp.properties;
+
+		std::ostringstream driver;
+		driver << driverProp.driverName << " " << driverProp.driverInfo << " - " << Vulkan::Version(prop.driverVersion, prop.vendorID);
+
+		benchmarkReport_.reset(new BenchmarkReport(userSettings_.BenchmarkReport, prop.deviceName, driver.str(), userSettings_.BenchmarkWarmupFrames));
+	}
+
+	if (IsHeadless() && !userSettings_.ReferenceImage.empty())
+	{
+		convergenceReport_.reset(new ConvergenceReport(userSettings_.ReferenceImage, userSettings_.ConvergenceReport));
+
+		if (convergenceReport_->Width() != Extent().width || convergenceReport_->Height() != Extent().height)
+		{
+			Throw(std::runtime_error("the reference image size does not match the render size"));
+		}
+	}
+
 	LoadScene(userSettings_.SceneIndex);
-	CreateAccelerationStructures();
+	BuildAccelerationStructures();
+}
+
+bool RayTracer::IsOffscreenRenderComplete() const
+{
+	return totalNumberOfSamples_ >= userSettings_.MaxNumberOfSamples;
 }
 
 void RayTracer::CreateSwapChain()
 {
 	Application::CreateSwapChain();
 
-	userInterface_.reset(new UserInterface(CommandPool(), SwapChain(), DepthBuffer(), userSettings_));
+	userInterface_.reset(IsHeadless() ? nullptr : new UserInterface(CommandPool(), SwapChain(), DepthBuffer(), PipelineCache(), userSettings_));
 	resetAccumulation_ = true;
 
 	CheckFramebufferSize();
@@ -122,38 +231,103 @@ void RayTracer::DrawFrame()
 		DeleteSwapChain();
 		DeleteAccelerationStructures();
 		LoadScene(userSettings_.SceneIndex);
-		CreateAccelerationStructures();
+		BuildAccelerationStructures();
 		CreateSwapChain();
 		return;
 	}
 
+	// Swap in the textures that finished streaming since the last frame.
+	if (scene_->UpdateTextures())
+	{
+		UpdateTextureDescriptors();
+		resetAccumulation_ = true;
+	}
+
+	// The wavefront engine cannot be picked in the UI without ray queries.
+	if (userSettings_.Engine == UserSettings::EngineWavefront && !HasRayQuery())
+	{
+		userSettings_.Engine = UserSettings::EngineRayTracingPipeline;
+	}
+
 	// Check if the accumulation buffer needs to be reset.
 	if (resetAccumulation_ || 
 		userSettings_.RequiresAccumulationReset(previousSettings_) || 
 		!userSettings_.AccumulateRays)
 	{
 		totalNumberOfSamples_ = 0;
+		sampleOffset_ = 0;
 		resetAccumulation_ = false;
 	}
 
 	previousSettings_ = userSettings_;
 
 	// Keep track of our sample count.
+	const auto previousTotalNumberOfSamples = totalNumberOfSamples_;
 	numberOfSamples_ = glm::clamp(userSettings_.MaxNumberOfSamples - totalNumberOfSamples_, 0u, userSettings_.NumberOfSamples);
 	totalNumberOfSamples_ += numberOfSamples_;
 
+	// The convergence report measures the time to reach an error, so each frame is waited on (headless only).
+	const auto timer = std::chrono::high_resolution_clock::now();
+
 	Application::DrawFrame();
+
+	if (convergenceReport_)
+	{
+		Device().WaitIdle();
+		convergenceTime_ += std::chrono::duration<double, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - timer).count();
+	}
+
+	// The camera of this frame is the previous one of the next frame.
+	const auto ubo = GetUniformBufferObject(Extent());
+	previousModelView_ = ubo.ModelView;
+	previousProjection_ = ubo.Projection;
+	reprojectHistory_ = false;
+
+	// Measure the error whenever the sample count reaches the next power of two, and at the end of the render.
+	if (convergenceReport_ && numberOfSamples_ != 0)
+	{
+		uint32_t powerOfTwo = 1;
+
+		while (powerOfTwo <= previousTotalNumberOfSamples && powerOfTwo < 0x80000000u)
+		{
+			powerOfTwo *= 2;
+		}
+
+		if (totalNumberOfSamples_ >= powerOfTwo || IsOffscreenRenderComplete())
+		{
+			convergenceReport_->AddImage(totalNumberOfSamples_, convergenceTime_, ReadOutputImage());
+			convergenceReport_->Write();
+		}
+	}
 }
 
 void RayTracer::Render(VkCommandBuffer commandBuffer, const size_t currentFrame, const uint32_t imageIndex)
 {
+	// Offscreen rendering has no camera controls, UI or benchmark.
+	if (IsHeadless())
+	{
+		Vulkan::RayTracing::Application::Render(commandBuffer, currentFrame, imageIndex);
+		return;
+	}
+
 	// Record delta time between calls to Render.
 	const auto prevTime = time_;
 	time_ = Window().GetTime();
 	const auto timeDelta = time_ - prevTime;
 
 	// Update the camera position / angle.
-	resetAccumulation_ = modelViewController_.UpdateCamera(cameraInitialSate_.ControlSpeed, timeDelta);
+	const bool cameraMoved = modelViewController_.UpdateCamera(cameraInitialSate_.ControlSpeed, timeDelta);
+
+	// With temporal reprojection, the accumulation restarts in this frame from the reprojected history rather than from
+	// nothing in the next one. The random sequences carry on where they were.
+	reprojectHistory_ = cameraMoved && CanReprojectHistory();
+	resetAccumulation_ = cameraMoved && !reprojectHistory_;
+
+	if (reprojectHistory_)
+	{
+		sampleOffset_ += totalNumberOfSamples_ - numberOfSamples_;
+		totalNumberOfSamples_ = numberOfSamples_;
+	}
 
 	// Check the current state of the benchmark, update it for the new frame.
 	CheckAndUpdateBenchmarkState(prevTime);
@@ -177,14 +351,20 @@ void RayTracer::Render(VkCommandBuffer commandBuffer, const size_t currentFrame,
 			/ (timeDelta * 1000000000));
 
 		stats.TotalSamples = totalNumberOfSamples_;
+		stats.AveragePathLength = static_cast<float>(AveragePathLength());
 	}
+
+	stats.Memory = Device().MemoryPool().GetStatistics();
+	stats.GpuScopes = &GpuProfiler().Scopes();
 	
 	// RenderDoc integration status
 	stats.RenderDocAvailable = renderDocManager_->IsAvailable();
 	stats.RenderDocCapturing = renderDocManager_->IsCapturing();
 	stats.RenderDocInfo = renderDocManager_->GetLastCaptureInfo();
 
+	GpuProfiler().BeginScope(commandBuffer, "UI");
 	userInterface_->Render(commandBuffer, SwapChainFrameBuffer(imageIndex), stats);
+	GpuProfiler().EndScope(commandBuffer);
 }
 
 void RayTracer::OnKey(int key, int scancode, int action, int mods)
@@ -293,7 +473,9 @@ void RayTracer::OnScroll(const double xoffset, const double yoffset)
 
 void RayTracer::LoadScene(const uint32_t sceneIndex)
 {
-	auto [models, textures] = SceneList::AllScenes[sceneIndex].second(cameraInitialSate_);
+	const auto timer = std::chrono::high_resolution_clock::now();
+
+	auto [models, instances, textures] = SceneList::AllScenes[sceneIndex].second(cameraInitialSate_);
 
 	// If there are no texture, add a dummy one. It makes the pipeline setup a lot easier.
 	if (textures.empty())
@@ -301,9 +483,15 @@ void RayTracer::LoadScene(const uint32_t sceneIndex)
 		textures.push_back(Assets::Texture::LoadTexture("../assets/textures/white.png", Vulkan::SamplerConfig()));
 	}
 	
-	scene_.reset(new Assets::Scene(CommandPool(), std::move(models), std::move(textures)));
+	scene_.reset(new Assets::Scene(CommandPool(), std::move(models), std::move(instances), std::move(textures)));
 	sceneIndex_ = sceneIndex;
 
+	// Headless and benchmark runs must not measure or save frames rendered with placeholder textures.
+	if (IsHeadless() || userSettings_.Benchmark)
+	{
+		scene_->WaitForTextures();
+	}
+
 	userSettings_.FieldOfView = cameraInitialSate_.FieldOfView;
 	userSettings_.Aperture = cameraInitialSate_.Aperture;
 	userSettings_.FocusDistance = cameraInitialSate_.FocusDistance;
@@ -312,6 +500,18 @@ void RayTracer::LoadScene(const uint32_t sceneIndex)
 
 	periodTotalFrames_ = 0;
 	resetAccumulation_ = true;
+
+	sceneLoadTime_ = std::chrono::duration<double, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - timer).count();
+}
+
+void RayTracer::BuildAccelerationStructures()
+{
+	const auto timer = std::chrono::high_resolution_clock::now();
+
+	CreateAccelerationStructures(userSettings_.CompactAccelerationStructures);
+	scene_->WaitForUpload();
+
+	accelerationStructureBuildTime_ = std::chrono::duration<double, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - timer).count();
 }
 
 void RayTracer::CheckAndUpdateBenchmarkState(double prevTime)
@@ -328,6 +528,33 @@ void RayTracer::CheckAndUpdateBenchmarkState(double prevTime)
 		std::cout << "Benchmark: Start scene #" << sceneIndex_ << " '" << SceneList::AllScenes[sceneIndex_].first << "'" << std::endl;
 		sceneInitialTime_ = time_;
 		periodInitialTime_ = time_;
+
+		if (benchmarkReport_)
+		{
+			const auto extent = SwapChain().Extent();
+			benchmarkReport_->BeginScene({
+				SceneList::AllScenes[sceneIndex_].first,
+				GetWavefrontSettings().Enabled ? "wavefront" : "pipeline",
+				extent.width,
+				extent.height,
+				userSettings_.NumberOfSamples,
+				userSettings_.NumberOfBounces,
+				sceneLoadTime_,
+				accelerationStructureBuildTime_ });
+		}
+	}
+	else if (benchmarkReport_ && numberOfSamples_ != 0)
+	{
+		const auto extent = SwapChain().Extent();
+		benchmarkReport_->AddFrame(time_ - prevTime, uint64_t(extent.width) * extent.height * numberOfSamples_, AveragePathLength());
+
+		for (const auto& scope : GpuProfiler().Scopes())
+		{
+			if (scope.Active)
+			{
+				benchmarkReport_->AddGpuTime(scope.Name, scope.Milliseconds);
+			}
+		}
 	}
 
 	// Print out the frame rate at regular intervals.
@@ -353,6 +580,12 @@ void RayTracer::CheckAndUpdateBenchmarkState(double prevTime)
 
 		if (timeLimitReached || sampleLimitReached)
 		{
+			if (benchmarkReport_)
+			{
+				benchmarkReport_->EndScene();
+				benchmarkReport_->Write();
+			}
+
 			if (!userSettings_.BenchmarkNextScenes || static_cast<size_t>(userSettings_.SceneIndex) == SceneList::AllScenes.size() - 1)
 			{
 				Window().Close();
@@ -366,6 +599,11 @@ void RayTracer::CheckAndUpdateBenchmarkState(double prevTime)
 
 void RayTracer::CheckFramebufferSize() const
 {
+	if (IsHeadless())
+	{
+		return;
+	}
+
 	// Check the framebuffer size when requesting a fullscreen window, as it's not guaranteed to match.
 	const auto& cfg = Window().Config();
 	const auto fbSize = Window().FramebufferSize();
@@ -381,3 +619,17 @@ void RayTracer::CheckFramebufferSize() const
 		Throw(std::runtime_error(out.str()));
 	}
 }
+
+bool RayTracer::CanReprojectHistory() const
+{
+	// There must be samples from previous frames, and the output must be the accumulated image (not a debug view).
+	return
+		userSettings_.TemporalReprojection &&
+		userSettings_.IsRayTraced &&
+		!GetWavefrontSettings().Enabled &&
+		userSettings_.AccumulateRays &&
+		!userSettings_.ShowHeatmap &&
+		!userSettings_.ShowSampleDistribution &&
+		numberOfSamples_ != 0 &&
+		totalNumberOfSamples_ != numberOfSamples_;
+}
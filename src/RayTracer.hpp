@@ -19,6 +19,11 @@ protected:
 
 	const Assets::Scene& GetScene() const override { return *scene_; }
 	Assets::UniformBufferObject GetUniformBufferObject(VkExtent2D extent) const override;
+	Vulkan::RayTracing::RayTracingPipeline::PushConstants GetPushConstants() const override;
+	Vulkan::RayTracing::Denoiser::Settings GetDenoiserSettings() const override;
+	Vulkan::RayTracing::TemporalReprojection::Settings GetTemporalReprojectionSettings() const override;
+	Vulkan::RayTracing::AdaptiveSampler::Settings GetAdaptiveSamplingSettings() const override;
+	Vulkan::RayTracing::WavefrontPathTracer::Settings GetWavefrontSettings() const override;
 
 	void SetPhysicalDevice(
 		VkPhysicalDevice physicalDevice, 
@@ -27,6 +32,7 @@ protected:
 		void* nextDeviceFeatures) override;
 
 	void OnDeviceSet() override;
+	bool IsOffscreenRenderComplete() const override;
 	void CreateSwapChain() override;
 	void DeleteSwapChain() override;
 	void DrawFrame() override;
@@ -40,8 +46,10 @@ protected:
 private:
 
 	void LoadScene(uint32_t sceneIndex);
+	void BuildAccelerationStructures();
 	void CheckAndUpdateBenchmarkState(double prevTime);
 	void CheckFramebufferSize() const;
+	bool CanReprojectHistory() const;
 
 	uint32_t sceneIndex_{};
 	UserSettings userSettings_{};
@@ -49,19 +57,32 @@ private:
 	SceneList::CameraInitialSate cameraInitialSate_{};
 	ModelViewController modelViewController_{};
 
-	std::unique_ptr<const Assets::Scene> scene_;
+	std::unique_ptr<Assets::Scene> scene_;
 	std::unique_ptr<class UserInterface> userInterface_;
 
 	double time_{};
 
 	uint32_t totalNumberOfSamples_{};
 	uint32_t numberOfSamples_{};
+	uint32_t sampleOffset_{};
 	bool resetAccumulation_{};
+	bool reprojectHistory_{};
+
+	// Camera of the previous frame, for the temporal reprojection.
+	glm::mat4 previousModelView_{1};
+	glm::mat4 previousProjection_{1};
 
 	// Benchmark stats
 	double sceneInitialTime_{};
 	double periodInitialTime_{};
 	uint32_t periodTotalFrames_{};
+	double sceneLoadTime_{};
+	double accelerationStructureBuildTime_{};
+	std::unique_ptr<class BenchmarkReport> benchmarkReport_;
+
+	// Headless error against a reference image
+	std::unique_ptr<class ConvergenceReport> convergenceReport_;
+	double convergenceTime_{};
 
 	// RenderDoc integration for graphics debugging
 	std::unique_ptr<Utilities::RenderDocManager> renderDocManager_;
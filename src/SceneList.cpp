@@ -1,6 +1,7 @@
 #include "SceneList.hpp"
 #include "Assets/Material.hpp"
 #include "Assets/Model.hpp"
+#include "Assets/ModelInstance.hpp"
 #include "Assets/Texture.hpp"
 #include <functional>
 #include <random>
@@ -9,6 +10,7 @@
 using namespace glm;
 using Assets::Material;
 using Assets::Model;
+using Assets::ModelInstance;
 using Assets::Texture;
 
 namespace
@@ -37,6 +39,7 @@ SceneAssets SceneList::InteractiveGalleryScene(CameraInitialSate& camera)
 
 	const auto identity = mat4(1);
 	std::vector<Model> models;
+	std::vector<ModelInstance> instances;
 	std::vector<Texture> textures;
 
 	// Gallery floor (white - Cornell Box style)
@@ -82,31 +85,28 @@ SceneAssets SceneList::InteractiveGalleryScene(CameraInitialSate& camera)
 		Material::Lambertian(vec3(0.73f, 0.73f, 0.73f))
 	));
 
+	// Each model so far is placed once, as is.
+	for (uint32_t i = 0; i != models.size(); ++i)
+	{
+		instances.emplace_back(i);
+	}
+
 	// Central lighting panels (emissive) - Much more realistic lighting
+	// A single panel model shared by the four instances.
+	const auto lightPanelId = static_cast<uint32_t>(models.size());
 	models.push_back(Model::CreateBox(
-		vec3(-3, 7.4f, -3), 
-		vec3(-1, 7.45f, -1), 
-		Material::DiffuseLight(vec3(0.8f, 0.8f, 0.7f))
-	));
-	
-	models.push_back(Model::CreateBox(
-		vec3(1, 7.4f, -3), 
-		vec3(3, 7.45f, -1), 
-		Material::DiffuseLight(vec3(0.8f, 0.8f, 0.7f))
-	));
-	
-	models.push_back(Model::CreateBox(
-		vec3(-3, 7.4f, 1), 
-		vec3(-1, 7.45f, 3), 
-		Material::DiffuseLight(vec3(0.8f, 0.8f, 0.7f))
-	));
-	
-	models.push_back(Model::CreateBox(
-		vec3(1, 7.4f, 1), 
-		vec3(3, 7.45f, 3), 
+		vec3(-1, 7.4f, -1), 
+		vec3(1, 7.45f, 1), 
 		Material::DiffuseLight(vec3(0.8f, 0.8f, 0.7f))
 	));
 
+	instances.emplace_back(lightPanelId, translate(identity, vec3(-2, 0, -2)));
+	instances.emplace_back(lightPanelId, translate(identity, vec3(2, 0, -2)));
+	instances.emplace_back(lightPanelId, translate(identity, vec3(-2, 0, 2)));
+	instances.emplace_back(lightPanelId, translate(identity, vec3(2, 0, 2)));
+
+	const auto firstUniqueModel = static_cast<uint32_t>(models.size());
+
 	// Art installations and sculptures
 
 	// 1. Crystal sculpture
@@ -181,10 +181,15 @@ SceneAssets SceneList::InteractiveGalleryScene(CameraInitialSate& camera)
 	
 	models.push_back(std::move(lucy));
 
+	for (uint32_t i = firstUniqueModel; i != models.size(); ++i)
+	{
+		instances.emplace_back(i);
+	}
+
 	// Load textures
-	textures.push_back(Texture::LoadTexture("../assets/textures/land_ocean_ice_cloud_2048.png", Vulkan::SamplerConfig()));
-	textures.push_back(Texture::LoadTexture("../assets/textures/2k_mars.jpg", Vulkan::SamplerConfig()));
-	textures.push_back(Texture::LoadTexture("../assets/textures/2k_moon.jpg", Vulkan::SamplerConfig()));
+	textures.push_back(Texture::FromFile("../assets/textures/land_ocean_ice_cloud_2048.png", Vulkan::SamplerConfig()));
+	textures.push_back(Texture::FromFile("../assets/textures/2k_mars.jpg", Vulkan::SamplerConfig()));
+	textures.push_back(Texture::FromFile("../assets/textures/2k_moon.jpg", Vulkan::SamplerConfig()));
 
-	return std::forward_as_tuple(std::move(models), std::move(textures));
+	return std::forward_as_tuple(std::move(models), std::move(instances), std::move(textures));
 }
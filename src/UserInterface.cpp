@@ -6,6 +6,7 @@
 #include "Vulkan/Device.hpp"
 #include "Vulkan/FrameBuffer.hpp"
 #include "Vulkan/Instance.hpp"
+#include "Vulkan/PipelineCache.hpp"
 #include "Vulkan/RenderPass.hpp"
 #include "Vulkan/SingleTimeCommands.hpp"
 #include "Vulkan/Surface.hpp"
@@ -18,6 +19,7 @@
 #include <imgui_impl_vulkan.h>
 
 #include <array>
+#include <cstdio>
 
 namespace
 {
@@ -34,6 +36,7 @@ UserInterface::UserInterface(
 	Vulkan::CommandPool& commandPool, 
 	const Vulkan::SwapChain& swapChain, 
 	const Vulkan::DepthBuffer& depthBuffer,
+	const Vulkan::PipelineCache& pipelineCache,
 	UserSettings& userSettings) :
 	userSettings_(userSettings)
 {
@@ -65,7 +68,7 @@ UserInterface::UserInterface(
 	vulkanInit.Device = device.Handle();
 	vulkanInit.QueueFamily = device.GraphicsFamilyIndex();
 	vulkanInit.Queue = device.GraphicsQueue();
-	vulkanInit.PipelineCache = nullptr;
+	vulkanInit.PipelineCache = pipelineCache.Handle();
 	vulkanInit.DescriptorPool = descriptorPool_->Handle();
 	vulkanInit.RenderPass = renderPass_->Handle();
 	vulkanInit.MinImageCount = swapChain.MinImageCount();
@@ -207,6 +210,27 @@ void UserInterface::DrawSettings()
 		ImGui::Separator();
 		ImGui::Checkbox("🔥 Enable Real-time Ray Tracing", &Settings().IsRayTraced);
 		ImGui::Checkbox("📈 Accumulate Samples", &Settings().AccumulateRays);
+		ImGui::Checkbox("💡 Next Event Estimation (MIS)", &Settings().NextEventEstimation);
+
+		const char* samplers[] = { "Random (LCG)", "Sobol (Owen scrambled)" };
+		int sampler = static_cast<int>(Settings().Sampler);
+		ImGui::Text("Sampler:");
+		ImGui::PushItemWidth(-1);
+		if (ImGui::Combo("##Sampler", &sampler, samplers, IM_ARRAYSIZE(samplers)))
+		{
+			Settings().Sampler = static_cast<uint32_t>(sampler);
+		}
+		ImGui::PopItemWidth();
+
+		const char* engines[] = { "Ray tracing pipeline", "Wavefront (ray queries)" };
+		int engine = static_cast<int>(Settings().Engine);
+		ImGui::Text("Engine:");
+		ImGui::PushItemWidth(-1);
+		if (ImGui::Combo("##Engine", &engine, engines, IM_ARRAYSIZE(engines)))
+		{
+			Settings().Engine = static_cast<uint32_t>(engine);
+		}
+		ImGui::PopItemWidth();
 		
 		uint32_t min = 1, max = 128;
 		ImGui::Text("Samples per Pixel:");
@@ -215,6 +239,22 @@ void UserInterface::DrawSettings()
 		min = 1, max = 32;
 		ImGui::Text("Light Bounces:");
 		ImGui::SliderScalar("##Bounces", ImGuiDataType_U32, &Settings().NumberOfBounces, &min, &max, "%d bounces");
+
+		ImGui::Checkbox("🎲 Russian Roulette", &Settings().RussianRoulette);
+		min = 0, max = 32;
+		ImGui::SliderScalar("##RouletteDepth", ImGuiDataType_U32, &Settings().RussianRouletteMinDepth, &min, &max, "from bounce %d");
+		ImGui::SliderFloat("##RouletteSurvival", &Settings().RussianRouletteMaxSurvival, 0.05f, 1.0f, "max survival %.2f");
+
+		ImGui::Checkbox("✨ A-Trous Denoiser", &Settings().Denoise);
+		min = 1, max = 5;
+		ImGui::SliderScalar("##DenoiseIterations", ImGuiDataType_U32, &Settings().DenoiseIterations, &min, &max, "%d iterations");
+
+		ImGui::Checkbox("🎞️  Temporal Reprojection", &Settings().TemporalReprojection);
+		min = 1, max = 256;
+		ImGui::SliderScalar("##MaxHistory", ImGuiDataType_U32, &Settings().MaxHistoryLength, &min, &max, "history of %d spp");
+
+		ImGui::Checkbox("🎯 Adaptive Sampling", &Settings().AdaptiveSampling);
+		ImGui::SliderFloat("##AdaptiveThreshold", &Settings().AdaptiveThreshold, 0.001f, 0.1f, "error below %.3f", ImGuiSliderFlags_Logarithmic);
 		ImGui::Spacing();
 
 		// Camera Controls
@@ -230,6 +270,7 @@ void UserInterface::DrawSettings()
 		ImGui::Separator();
 		ImGui::Checkbox("🌡️  Show GPU Heatmap", &Settings().ShowHeatmap);
 		ImGui::SliderFloat("Heatmap Scale", &Settings().HeatmapScale, 0.10f, 10.0f, "%.2fx", ImGuiSliderFlags_Logarithmic);
+		ImGui::Checkbox("🎯 Show Sample Distribution", &Settings().ShowSampleDistribution);
 		ImGui::Spacing();
 
 		// Controls Help
@@ -353,6 +394,38 @@ void UserInterface::DrawOverlay(const Statistics& statistics)
 		// Ray tracing performance
 		ImGui::Text("Ray Throughput: %.2f Gr/s", statistics.RayRate);
 		ImGui::Text("Accumulated Samples: %u", statistics.TotalSamples);
+		ImGui::Text("Average Path Length: %.2f segments", statistics.AveragePathLength);
+
+		// Device memory pool usage
+		ImGui::Text("Device Memory: %.1f / %.1f MiB", statistics.Memory.UsedBytes / (1024.0f * 1024.0f), statistics.Memory.BlockBytes / (1024.0f * 1024.0f));
+		ImGui::Text("Memory Blocks: %u (%u allocations, %u fragments)", statistics.Memory.BlockCount, statistics.Memory.AllocationCount, statistics.Memory.FreeRangeCount);
+
+		// GPU pass timings, the graphs share a scale so that passes can be compared at a glance.
+		if (statistics.GpuScopes != nullptr && !statistics.GpuScopes->empty())
+		{
+			float maxMilliseconds = 1.0f;
+
+			for (const auto& scope : *statistics.GpuScopes)
+			{
+				for (const float milliseconds : scope.History)
+				{
+					maxMilliseconds = milliseconds > maxMilliseconds ? milliseconds : maxMilliseconds;
+				}
+			}
+
+			ImGui::Spacing();
+			ImGui::TextColored(ImVec4(0.7f, 0.7f, 1.0f, 1.0f), "GPU Passes:");
+
+			for (const auto& scope : *statistics.GpuScopes)
+			{
+				char overlay[32];
+				std::snprintf(overlay, sizeof overlay, scope.Active ? "%.2f ms" : "%.2f ms (idle)", scope.Milliseconds);
+
+				ImGui::PlotLines(
+					scope.Name, scope.History.data(), static_cast<int>(scope.History.size()), static_cast<int>(scope.HistoryOffset),
+					overlay, 0.0f, maxMilliseconds, ImVec2(0, 32));
+			}
+		}
 		
 		// Performance gauge visual
 		ImGui::Spacing();
@@ -1,7 +1,10 @@
 #pragma once
+#include "Vulkan/DeviceMemoryPool.hpp"
+#include "Vulkan/GpuProfiler.hpp"
 #include "Vulkan/Vulkan.hpp"
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace Vulkan
 {
@@ -9,6 +12,7 @@ namespace Vulkan
 	class DepthBuffer;
 	class DescriptorPool;
 	class FrameBuffer;
+	class PipelineCache;
 	class RenderPass;
 	class SwapChain;
 }
@@ -21,6 +25,12 @@ struct Statistics final
 	float FrameRate;
 	float RayRate;
 	uint32_t TotalSamples;
+	float AveragePathLength;
+
+	Vulkan::DeviceMemoryPool::Statistics Memory;
+
+	// GPU pass timings, a few frames behind.
+	const std::vector<Vulkan::GpuProfiler::Scope>* GpuScopes;
 	
 	// RenderDoc integration status
 	bool RenderDocAvailable;
@@ -38,6 +48,7 @@ public:
 		Vulkan::CommandPool& commandPool, 
 		const Vulkan::SwapChain& swapChain, 
 		const Vulkan::DepthBuffer& depthBuffer,
+		const Vulkan::PipelineCache& pipelineCache,
 		UserSettings& userSettings);
 	~UserInterface();
 
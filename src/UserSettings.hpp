@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <string>
+
 struct UserSettings final
 {
 	// Application
@@ -8,6 +11,12 @@ struct UserSettings final
 	// Benchmark
 	bool BenchmarkNextScenes{};
 	uint32_t BenchmarkMaxTime{};
+	uint32_t BenchmarkWarmupFrames{};
+	std::string BenchmarkReport;
+
+	// Convergence (headless)
+	std::string ReferenceImage;
+	std::string ConvergenceReport;
 	
 	// Scene
 	int SceneIndex;
@@ -18,6 +27,26 @@ struct UserSettings final
 	uint32_t NumberOfSamples;
 	uint32_t NumberOfBounces;
 	uint32_t MaxNumberOfSamples;
+	bool CompactAccelerationStructures;
+	bool NextEventEstimation;
+	bool RussianRoulette;
+	uint32_t RussianRouletteMinDepth;
+	float RussianRouletteMaxSurvival;
+	uint32_t Sampler;
+	uint32_t Engine;
+
+	// Denoiser
+	bool Denoise;
+	uint32_t DenoiseIterations;
+
+	// Temporal reprojection
+	bool TemporalReprojection;
+	uint32_t MaxHistoryLength;
+
+	// Adaptive sampling
+	bool AdaptiveSampling;
+	float AdaptiveThreshold;
+	bool ShowSampleDistribution;
 
 	// Camera
 	float FieldOfView;
@@ -32,6 +61,9 @@ struct UserSettings final
 	bool ShowSettings;
 	bool ShowOverlay;
 
+	inline const static uint32_t EngineRayTracingPipeline = 0;
+	inline const static uint32_t EngineWavefront = 1;
+
 	inline const static float FieldOfViewMinValue = 10.0f;
 	inline const static float FieldOfViewMaxValue = 90.0f;
 
@@ -41,6 +73,13 @@ struct UserSettings final
 			IsRayTraced != prev.IsRayTraced ||
 			AccumulateRays != prev.AccumulateRays ||
 			NumberOfBounces != prev.NumberOfBounces ||
+			NextEventEstimation != prev.NextEventEstimation ||
+			RussianRoulette != prev.RussianRoulette ||
+			RussianRouletteMinDepth != prev.RussianRouletteMinDepth ||
+			RussianRouletteMaxSurvival != prev.RussianRouletteMaxSurvival ||
+			Sampler != prev.Sampler ||
+			Engine != prev.Engine ||
+			TemporalReprojection != prev.TemporalReprojection ||
 			FieldOfView != prev.FieldOfView ||
 			Aperture != prev.Aperture ||
 			FocusDistance != prev.FocusDistance;
@@ -0,0 +1,114 @@
+#include "MappedFile.hpp"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Utilities {
+
+MappedFile::MappedFile(const std::string& filename)
+{
+#ifdef WIN32
+	const HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+
+	LARGE_INTEGER size = {};
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return;
+	}
+
+	const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		return;
+	}
+
+	data_ = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data_ == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return;
+	}
+
+	file_ = file;
+	mapping_ = mapping;
+	size_ = static_cast<size_t>(size.QuadPart);
+#else
+	const int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return;
+	}
+
+	struct stat info = {};
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		close(file);
+		return;
+	}
+
+	void* const data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+	// The mapping keeps its own reference to the file.
+	close(file);
+
+	if (data == MAP_FAILED)
+	{
+		return;
+	}
+
+	data_ = data;
+	size_ = static_cast<size_t>(info.st_size);
+#endif
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept :
+	data_(other.data_),
+	size_(other.size_)
+#ifdef WIN32
+	,
+	file_(other.file_),
+	mapping_(other.mapping_)
+#endif
+{
+	other.data_ = nullptr;
+	other.size_ = 0;
+
+#ifdef WIN32
+	other.file_ = nullptr;
+	other.mapping_ = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	if (data_ == nullptr)
+	{
+		return;
+	}
+
+#ifdef WIN32
+	UnmapViewOfFile(data_);
+	CloseHandle(mapping_);
+	CloseHandle(file_);
+#else
+	munmap(data_, size_);
+#endif
+
+	data_ = nullptr;
+	size_ = 0;
+}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace Utilities
+{
+	// Read-only memory mapping of a whole file. Default constructed or failed mappings are empty.
+	class MappedFile final
+	{
+	public:
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator = (const MappedFile&) = delete;
+		MappedFile& operator = (MappedFile&&) = delete;
+
+		MappedFile() = default;
+		explicit MappedFile(const std::string& filename);
+		MappedFile(MappedFile&& other) noexcept;
+		~MappedFile();
+
+		bool IsOpen() const { return data_ != nullptr; }
+		const unsigned char* Data() const { return static_cast<const unsigned char*>(data_); }
+		size_t Size() const { return size_; }
+
+	private:
+
+		void* data_{};
+		size_t size_{};
+
+#ifdef WIN32
+		void* file_{};
+		void* mapping_{};
+#endif
+	};
+
+}
@@ -7,8 +7,10 @@
 #include "Device.hpp"
 #include "Fence.hpp"
 #include "FrameBuffer.hpp"
+#include "GpuProfiler.hpp"
 #include "GraphicsPipeline.hpp"
 #include "Instance.hpp"
+#include "PipelineCache.hpp"
 #include "PipelineLayout.hpp"
 #include "RenderPass.hpp"
 #include "Semaphore.hpp"
@@ -23,24 +25,32 @@
 
 namespace Vulkan {
 
+namespace
+{
+	constexpr const char* PipelineCacheFilename = "pipeline.cache";
+}
+
 Application::Application(const WindowConfig& windowConfig, const VkPresentModeKHR presentMode, const bool enableValidationLayers) :
-	presentMode_(presentMode)
+	presentMode_(presentMode),
+	offscreenExtent_{ windowConfig.Width, windowConfig.Height }
 {
 	const auto validationLayers = enableValidationLayers
 		? std::vector<const char*>{"VK_LAYER_KHRONOS_validation"}
 		: std::vector<const char*>();
 
-	window_.reset(new class Window(windowConfig));
-	instance_.reset(new Instance(*window_, validationLayers, VK_API_VERSION_1_2));
+	window_.reset(windowConfig.Headless ? nullptr : new class Window(windowConfig));
+	instance_.reset(new Instance(window_.get(), validationLayers, VK_API_VERSION_1_2));
 	debugUtilsMessenger_.reset(enableValidationLayers ? new DebugUtilsMessenger(*instance_, VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT) : nullptr);
-	surface_.reset(new Surface(*instance_));
+	surface_.reset(window_ ? new Surface(*instance_) : nullptr);
 }
 
 Application::~Application()
 {
 	Application::DeleteSwapChain();
 
+	uniformBuffer_.reset();
 	commandPool_.reset();
+	pipelineCache_.reset();
 	device_.reset();
 	surface_.reset();
 	debugUtilsMessenger_.reset();
@@ -70,11 +80,13 @@ void Application::SetPhysicalDevice(VkPhysicalDevice physicalDevice)
 		Throw(std::logic_error("physical device has already been set"));
 	}
 
-	std::vector<const char*> requiredExtensions = 
+	std::vector<const char*> requiredExtensions;
+
+	// VK_KHR_swapchain, only needed when presenting to a window.
+	if (!IsHeadless())
 	{
-		// VK_KHR_swapchain
-		VK_KHR_SWAPCHAIN_EXTENSION_NAME
-	};
+		requiredExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+	}
 
 	VkPhysicalDeviceFeatures deviceFeatures = {};
 	
@@ -94,6 +106,18 @@ void Application::Run()
 
 	currentFrame_ = 0;
 
+	if (IsHeadless())
+	{
+		while (!IsOffscreenRenderComplete())
+		{
+			DrawFrame();
+		}
+
+		device_->WaitIdle();
+		pipelineCache_->Save();
+		return;
+	}
+
 	window_->DrawFrame = [this]() { DrawFrame(); };
 	window_->OnKey = [this](const int key, const int scancode, const int action, const int mods) { OnKey(key, scancode, action, mods); };
 	window_->OnCursorPosition = [this](const double xpos, const double ypos) { OnCursorPosition(xpos, ypos); };
@@ -101,6 +125,7 @@ void Application::Run()
 	window_->OnScroll = [this](const double xoffset, const double yoffset) { OnScroll(xoffset, yoffset); };
 	window_->Run();
 	device_->WaitIdle();
+	pipelineCache_->Save();
 }
 
 void Application::SetPhysicalDevice(
@@ -109,7 +134,8 @@ void Application::SetPhysicalDevice(
 	VkPhysicalDeviceFeatures& deviceFeatures,
 	void* nextDeviceFeatures)
 {
-	device_.reset(new class Device(physicalDevice, *surface_, requiredExtensions, deviceFeatures, nextDeviceFeatures));
+	device_.reset(new class Device(physicalDevice, *instance_, surface_.get(), requiredExtensions, deviceFeatures, nextDeviceFeatures));
+	pipelineCache_.reset(new class PipelineCache(*device_, PipelineCacheFilename));
 	commandPool_.reset(new class CommandPool(*device_, device_->GraphicsFamilyIndex(), true));
 }
 
@@ -117,8 +143,23 @@ void Application::OnDeviceSet()
 {
 }
 
+VkExtent2D Application::Extent() const
+{
+	return IsHeadless() ? offscreenExtent_ : swapChain_->Extent();
+}
+
 void Application::CreateSwapChain()
 {
+	// Offscreen rendering only needs the per frame resources, with a single frame in flight.
+	if (IsHeadless())
+	{
+		inFlightFences_.emplace_back(*device_, true);
+		CreateUniformBuffer();
+		gpuProfiler_.reset(new class GpuProfiler(*device_, inFlightFences_.size()));
+		commandBuffers_.reset(new CommandBuffers(*commandPool_, 1));
+		return;
+	}
+
 	// Wait until the window is visible.
 	while (window_->IsMinimized())
 	{
@@ -128,22 +169,31 @@ void Application::CreateSwapChain()
 	swapChain_.reset(new class SwapChain(*device_, presentMode_));
 	depthBuffer_.reset(new class DepthBuffer(*commandPool_, swapChain_->Extent()));
 
-	for (size_t i = 0; i != swapChain_->ImageViews().size(); ++i)
+	for (size_t i = 0; i != MaxFramesInFlight; ++i)
 	{
 		imageAvailableSemaphores_.emplace_back(*device_);
-		renderFinishedSemaphores_.emplace_back(*device_);
 		inFlightFences_.emplace_back(*device_, true);
-		uniformBuffers_.emplace_back(*device_);
 	}
 
-	graphicsPipeline_.reset(new class GraphicsPipeline(*swapChain_, *depthBuffer_, uniformBuffers_, GetScene(), isWireFrame_));
+	// The presentation engine may still wait on the semaphore of an image, so these follow the images rather than the frames.
+	for (size_t i = 0; i != swapChain_->ImageViews().size(); ++i)
+	{
+		renderFinishedSemaphores_.emplace_back(*device_);
+	}
+
+	imagesInFlight_.assign(swapChain_->ImageViews().size(), nullptr);
+
+	CreateUniformBuffer();
+	gpuProfiler_.reset(new class GpuProfiler(*device_, inFlightFences_.size()));
+
+	graphicsPipeline_.reset(new class GraphicsPipeline(*swapChain_, *depthBuffer_, *pipelineCache_, *uniformBuffer_, GetScene(), isWireFrame_));
 
 	for (const auto& imageView : swapChain_->ImageViews())
 	{
 		swapChainFramebuffers_.emplace_back(*imageView, graphicsPipeline_->RenderPass());
 	}
 
-	commandBuffers_.reset(new CommandBuffers(*commandPool_, static_cast<uint32_t>(swapChainFramebuffers_.size())));
+	commandBuffers_.reset(new CommandBuffers(*commandPool_, static_cast<uint32_t>(inFlightFences_.size())));
 }
 
 void Application::DeleteSwapChain()
@@ -151,7 +201,8 @@ void Application::DeleteSwapChain()
 	commandBuffers_.reset();
 	swapChainFramebuffers_.clear();
 	graphicsPipeline_.reset();
-	uniformBuffers_.clear();
+	gpuProfiler_.reset();
+	imagesInFlight_.clear();
 	inFlightFences_.clear();
 	renderFinishedSemaphores_.clear();
 	imageAvailableSemaphores_.clear();
@@ -161,11 +212,16 @@ void Application::DeleteSwapChain()
 
 void Application::DrawFrame()
 {
+	if (IsHeadless())
+	{
+		DrawOffscreenFrame();
+		return;
+	}
+
 	constexpr auto noTimeout = std::numeric_limits<uint64_t>::max();
 
 	auto& inFlightFence = inFlightFences_[currentFrame_];
 	const auto imageAvailableSemaphore = imageAvailableSemaphores_[currentFrame_].Handle();
-	const auto renderFinishedSemaphore = renderFinishedSemaphores_[currentFrame_].Handle();
 
 	inFlightFence.Wait(noTimeout);
 
@@ -183,7 +239,18 @@ void Application::DrawFrame()
 		Throw(std::runtime_error(std::string("failed to acquire next image (") + ToString(result) + ")"));
 	}
 
+	// The image can still be in use by an older frame, the swap-chain does not hand them out in order.
+	if (imagesInFlight_[imageIndex] != nullptr)
+	{
+		imagesInFlight_[imageIndex]->Wait(noTimeout);
+	}
+
+	imagesInFlight_[imageIndex] = &inFlightFence;
+
+	const auto renderFinishedSemaphore = renderFinishedSemaphores_[imageIndex].Handle();
+
 	const auto commandBuffer = commandBuffers_->Begin(currentFrame_);
+	gpuProfiler_->BeginFrame(commandBuffer, currentFrame_);
 	Render(commandBuffer, currentFrame_, imageIndex);
 	commandBuffers_->End(currentFrame_);
 
@@ -251,40 +318,132 @@ void Application::Render(VkCommandBuffer commandBuffer, const size_t currentFram
 	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 	renderPassInfo.pClearValues = clearValues.data();
 
+	gpuProfiler_->BeginScope(commandBuffer, "Raster");
 	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 	{
 		const auto& scene = GetScene();
 
-		VkDescriptorSet descriptorSets[] = { graphicsPipeline_->DescriptorSet(currentFrame) };
-		VkBuffer vertexBuffers[] = { scene.VertexBuffer().Handle() };
+		VkDescriptorSet descriptorSets[] = { graphicsPipeline_->DescriptorSet() };
+		const uint32_t dynamicOffsets[] = { uniformBuffer_->SliceOffset(currentFrame) };
+		VkBuffer vertexBuffers[] = { scene.VertexBuffer().Handle(), scene.VertexAttributeBuffer().Handle() };
 		const VkBuffer indexBuffer = scene.IndexBuffer().Handle();
-		VkDeviceSize offsets[] = { 0 };
+		VkDeviceSize offsets[] = { 0, 0 };
 
 		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_->Handle());
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 0, nullptr);
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-		vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 1, dynamicOffsets);
+		vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
 
-		uint32_t vertexOffset = 0;
-		uint32_t indexOffset = 0;
+		VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
 
-		for (const auto& model : scene.Models())
+		for (size_t i = 0; i != scene.Instances().size(); ++i)
 		{
-			const auto vertexCount = static_cast<uint32_t>(model.NumberOfVertices());
-			const auto indexCount = static_cast<uint32_t>(model.NumberOfIndices());
-
-			vkCmdDrawIndexed(commandBuffer, indexCount, 1, indexOffset, vertexOffset, 0);
+			const auto& instance = scene.Instances()[i];
+			const auto& model = scene.Models()[instance.ModelId];
+
+			if (model.Procedural() != nullptr)
+			{
+				continue;
+			}
+
+			const auto& offsets = scene.InstanceOffsets()[i];
+			const auto& indices = scene.ModelIndexRanges()[instance.ModelId];
+
+			// The index buffer mixes 16 and 32-bit indices, rebind it whenever the width changes.
+			if (indices.IndexType != boundIndexType)
+			{
+				vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indices.IndexType);
+				boundIndexType = indices.IndexType;
+			}
+
+			GraphicsPipeline::PushConstants pushConstants = {};
+			pushConstants.Model = instance.Transform;
+			pushConstants.MaterialOverride = static_cast<int32_t>(offsets.z);
+			pushConstants.PrimitiveOffset = indices.FirstPrimitive;
+
+			vkCmdPushConstants(commandBuffer, graphicsPipeline_->PipelineLayout().Handle(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pushConstants), &pushConstants);
+			vkCmdDrawIndexed(commandBuffer, model.NumberOfIndices(), 1, offsets.x, offsets.y, 0);
+		}
 
-			vertexOffset += vertexCount;
-			indexOffset += indexCount;
+		// Procedural spheres are not tessellated, they all share the same proxy mesh.
+		if (scene.HasProcedurals())
+		{
+			const auto& proxyMesh = scene.ProceduralProxyMesh();
+
+			if (proxyMesh.Indices.IndexType != boundIndexType)
+			{
+				vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, proxyMesh.Indices.IndexType);
+			}
+
+			for (const auto& proxy : scene.ProceduralProxies())
+			{
+				GraphicsPipeline::PushConstants pushConstants = {};
+				pushConstants.Model = proxy.Transform;
+				pushConstants.MaterialOverride = static_cast<int32_t>(proxy.MaterialIndex);
+				pushConstants.PrimitiveOffset = proxyMesh.Indices.FirstPrimitive;
+
+				vkCmdPushConstants(commandBuffer, graphicsPipeline_->PipelineLayout().Handle(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pushConstants), &pushConstants);
+				vkCmdDrawIndexed(commandBuffer, proxyMesh.IndexCount, 1, proxyMesh.Indices.FirstIndex, static_cast<int32_t>(proxyMesh.VertexOffset), 0);
+			}
 		}
 	}
 	vkCmdEndRenderPass(commandBuffer);
+	gpuProfiler_->EndScope(commandBuffer);
+}
+
+void Application::UpdateTextureDescriptors()
+{
+	device_->WaitIdle();
+
+	if (graphicsPipeline_)
+	{
+		graphicsPipeline_->UpdateTextures(GetScene());
+	}
+}
+
+void Application::DrawOffscreenFrame()
+{
+	constexpr auto noTimeout = std::numeric_limits<uint64_t>::max();
+
+	auto& inFlightFence = inFlightFences_[currentFrame_];
+
+	inFlightFence.Wait(noTimeout);
+
+	const auto commandBuffer = commandBuffers_->Begin(currentFrame_);
+	gpuProfiler_->BeginFrame(commandBuffer, currentFrame_);
+	Render(commandBuffer, currentFrame_, 0);
+	commandBuffers_->End(currentFrame_);
+
+	UpdateUniformBuffer();
+
+	VkCommandBuffer commandBuffers[]{ commandBuffer };
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = commandBuffers;
+
+	inFlightFence.Reset();
+
+	Check(vkQueueSubmit(device_->GraphicsQueue(), 1, &submitInfo, inFlightFence.Handle()),
+		"submit draw command buffer");
+
+	currentFrame_ = (currentFrame_ + 1) % inFlightFences_.size();
+}
+
+void Application::CreateUniformBuffer()
+{
+	// The uniform buffer outlives swap-chain recreation so that pipelines bound to it can be kept, unless the
+	// number of frames in flight changes. The new buffer is created before the old one is destroyed.
+	if (!uniformBuffer_ || uniformBuffer_->SliceCount() != inFlightFences_.size())
+	{
+		uniformBuffer_.reset(new Assets::UniformBuffer(*device_, inFlightFences_.size()));
+	}
 }
 
 void Application::UpdateUniformBuffer()
 {
-	uniformBuffers_[currentFrame_].SetValue(GetUniformBufferObject(swapChain_->Extent()));
+	// The fence of this frame has been waited on, so the GPU is done reading its slice.
+	uniformBuffer_->SetValue(currentFrame_, GetUniformBufferObject(Extent()));
 }
 
 void Application::RecreateSwapChain()
@@ -32,6 +32,9 @@ namespace Vulkan
 
 		bool HasSwapChain() const { return swapChain_.operator bool(); }
 
+		// Headless applications have no window, and render offscreen until IsOffscreenRenderComplete().
+		bool IsHeadless() const { return !window_; }
+
 		void SetPhysicalDevice(VkPhysicalDevice physicalDevice);
 		void Run();
 
@@ -40,10 +43,14 @@ namespace Vulkan
 		Application(const WindowConfig& windowConfig, VkPresentModeKHR presentMode, bool enableValidationLayers);
 
 		const class Device& Device() const { return *device_; }
+		VkExtent2D Extent() const;
 		class CommandPool& CommandPool() { return *commandPool_; }
+		const class PipelineCache& PipelineCache() const { return *pipelineCache_; }
 		const class DepthBuffer& DepthBuffer() const { return *depthBuffer_; }
-		const std::vector<Assets::UniformBuffer>& UniformBuffers() const { return uniformBuffers_; }
+		const Assets::UniformBuffer& UniformBuffer() const { return *uniformBuffer_; }
 		const class GraphicsPipeline& GraphicsPipeline() const { return *graphicsPipeline_; }
+		class GpuProfiler& GpuProfiler() { return *gpuProfiler_; }
+		const class GpuProfiler& GpuProfiler() const { return *gpuProfiler_; }
 		const class FrameBuffer& SwapChainFrameBuffer(const size_t i) const { return swapChainFramebuffers_[i]; }
 		
 		virtual const Assets::Scene& GetScene() const = 0;
@@ -56,11 +63,16 @@ namespace Vulkan
 			void* nextDeviceFeatures);
 		
 		virtual void OnDeviceSet();
+		virtual bool IsOffscreenRenderComplete() const { return true; }
 		virtual void CreateSwapChain();
 		virtual void DeleteSwapChain();
 		virtual void DrawFrame();
 		virtual void Render(VkCommandBuffer commandBuffer, size_t currentFrame, uint32_t imageIndex);
 
+		// Rebinds the scene textures in every pipeline after Assets::Scene::UpdateTextures() swapped some in.
+		// Waits for the device to be idle, the descriptor sets may still be in use by frames in flight.
+		virtual void UpdateTextureDescriptors();
+
 		virtual void OnKey(int key, int scancode, int action, int mods) { }
 		virtual void OnCursorPosition(double xpos, double ypos) { }
 		virtual void OnMouseButton(int button, int action, int mods) { }
@@ -70,18 +82,26 @@ namespace Vulkan
 
 	private:
 
+		// Frames recorded ahead of the GPU, whatever the number of swap-chain images. Each one has its own fence,
+		// command buffer and uniform buffer slice. Offscreen rendering has a single frame in flight.
+		static constexpr size_t MaxFramesInFlight = 2;
+
+		void DrawOffscreenFrame();
+		void CreateUniformBuffer();
 		void UpdateUniformBuffer();
 		void RecreateSwapChain();
 
 		const VkPresentModeKHR presentMode_;
+		const VkExtent2D offscreenExtent_;
 		
 		std::unique_ptr<class Window> window_;
 		std::unique_ptr<class Instance> instance_;
 		std::unique_ptr<class DebugUtilsMessenger> debugUtilsMessenger_;
 		std::unique_ptr<class Surface> surface_;
 		std::unique_ptr<class Device> device_;
+		std::unique_ptr<class PipelineCache> pipelineCache_;
 		std::unique_ptr<class SwapChain> swapChain_;
-		std::vector<Assets::UniformBuffer> uniformBuffers_;
+		std::unique_ptr<Assets::UniformBuffer> uniformBuffer_;
 		std::unique_ptr<class DepthBuffer> depthBuffer_;
 		std::unique_ptr<class GraphicsPipeline> graphicsPipeline_;
 		std::vector<class FrameBuffer> swapChainFramebuffers_;
@@ -90,6 +110,8 @@ namespace Vulkan
 		std::vector<class Semaphore> imageAvailableSemaphores_;
 		std::vector<class Semaphore> renderFinishedSemaphores_;
 		std::vector<class Fence> inFlightFences_;
+		std::vector<const class Fence*> imagesInFlight_; // per swap-chain image, the fence of the frame last rendering to it
+		std::unique_ptr<class GpuProfiler> gpuProfiler_;
 
 		size_t currentFrame_{};
 	};
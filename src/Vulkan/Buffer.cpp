@@ -32,10 +32,19 @@ DeviceMemory Buffer::AllocateMemory(const VkMemoryPropertyFlags propertyFlags)
 
 DeviceMemory Buffer::AllocateMemory(const VkMemoryAllocateFlags allocateFlags, const VkMemoryPropertyFlags propertyFlags)
 {
-	const auto requirements = GetMemoryRequirements();
-	DeviceMemory memory(device_, requirements.size, requirements.memoryTypeBits, allocateFlags, propertyFlags);
+	DeviceMemory memory(device_, GetMemoryRequirements(), allocateFlags, propertyFlags, DeviceMemoryPool::ResourceType::Linear, DeviceMemoryPool::Strategy::FreeList);
 
-	Check(vkBindBufferMemory(device_.Handle(), buffer_, memory.Handle(), 0),
+	Check(vkBindBufferMemory(device_.Handle(), buffer_, memory.Handle(), memory.Offset()),
+		"bind buffer memory");
+
+	return memory;
+}
+
+DeviceMemory Buffer::AllocateStagingMemory()
+{
+	DeviceMemory memory(device_, GetMemoryRequirements(), 0, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, DeviceMemoryPool::ResourceType::Linear, DeviceMemoryPool::Strategy::Linear);
+
+	Check(vkBindBufferMemory(device_.Handle(), buffer_, memory.Handle(), memory.Offset()),
 		"bind buffer memory");
 
 	return memory;
@@ -22,6 +22,9 @@ namespace Vulkan
 
 		DeviceMemory AllocateMemory(VkMemoryPropertyFlags propertyFlags);
 		DeviceMemory AllocateMemory(VkMemoryAllocateFlags allocateFlags, VkMemoryPropertyFlags propertyFlags);
+
+		// Host visible memory for short lived staging buffers, linearly sub-allocated.
+		DeviceMemory AllocateStagingMemory();
 		VkMemoryRequirements GetMemoryRequirements() const;
 		VkDeviceAddress GetDeviceAddress() const;
 
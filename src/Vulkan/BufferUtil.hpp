@@ -4,6 +4,7 @@
 #include "CommandPool.hpp"
 #include "Device.hpp"
 #include "DeviceMemory.hpp"
+#include "UploadBatch.hpp"
 #include <cstring>
 #include <memory>
 #include <string>
@@ -27,6 +28,28 @@ namespace Vulkan
 			const std::vector<T>& content,
 			std::unique_ptr<Buffer>& buffer,
 			std::unique_ptr<DeviceMemory>& memory);
+
+		// Same as above, but the copy is only recorded into the batch.
+		template <class T>
+		static void CreateDeviceBuffer(
+			UploadBatch& uploadBatch,
+			const Device& device,
+			const char* name,
+			VkBufferUsageFlags usage,
+			const std::vector<T>& content,
+			std::unique_ptr<Buffer>& buffer,
+			std::unique_ptr<DeviceMemory>& memory);
+
+	private:
+
+		template <class T>
+		static void CreateBuffer(
+			const Device& device,
+			const char* name,
+			VkBufferUsageFlags usage,
+			const std::vector<T>& content,
+			std::unique_ptr<Buffer>& buffer,
+			std::unique_ptr<DeviceMemory>& memory);
 	};
 
 	template <class T>
@@ -37,7 +60,7 @@ namespace Vulkan
 		
 		// Create a temporary host-visible staging buffer.
 		auto stagingBuffer = std::make_unique<Buffer>(device, contentSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-		auto stagingBufferMemory = stagingBuffer->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		auto stagingBufferMemory = stagingBuffer->AllocateStagingMemory();
 
 		// Copy the host data into the staging buffer.
 		const auto data = stagingBufferMemory.Map(0, contentSize);
@@ -60,7 +83,33 @@ namespace Vulkan
 		std::unique_ptr<Buffer>& buffer,
 		std::unique_ptr<DeviceMemory>& memory)
 	{
-		const auto& device = commandPool.Device();
+		CreateBuffer(commandPool.Device(), name, usage, content, buffer, memory);
+		CopyFromStagingBuffer(commandPool, *buffer, content);
+	}
+
+	template <class T>
+	void BufferUtil::CreateDeviceBuffer(
+		UploadBatch& uploadBatch,
+		const Device& device,
+		const char* const name,
+		const VkBufferUsageFlags usage,
+		const std::vector<T>& content,
+		std::unique_ptr<Buffer>& buffer,
+		std::unique_ptr<DeviceMemory>& memory)
+	{
+		CreateBuffer(device, name, usage, content, buffer, memory);
+		uploadBatch.CopyToBuffer(content.data(), sizeof(content[0]) * content.size(), *buffer);
+	}
+
+	template <class T>
+	void BufferUtil::CreateBuffer(
+		const Device& device,
+		const char* const name,
+		const VkBufferUsageFlags usage,
+		const std::vector<T>& content,
+		std::unique_ptr<Buffer>& buffer,
+		std::unique_ptr<DeviceMemory>& memory)
+	{
 		const auto& debugUtils = device.DebugUtils();
 		const auto contentSize = sizeof(content[0]) * content.size();
 		const VkMemoryAllocateFlags allocateFlags = usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
@@ -71,8 +120,5 @@ namespace Vulkan
 		memory.reset(new DeviceMemory(buffer->AllocateMemory(allocateFlags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
 
 		debugUtils.SetObjectName(buffer->Handle(), (name + std::string(" Buffer")).c_str());
-		debugUtils.SetObjectName(memory->Handle(), (name + std::string(" Memory")).c_str());
-
-		CopyFromStagingBuffer(commandPool, *buffer, content);
 	}
 }
@@ -2,10 +2,13 @@
 
 #include "DebugUtils.hpp"
 #include "Vulkan.hpp"
+#include <memory>
 #include <vector>
 
 namespace Vulkan
 {
+	class DeviceMemoryPool;
+	class Instance;
 	class Surface;
 
 	class Device final
@@ -16,7 +19,8 @@ namespace Vulkan
 
 		Device(
 			VkPhysicalDevice physicalDevice, 
-			const Surface& surface, 
+			const Instance& instance,
+			const Surface* surface, 
 			const std::vector<const char*>& requiredExtensionsconst,
 			const VkPhysicalDeviceFeatures& deviceFeatures,
 			const void* nextDeviceFeatures);
@@ -24,10 +28,17 @@ namespace Vulkan
 		~Device();
 
 		VkPhysicalDevice PhysicalDevice() const { return physicalDevice_; }
-		const class Surface& Surface() const { return surface_; }
+		const class Instance& Instance() const { return instance_; }
+
+		// Headless devices have no surface, and present from the graphics queue family.
+		bool HasSurface() const { return surface_ != nullptr; }
+		const class Surface& Surface() const { return *surface_; }
 
 		const class DebugUtils& DebugUtils() const { return debugUtils_; }
 
+		// Every DeviceMemory is sub-allocated from this pool.
+		DeviceMemoryPool& MemoryPool() const { return *memoryPool_; }
+
 		uint32_t GraphicsFamilyIndex() const { return graphicsFamilyIndex_; }
 		//uint32_t ComputeFamilyIndex() const { return computeFamilyIndex_; }
 		uint32_t PresentFamilyIndex() const { return presentFamilyIndex_; }
@@ -45,12 +56,15 @@ namespace Vulkan
 		void CheckRequiredExtensions(VkPhysicalDevice physicalDevice, const std::vector<const char*>& requiredExtensions) const;
 
 		const VkPhysicalDevice physicalDevice_;
-		const class Surface& surface_;
+		const class Instance& instance_;
+		const class Surface* const surface_;
 
 		VULKAN_HANDLE(VkDevice, device_)
 
 		class DebugUtils debugUtils_;
 
+		std::unique_ptr<DeviceMemoryPool> memoryPool_;
+
 		uint32_t graphicsFamilyIndex_ {};
 		//uint32_t computeFamilyIndex_{};
 		uint32_t presentFamilyIndex_{};
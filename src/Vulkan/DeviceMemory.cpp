@@ -6,31 +6,23 @@ namespace Vulkan {
 
 DeviceMemory::DeviceMemory(
 	const class Device& device, 
-	const size_t size, 
-	const uint32_t memoryTypeBits,
+	const VkMemoryRequirements& requirements,
 	const VkMemoryAllocateFlags allocateFLags,
-	const VkMemoryPropertyFlags propertyFlags) :
-	device_(device)
+	const VkMemoryPropertyFlags propertyFlags,
+	const DeviceMemoryPool::ResourceType resourceType,
+	const DeviceMemoryPool::Strategy strategy) :
+	device_(device),
+	allocation_(device.MemoryPool().Allocate(requirements, allocateFLags, propertyFlags, resourceType, strategy))
 {
-	VkMemoryAllocateFlagsInfo flagsInfo = {};
-	flagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
-	flagsInfo.pNext = nullptr;
-	flagsInfo.flags = allocateFLags;
-	
-	VkMemoryAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.pNext = &flagsInfo;
-	allocInfo.allocationSize = size;
-	allocInfo.memoryTypeIndex = FindMemoryType(memoryTypeBits, propertyFlags);
-
-	Check(vkAllocateMemory(device.Handle(), &allocInfo, nullptr, &memory_),
-		"allocate memory");
+	memory_ = allocation_.Memory;
 }
 
 DeviceMemory::DeviceMemory(DeviceMemory&& other) noexcept :
 	device_(other.device_),
+	allocation_(other.allocation_),
 	memory_(other.memory_)
 {
+	other.allocation_ = {};
 	other.memory_ = nullptr;
 }
 
@@ -38,39 +30,29 @@ DeviceMemory::~DeviceMemory()
 {
 	if (memory_ != nullptr)
 	{
-		vkFreeMemory(device_.Handle(), memory_, nullptr);
+		device_.MemoryPool().Free(allocation_);
 		memory_ = nullptr;
 	}
 }
 
 void* DeviceMemory::Map(const size_t offset, const size_t size)
 {
-	void* data;
-	Check(vkMapMemory(device_.Handle(), memory_, offset, size, 0, &data),
-		"map memory");
+	if (allocation_.MappedData == nullptr)
+	{
+		Throw(std::runtime_error("cannot map memory that is not host visible"));
+	}
 
-	return data;
-}
+	if (offset + size > allocation_.Size)
+	{
+		Throw(std::out_of_range("memory map range is out of bounds"));
+	}
 
-void DeviceMemory::Unmap()
-{
-	vkUnmapMemory(device_.Handle(), memory_);
+	return static_cast<char*>(allocation_.MappedData) + offset;
 }
 
-uint32_t DeviceMemory::FindMemoryType(const uint32_t typeFilter, const VkMemoryPropertyFlags propertyFlags) const
+void DeviceMemory::Unmap()
 {
-	VkPhysicalDeviceMemoryProperties memProperties;
-	vkGetPhysicalDeviceMemoryProperties(device_.PhysicalDevice(), &memProperties);
-
-	for (uint32_t i = 0; i != memProperties.memoryTypeCount; ++i)
-	{
-		if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & propertyFlags) == propertyFlags)
-		{
-			return i;
-		}
-	}
-
-	Throw(std::runtime_error("failed to find suitable memory type"));
+	// The whole block stays mapped for its lifetime.
 }
 
 }
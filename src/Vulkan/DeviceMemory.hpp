@@ -1,11 +1,13 @@
 #pragma once
 
+#include "DeviceMemoryPool.hpp"
 #include "Vulkan.hpp"
 
 namespace Vulkan
 {
 	class Device;
 
+	// A range of memory sub-allocated from the device memory pool, returned to the pool on destruction.
 	class DeviceMemory final
 	{
 	public:
@@ -14,20 +16,30 @@ namespace Vulkan
 		DeviceMemory& operator = (const DeviceMemory&) = delete;
 		DeviceMemory& operator = (DeviceMemory&&) = delete;
 
-		DeviceMemory(const Device& device, size_t size, uint32_t memoryTypeBits, VkMemoryAllocateFlags allocateFLags, VkMemoryPropertyFlags propertyFlags);
+		DeviceMemory(
+			const Device& device, 
+			const VkMemoryRequirements& requirements, 
+			VkMemoryAllocateFlags allocateFLags, 
+			VkMemoryPropertyFlags propertyFlags,
+			DeviceMemoryPool::ResourceType resourceType,
+			DeviceMemoryPool::Strategy strategy);
 		DeviceMemory(DeviceMemory&& other) noexcept;
 		~DeviceMemory();
 
 		const class Device& Device() const { return device_; }
 
+		// Offset of this allocation within the VkDeviceMemory block, to be used when binding.
+		VkDeviceSize Offset() const { return allocation_.Offset; }
+		VkDeviceSize Size() const { return allocation_.Size; }
+
+		// Host visible blocks stay mapped, offsets are relative to this allocation.
 		void* Map(size_t offset, size_t size);
 		void Unmap();
 
 	private:
 
-		uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
-
 		const class Device& device_;
+		DeviceMemoryPool::Allocation allocation_;
 
 		VULKAN_HANDLE(VkDeviceMemory, memory_)
 	};
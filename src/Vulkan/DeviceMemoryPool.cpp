@@ -0,0 +1,333 @@
+#include "DeviceMemoryPool.hpp"
+#include "Device.hpp"
+#include "Utilities/Exception.hpp"
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <string>
+
+namespace Vulkan {
+
+namespace
+{
+	constexpr VkDeviceSize BlockSize = 64 * 1024 * 1024;
+
+	// Anything bigger than this gets a block of its own, freed as soon as the resource is.
+	constexpr VkDeviceSize DedicatedThreshold = BlockSize / 2;
+
+	VkDeviceSize RoundUp(const VkDeviceSize size, const VkDeviceSize powerOf2Alignment)
+	{
+		return (size + powerOf2Alignment - 1) & ~(powerOf2Alignment - 1);
+	}
+}
+
+struct DeviceMemoryPool::Block final
+{
+	VkDeviceMemory Memory{};
+	VkDeviceSize Size{};
+	void* MappedData{};
+
+	uint32_t MemoryTypeIndex{};
+	VkMemoryAllocateFlags AllocateFlags{};
+	ResourceType Type{};
+	Strategy AllocationStrategy{};
+	bool Dedicated{};
+
+	uint32_t AllocationCount{};
+	VkDeviceSize UsedSize{};
+
+	// Linear strategy: everything below Top is in use.
+	VkDeviceSize Top{};
+
+	// Free list strategy: free ranges as offset -> size.
+	std::map<VkDeviceSize, VkDeviceSize> FreeRanges;
+
+	bool IsEmpty() const { return AllocationCount == 0; }
+
+	bool Matches(const uint32_t memoryTypeIndex, const VkMemoryAllocateFlags allocateFlags, const ResourceType resourceType, const Strategy strategy) const
+	{
+		return
+			!Dedicated &&
+			MemoryTypeIndex == memoryTypeIndex &&
+			AllocateFlags == allocateFlags &&
+			Type == resourceType &&
+			AllocationStrategy == strategy;
+	}
+};
+
+DeviceMemoryPool::DeviceMemoryPool(const class Device& device) :
+	device_(device)
+{
+	vkGetPhysicalDeviceMemoryProperties(device.PhysicalDevice(), &memoryProperties_);
+}
+
+DeviceMemoryPool::~DeviceMemoryPool()
+{
+	for (const auto& block : blocks_)
+	{
+		DestroyBlock(*block);
+	}
+
+	blocks_.clear();
+}
+
+DeviceMemoryPool::Allocation DeviceMemoryPool::Allocate(
+	const VkMemoryRequirements& requirements,
+	const VkMemoryAllocateFlags allocateFlags,
+	const VkMemoryPropertyFlags propertyFlags,
+	const ResourceType resourceType,
+	const Strategy strategy)
+{
+	const auto memoryTypeIndex = FindMemoryType(requirements.memoryTypeBits, propertyFlags);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	Allocation allocation;
+
+	if (requirements.size <= DedicatedThreshold)
+	{
+		for (const auto& block : blocks_)
+		{
+			if (block->Matches(memoryTypeIndex, allocateFlags, resourceType, strategy) && TryAllocate(*block, requirements, allocation))
+			{
+				return allocation;
+			}
+		}
+	}
+
+	const bool dedicated = requirements.size > DedicatedThreshold;
+	auto& block = CreateBlock(dedicated ? requirements.size : BlockSize, memoryTypeIndex, allocateFlags, resourceType, strategy, dedicated);
+
+	if (!TryAllocate(block, requirements, allocation))
+	{
+		Throw(std::logic_error("failed to sub-allocate from a new memory block"));
+	}
+
+	return allocation;
+}
+
+void DeviceMemoryPool::Free(const Allocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto& block = *allocation.Owner;
+
+	block.AllocationCount--;
+	block.UsedSize -= allocation.Size;
+
+	if (block.AllocationStrategy == Strategy::Linear)
+	{
+		if (block.IsEmpty())
+		{
+			block.Top = 0;
+		}
+	}
+	else
+	{
+		// Insert the range back and merge it with its neighbours.
+		auto offset = allocation.Offset;
+		auto size = allocation.Size;
+		auto next = block.FreeRanges.lower_bound(offset);
+
+		if (next != block.FreeRanges.begin())
+		{
+			const auto previous = std::prev(next);
+
+			if (previous->first + previous->second == offset)
+			{
+				offset = previous->first;
+				size += previous->second;
+				block.FreeRanges.erase(previous);
+			}
+		}
+
+		if (next != block.FreeRanges.end() && offset + size == next->first)
+		{
+			size += next->second;
+			block.FreeRanges.erase(next);
+		}
+
+		block.FreeRanges.emplace(offset, size);
+	}
+
+	if (!block.IsEmpty())
+	{
+		return;
+	}
+
+	// Keep at most one empty block around per kind of allocation, to avoid thrashing on repeated uploads.
+	const bool hasOtherEmptyBlock = std::any_of(blocks_.begin(), blocks_.end(), [&block](const std::unique_ptr<Block>& other)
+	{
+		return
+			other.get() != &block &&
+			other->IsEmpty() &&
+			other->Matches(block.MemoryTypeIndex, block.AllocateFlags, block.Type, block.AllocationStrategy);
+	});
+
+	if (block.Dedicated || hasOtherEmptyBlock)
+	{
+		DestroyBlock(block);
+		blocks_.erase(std::find_if(blocks_.begin(), blocks_.end(), [&block](const std::unique_ptr<Block>& other) { return other.get() == &block; }));
+	}
+}
+
+uint32_t DeviceMemoryPool::FindMemoryType(const uint32_t typeFilter, const VkMemoryPropertyFlags propertyFlags) const
+{
+	for (uint32_t i = 0; i != memoryProperties_.memoryTypeCount; ++i)
+	{
+		if ((typeFilter & (1 << i)) && (memoryProperties_.memoryTypes[i].propertyFlags & propertyFlags) == propertyFlags)
+		{
+			return i;
+		}
+	}
+
+	Throw(std::runtime_error("failed to find suitable memory type"));
+}
+
+DeviceMemoryPool::Statistics DeviceMemoryPool::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	Statistics statistics = {};
+
+	for (const auto& block : blocks_)
+	{
+		statistics.BlockCount++;
+		statistics.AllocationCount += block->AllocationCount;
+		statistics.BlockBytes += block->Size;
+		statistics.UsedBytes += block->UsedSize;
+
+		// A single free range is just the unused end of the block, any more than that is fragmentation.
+		if (block->FreeRanges.size() > 1)
+		{
+			statistics.FreeRangeCount += static_cast<uint32_t>(block->FreeRanges.size() - 1);
+		}
+	}
+
+	return statistics;
+}
+
+bool DeviceMemoryPool::TryAllocate(Block& block, const VkMemoryRequirements& requirements, Allocation& allocation) const
+{
+	VkDeviceSize offset = 0;
+
+	if (block.AllocationStrategy == Strategy::Linear)
+	{
+		offset = RoundUp(block.Top, requirements.alignment);
+
+		if (offset + requirements.size > block.Size)
+		{
+			return false;
+		}
+
+		block.Top = offset + requirements.size;
+	}
+	else
+	{
+		// First fit, leftovers on either side of the aligned range remain free.
+		auto range = std::find_if(block.FreeRanges.begin(), block.FreeRanges.end(), [&requirements](const std::pair<const VkDeviceSize, VkDeviceSize>& free)
+		{
+			return RoundUp(free.first, requirements.alignment) + requirements.size <= free.first + free.second;
+		});
+
+		if (range == block.FreeRanges.end())
+		{
+			return false;
+		}
+
+		const auto rangeOffset = range->first;
+		const auto rangeEnd = range->first + range->second;
+
+		offset = RoundUp(rangeOffset, requirements.alignment);
+		block.FreeRanges.erase(range);
+
+		if (offset != rangeOffset)
+		{
+			block.FreeRanges.emplace(rangeOffset, offset - rangeOffset);
+		}
+
+		if (offset + requirements.size != rangeEnd)
+		{
+			block.FreeRanges.emplace(offset + requirements.size, rangeEnd - offset - requirements.size);
+		}
+	}
+
+	block.AllocationCount++;
+	block.UsedSize += requirements.size;
+
+	allocation.Memory = block.Memory;
+	allocation.Offset = offset;
+	allocation.Size = requirements.size;
+	allocation.MappedData = block.MappedData != nullptr ? static_cast<char*>(block.MappedData) + offset : nullptr;
+	allocation.Owner = &block;
+
+	return true;
+}
+
+DeviceMemoryPool::Block& DeviceMemoryPool::CreateBlock(
+	const VkDeviceSize size,
+	const uint32_t memoryTypeIndex,
+	const VkMemoryAllocateFlags allocateFlags,
+	const ResourceType resourceType,
+	const Strategy strategy,
+	const bool dedicated)
+{
+	VkMemoryAllocateFlagsInfo flagsInfo = {};
+	flagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+	flagsInfo.pNext = nullptr;
+	flagsInfo.flags = allocateFlags;
+
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.pNext = &flagsInfo;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+	std::unique_ptr<Block> block(new Block());
+
+	Check(vkAllocateMemory(device_.Handle(), &allocInfo, nullptr, &block->Memory),
+		"allocate memory");
+
+	// Blocks are shared by many resources, name them after their kind rather than their content.
+	const auto name = std::string(dedicated ? "Dedicated" : "Pooled") + " Memory Block (type " + std::to_string(memoryTypeIndex) + ")";
+	device_.DebugUtils().SetObjectName(block->Memory, name.c_str());
+
+	if (memoryProperties_.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		const auto result = vkMapMemory(device_.Handle(), block->Memory, 0, VK_WHOLE_SIZE, 0, &block->MappedData);
+
+		if (result != VK_SUCCESS)
+		{
+			vkFreeMemory(device_.Handle(), block->Memory, nullptr);
+			Check(result, "map memory");
+		}
+	}
+
+	block->Size = size;
+	block->MemoryTypeIndex = memoryTypeIndex;
+	block->AllocateFlags = allocateFlags;
+	block->Type = resourceType;
+	block->AllocationStrategy = strategy;
+	block->Dedicated = dedicated;
+
+	if (strategy == Strategy::FreeList)
+	{
+		block->FreeRanges.emplace(0, size);
+	}
+
+	blocks_.push_back(std::move(block));
+
+	return *blocks_.back();
+}
+
+void DeviceMemoryPool::DestroyBlock(const Block& block)
+{
+	if (block.MappedData != nullptr)
+	{
+		vkUnmapMemory(device_.Handle(), block.Memory);
+	}
+
+	vkFreeMemory(device_.Handle(), block.Memory, nullptr);
+}
+
+}
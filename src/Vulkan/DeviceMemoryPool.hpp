@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Vulkan
+{
+	class Device;
+
+	// Sub-allocates buffers and images out of large VkDeviceMemory blocks, one set of blocks per memory type.
+	// Host visible blocks are persistently mapped.
+	class DeviceMemoryPool final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(DeviceMemoryPool)
+
+		// Linear blocks are bump allocated and only rewound once all their allocations are freed, meant for short lived staging data.
+		// Free list blocks serve long lived resources and coalesce freed ranges.
+		enum class Strategy
+		{
+			FreeList,
+			Linear
+		};
+
+		// Linear (buffers, linear images) and optimal (optimal tiling images) resources never share a block,
+		// which takes care of bufferImageGranularity.
+		enum class ResourceType
+		{
+			Linear,
+			Optimal
+		};
+
+		struct Block;
+
+		struct Allocation final
+		{
+			VkDeviceMemory Memory{};
+			VkDeviceSize Offset{};
+			VkDeviceSize Size{};
+			void* MappedData{};
+			Block* Owner{};
+		};
+
+		struct Statistics final
+		{
+			uint32_t BlockCount;
+			uint32_t AllocationCount;
+			uint32_t FreeRangeCount;
+			VkDeviceSize BlockBytes;
+			VkDeviceSize UsedBytes;
+		};
+
+		explicit DeviceMemoryPool(const Device& device);
+		~DeviceMemoryPool();
+
+		Allocation Allocate(
+			const VkMemoryRequirements& requirements,
+			VkMemoryAllocateFlags allocateFlags,
+			VkMemoryPropertyFlags propertyFlags,
+			ResourceType resourceType,
+			Strategy strategy);
+
+		void Free(const Allocation& allocation);
+
+		uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags propertyFlags) const;
+		Statistics GetStatistics() const;
+
+	private:
+
+		bool TryAllocate(Block& block, const VkMemoryRequirements& requirements, Allocation& allocation) const;
+		Block& CreateBlock(VkDeviceSize size, uint32_t memoryTypeIndex, VkMemoryAllocateFlags allocateFlags, ResourceType resourceType, Strategy strategy, bool dedicated);
+		void DestroyBlock(const Block& block);
+
+		const class Device& device_;
+
+		VkPhysicalDeviceMemoryProperties memoryProperties_{};
+
+		mutable std::mutex mutex_;
+		std::vector<std::unique_ptr<Block>> blocks_;
+	};
+
+}
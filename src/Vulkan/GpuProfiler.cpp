@@ -0,0 +1,172 @@
+#include "GpuProfiler.hpp"
+#include "Device.hpp"
+#include "Enumerate.hpp"
+#include "QueryPool.hpp"
+#include "Utilities/Exception.hpp"
+#include <cstring>
+#include <limits>
+
+namespace Vulkan {
+
+namespace
+{
+	constexpr uint32_t NoQuery = std::numeric_limits<uint32_t>::max();
+}
+
+GpuProfiler::GpuProfiler(const class Device& device, const size_t frameCount) :
+	frames_(frameCount)
+{
+	const auto queueFamilies = GetEnumerateVector(device.PhysicalDevice(), vkGetPhysicalDeviceQueueFamilyProperties);
+	const auto validBits = queueFamilies[device.GraphicsFamilyIndex()].timestampValidBits;
+
+	if (validBits == 0)
+	{
+		return;
+	}
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device.PhysicalDevice(), &properties);
+
+	timestampPeriod_ = properties.limits.timestampPeriod;
+	timestampMask_ = validBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << validBits) - 1;
+
+	queryPool_.reset(new QueryPool(device, VK_QUERY_TYPE_TIMESTAMP, static_cast<uint32_t>(frameCount) * MaxScopesPerFrame * 2));
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	queryPool_.reset();
+}
+
+void GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, const size_t frame)
+{
+	if (!IsSupported())
+	{
+		return;
+	}
+
+	if (!openScopes_.empty())
+	{
+		Throw(std::logic_error("GPU profiler scope left open at the end of a frame"));
+	}
+
+	const auto firstQuery = static_cast<uint32_t>(frame) * MaxScopesPerFrame * 2;
+
+	currentFrame_ = frame;
+	Resolve(frames_[frame], firstQuery);
+
+	queryPool_->Reset(commandBuffer, firstQuery, MaxScopesPerFrame * 2);
+}
+
+void GpuProfiler::BeginScope(VkCommandBuffer commandBuffer, const char* const name)
+{
+	if (!IsSupported())
+	{
+		return;
+	}
+
+	auto& frame = frames_[currentFrame_];
+	const auto index = static_cast<uint32_t>(frame.Queries.size());
+
+	FindOrAddScope(name);
+	openScopes_.push_back(frame.Queries.size());
+
+	// Scopes past the per frame limit are silently left out.
+	if (index >= MaxScopesPerFrame)
+	{
+		frame.Queries.emplace_back(name, NoQuery);
+		return;
+	}
+
+	const auto query = static_cast<uint32_t>(currentFrame_) * MaxScopesPerFrame * 2 + index * 2;
+
+	frame.Queries.emplace_back(name, query);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool_->Handle(), query);
+}
+
+void GpuProfiler::EndScope(VkCommandBuffer commandBuffer)
+{
+	if (!IsSupported())
+	{
+		return;
+	}
+
+	if (openScopes_.empty())
+	{
+		Throw(std::logic_error("GPU profiler scope ended without being begun"));
+	}
+
+	const auto query = frames_[currentFrame_].Queries[openScopes_.back()].second;
+	openScopes_.pop_back();
+
+	if (query != NoQuery)
+	{
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool_->Handle(), query + 1);
+	}
+}
+
+void GpuProfiler::Resolve(Frame& frame, const uint32_t firstQuery)
+{
+	if (frame.Queries.empty())
+	{
+		return;
+	}
+
+	const auto queryCount = static_cast<uint32_t>(frame.Queries.size() < MaxScopesPerFrame ? frame.Queries.size() : MaxScopesPerFrame) * 2;
+
+	// The fence of this frame has been waited on, so the results should be there. Never wait for them regardless.
+	if (queryPool_->GetResults(firstQuery, queryCount, 0, results_))
+	{
+		for (auto& scope : scopes_)
+		{
+			scope.Active = false;
+		}
+
+		for (const auto& query : frame.Queries)
+		{
+			if (query.second == NoQuery)
+			{
+				continue;
+			}
+
+			const auto index = query.second - firstQuery;
+			const auto ticks = (results_[index + 1] - results_[index]) & timestampMask_;
+			const auto milliseconds = static_cast<float>(ticks * timestampPeriod_ * 1e-6);
+
+			auto& scope = FindOrAddScope(query.first);
+			scope.Milliseconds = scope.Active ? scope.Milliseconds + milliseconds : milliseconds;
+			scope.Active = true;
+		}
+
+		// Scopes that were not recorded in this frame keep their last time, but their history does not move.
+		for (auto& scope : scopes_)
+		{
+			if (!scope.Active)
+			{
+				continue;
+			}
+
+			scope.History[scope.HistoryOffset] = scope.Milliseconds;
+			scope.HistoryOffset = (scope.HistoryOffset + 1) % HistoryLength;
+		}
+	}
+
+	frame.Queries.clear();
+}
+
+GpuProfiler::Scope& GpuProfiler::FindOrAddScope(const char* const name)
+{
+	for (auto& scope : scopes_)
+	{
+		if (scope.Name == name || std::strcmp(scope.Name, name) == 0)
+		{
+			return scope;
+		}
+	}
+
+	scopes_.push_back(Scope{ name, 0, false, std::vector<float>(HistoryLength), 0 });
+
+	return scopes_.back();
+}
+
+}
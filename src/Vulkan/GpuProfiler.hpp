@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include <memory>
+#include <vector>
+
+namespace Vulkan
+{
+	class Device;
+	class QueryPool;
+
+	// Times named scopes on the GPU with timestamp queries. Every frame in flight has its own range of queries,
+	// which is read back when that frame comes around again (its fence has been waited on by then), so the
+	// results lag a few frames behind but reading them never stalls.
+	class GpuProfiler final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(GpuProfiler)
+
+		static constexpr size_t HistoryLength = 128;
+
+		struct Scope final
+		{
+			const char* Name;
+			float Milliseconds;
+
+			// Whether the scope was recorded in the last resolved frame, Milliseconds is stale otherwise.
+			bool Active;
+
+			// Rolling history in milliseconds, HistoryOffset is the oldest entry.
+			std::vector<float> History;
+			size_t HistoryOffset;
+		};
+
+		GpuProfiler(const Device& device, size_t frameCount);
+		~GpuProfiler();
+
+		// False when the graphics queue does not support timestamps, all the calls below are then no-ops.
+		bool IsSupported() const { return queryPool_.operator bool(); }
+
+		// Collects the results last recorded for this frame and resets its queries. Must be called outside a render pass.
+		void BeginFrame(VkCommandBuffer commandBuffer, size_t frame);
+
+		// Scopes can nest. Names must outlive the profiler (string literals), equal names within a frame are summed.
+		void BeginScope(VkCommandBuffer commandBuffer, const char* name);
+		void EndScope(VkCommandBuffer commandBuffer);
+
+		// Every scope seen so far, in order of first appearance.
+		const std::vector<Scope>& Scopes() const { return scopes_; }
+
+	private:
+
+		struct Frame final
+		{
+			// Name and index of the begin query, the end query directly follows it.
+			std::vector<std::pair<const char*, uint32_t>> Queries;
+		};
+
+		void Resolve(Frame& frame, uint32_t firstQuery);
+		Scope& FindOrAddScope(const char* name);
+
+		static constexpr uint32_t MaxScopesPerFrame = 32;
+
+		std::unique_ptr<QueryPool> queryPool_;
+		double timestampPeriod_{};
+		uint64_t timestampMask_{};
+
+		std::vector<Frame> frames_;
+		size_t currentFrame_{};
+		std::vector<size_t> openScopes_;
+
+		std::vector<Scope> scopes_;
+		std::vector<uint64_t> results_;
+	};
+
+}
@@ -4,6 +4,7 @@
 #include "DescriptorPool.hpp"
 #include "DescriptorSets.hpp"
 #include "Device.hpp"
+#include "PipelineCache.hpp"
 #include "PipelineLayout.hpp"
 #include "RenderPass.hpp"
 #include "ShaderModule.hpp"
@@ -11,26 +12,29 @@
 #include "Assets/Scene.hpp"
 #include "Assets/UniformBuffer.hpp"
 #include "Assets/Vertex.hpp"
+#include <chrono>
+#include <iostream>
 
 namespace Vulkan {
 
 GraphicsPipeline::GraphicsPipeline(
 	const SwapChain& swapChain, 
 	const DepthBuffer& depthBuffer,
-	const std::vector<Assets::UniformBuffer>& uniformBuffers,
+	const PipelineCache& pipelineCache,
+	const Assets::UniformBuffer& uniformBuffer,
 	const Assets::Scene& scene,
 	const bool isWireFrame) :
 	swapChain_(swapChain),
 	isWireFrame_(isWireFrame)
 {
 	const auto& device = swapChain.Device();
-	const auto bindingDescription = Assets::Vertex::GetBindingDescription();
-	const auto attributeDescriptions = Assets::Vertex::GetAttributeDescriptions();
+	const auto bindingDescriptions = Assets::VertexAttributes::GetBindingDescriptions();
+	const auto attributeDescriptions = Assets::VertexAttributes::GetAttributeDescriptions();
 
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
-	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+	vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+	vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
 	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
 	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
@@ -116,50 +120,47 @@ GraphicsPipeline::GraphicsPipeline(
 	// Create descriptor pool/sets.
 	std::vector<DescriptorBinding> descriptorBindings =
 	{
-		{0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT},
-		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT},
-		{2, static_cast<uint32_t>(scene.TextureSamplers().size()), VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT}
+		{0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT},
+		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT},
+		{2, static_cast<uint32_t>(scene.TextureSamplers().size()), VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT},
+		{3, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT}
 	};
 
-	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, uniformBuffers.size()));
+	// A single descriptor set, the uniform buffer slice of the frame is selected with a dynamic offset when binding.
+	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, 1));
 
 	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
 
-	for (uint32_t i = 0; i != swapChain.Images().size(); ++i)
+	// Uniform buffer
+	VkDescriptorBufferInfo uniformBufferInfo = {};
+	uniformBufferInfo.buffer = uniformBuffer.Buffer().Handle();
+	uniformBufferInfo.range = uniformBuffer.SliceSize();
+
+	// Material buffer
+	VkDescriptorBufferInfo materialBufferInfo = {};
+	materialBufferInfo.buffer = scene.MaterialBuffer().Handle();
+	materialBufferInfo.range = VK_WHOLE_SIZE;
+
+	// Primitive material buffer
+	VkDescriptorBufferInfo primitiveMaterialBufferInfo = {};
+	primitiveMaterialBufferInfo.buffer = scene.PrimitiveMaterialBuffer().Handle();
+	primitiveMaterialBufferInfo.range = VK_WHOLE_SIZE;
+
+	const std::vector<VkWriteDescriptorSet> descriptorWrites =
 	{
-		// Uniform buffer
-		VkDescriptorBufferInfo uniformBufferInfo = {};
-		uniformBufferInfo.buffer = uniformBuffers[i].Buffer().Handle();
-		uniformBufferInfo.range = VK_WHOLE_SIZE;
-
-		// Material buffer
-		VkDescriptorBufferInfo materialBufferInfo = {};
-		materialBufferInfo.buffer = scene.MaterialBuffer().Handle();
-		materialBufferInfo.range = VK_WHOLE_SIZE;
-
-		// Image and texture samplers
-		std::vector<VkDescriptorImageInfo> imageInfos(scene.TextureSamplers().size());
-
-		for (size_t t = 0; t != imageInfos.size(); ++t)
-		{
-			auto& imageInfo = imageInfos[t];
-			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			imageInfo.imageView = scene.TextureImageViews()[t];
-			imageInfo.sampler = scene.TextureSamplers()[t];
-		}
-
-		const std::vector<VkWriteDescriptorSet> descriptorWrites =
-		{
-			descriptorSets.Bind(i, 0, uniformBufferInfo),
-			descriptorSets.Bind(i, 1, materialBufferInfo),
-			descriptorSets.Bind(i, 2, *imageInfos.data(), static_cast<uint32_t>(imageInfos.size()))
-		};
-
-		descriptorSets.UpdateDescriptors(descriptorWrites);
-	}
+		descriptorSets.Bind(0, 0, uniformBufferInfo),
+		descriptorSets.Bind(0, 1, materialBufferInfo),
+		descriptorSets.Bind(0, 3, primitiveMaterialBufferInfo)
+	};
+
+	descriptorSets.UpdateDescriptors(descriptorWrites);
+
+	UpdateTextures(scene);
 
 	// Create pipeline layout and render pass.
-	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout()));
+	const VkPushConstantRange pushConstantRange = { VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstants) };
+
+	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout(), { pushConstantRange }));
 	renderPass_.reset(new class RenderPass(swapChain, depthBuffer, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_LOAD_OP_CLEAR));
 
 	// Load shaders.
@@ -191,8 +192,13 @@ GraphicsPipeline::GraphicsPipeline(
 	pipelineInfo.renderPass = renderPass_->Handle();
 	pipelineInfo.subpass = 0;
 
-	Check(vkCreateGraphicsPipelines(device.Handle(), nullptr, 1, &pipelineInfo, nullptr, &pipeline_),
+	const auto timer = std::chrono::high_resolution_clock::now();
+
+	Check(vkCreateGraphicsPipelines(device.Handle(), pipelineCache.Handle(), 1, &pipelineInfo, nullptr, &pipeline_),
 		"create graphics pipeline");
+
+	const auto elapsed = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - timer).count();
+	std::cout << "- created graphics pipeline in " << elapsed << "ms (" << (pipelineCache.IsWarm() ? "warm" : "cold") << " pipeline cache)" << std::endl;
 }
 
 GraphicsPipeline::~GraphicsPipeline()
@@ -208,9 +214,27 @@ GraphicsPipeline::~GraphicsPipeline()
 	descriptorSetManager_.reset();
 }
 
-VkDescriptorSet GraphicsPipeline::DescriptorSet(const size_t index) const
+VkDescriptorSet GraphicsPipeline::DescriptorSet() const
 {
-	return descriptorSetManager_->DescriptorSets().Handle(index);
+	return descriptorSetManager_->DescriptorSets().Handle(0);
+}
+
+void GraphicsPipeline::UpdateTextures(const Assets::Scene& scene)
+{
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	// Image and texture samplers.
+	std::vector<VkDescriptorImageInfo> imageInfos(scene.TextureSamplers().size());
+
+	for (size_t t = 0; t != imageInfos.size(); ++t)
+	{
+		auto& imageInfo = imageInfos[t];
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = scene.TextureImageViews()[t];
+		imageInfo.sampler = scene.TextureSamplers()[t];
+	}
+
+	descriptorSets.UpdateDescriptors({ descriptorSets.Bind(0, 2, *imageInfos.data(), static_cast<uint32_t>(imageInfos.size())) });
 }
 
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Vulkan.hpp"
+#include "Utilities/Glm.hpp"
 #include <memory>
 #include <vector>
 
@@ -13,6 +14,7 @@ namespace Assets
 namespace Vulkan
 {
 	class DepthBuffer;
+	class PipelineCache;
 	class PipelineLayout;
 	class RenderPass;
 	class SwapChain;
@@ -23,15 +25,28 @@ namespace Vulkan
 
 		VULKAN_NON_COPIABLE(GraphicsPipeline)
 
+		// Per draw (i.e. per model instance) data, see Graphics.vert.
+		struct PushConstants final
+		{
+			glm::mat4 Model;
+			int32_t MaterialOverride;
+			uint32_t PrimitiveOffset; // of the model in the primitive material buffer
+		};
+
 		GraphicsPipeline(
 			const SwapChain& swapChain, 
 			const DepthBuffer& depthBuffer,
-			const std::vector<Assets::UniformBuffer>& uniformBuffers,
+			const PipelineCache& pipelineCache,
+			const Assets::UniformBuffer& uniformBuffer,
 			const Assets::Scene& scene,
 			bool isWireFrame);
 		~GraphicsPipeline();
 
-		VkDescriptorSet DescriptorSet(size_t index) const;
+		VkDescriptorSet DescriptorSet() const;
+
+		// Rebinds the scene textures (binding 2), e.g. once streamed textures have replaced their placeholder.
+		// The descriptor set must not be in use by the device.
+		void UpdateTextures(const Assets::Scene& scene);
 		bool IsWireFrame() const { return isWireFrame_; }
 		const class PipelineLayout& PipelineLayout() const { return *pipelineLayout_; }
 		const class RenderPass& RenderPass() const { return *renderPass_; }
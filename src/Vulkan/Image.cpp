@@ -2,8 +2,10 @@
 #include "Buffer.hpp"
 #include "DepthBuffer.hpp"
 #include "Device.hpp"
+#include "ImageMemoryBarrier.hpp"
 #include "SingleTimeCommands.hpp"
 #include "Utilities/Exception.hpp"
+#include <algorithm>
 
 namespace Vulkan {
 
@@ -18,9 +20,22 @@ Image::Image(
 	const VkFormat format,
 	const VkImageTiling tiling,
 	const VkImageUsageFlags usage) :
+	Image(device, extent, format, tiling, usage, 1)
+{
+}
+
+Image::Image(
+	const class Device& device,
+	const VkExtent2D extent,
+	const VkFormat format,
+	const VkImageTiling tiling,
+	const VkImageUsageFlags usage,
+	const uint32_t mipLevels) :
 	device_(device),
 	extent_(extent),
 	format_(format),
+	tiling_(tiling),
+	mipLevels_(mipLevels),
 	imageLayout_(VK_IMAGE_LAYOUT_UNDEFINED)
 {
 	VkImageCreateInfo imageInfo = {};
@@ -29,7 +44,7 @@ Image::Image(
 	imageInfo.extent.width = extent.width;
 	imageInfo.extent.height = extent.height;
 	imageInfo.extent.depth = 1;
-	imageInfo.mipLevels = 1;
+	imageInfo.mipLevels = mipLevels;
 	imageInfo.arrayLayers = 1;
 	imageInfo.format = format;
 	imageInfo.tiling = tiling;
@@ -47,6 +62,8 @@ Image::Image(Image&& other) noexcept :
 	device_(other.device_),
 	extent_(other.extent_),
 	format_(other.format_),
+	tiling_(other.tiling_),
+	mipLevels_(other.mipLevels_),
 	imageLayout_(other.imageLayout_),
 	image_(other.image_)
 {
@@ -62,12 +79,24 @@ Image::~Image()
 	}
 }
 
+uint32_t Image::MipLevelCount(const VkExtent2D extent)
+{
+	uint32_t mipLevels = 1;
+
+	for (uint32_t size = std::max(extent.width, extent.height); size > 1; size /= 2)
+	{
+		++mipLevels;
+	}
+
+	return mipLevels;
+}
+
 DeviceMemory Image::AllocateMemory(const VkMemoryPropertyFlags properties) const
 {
-	const auto requirements = GetMemoryRequirements();
-	DeviceMemory memory(device_, requirements.size, requirements.memoryTypeBits, 0, properties);
+	const auto resourceType = tiling_ == VK_IMAGE_TILING_LINEAR ? DeviceMemoryPool::ResourceType::Linear : DeviceMemoryPool::ResourceType::Optimal;
+	DeviceMemory memory(device_, GetMemoryRequirements(), 0, properties, resourceType, DeviceMemoryPool::Strategy::FreeList);
 
-	Check(vkBindImageMemory(device_.Handle(), image_, memory.Handle(), 0),
+	Check(vkBindImageMemory(device_.Handle(), image_, memory.Handle(), memory.Offset()),
 		"bind image memory");
 
 	return memory;
@@ -84,66 +113,71 @@ void Image::TransitionImageLayout(CommandPool& commandPool, VkImageLayout newLay
 {
 	SingleTimeCommands::Submit(commandPool, [&](VkCommandBuffer commandBuffer)
 	{
-		VkImageMemoryBarrier barrier = {};
-		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.oldLayout = imageLayout_;
-		barrier.newLayout = newLayout;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.image = image_;
-		barrier.subresourceRange.baseMipLevel = 0;
-		barrier.subresourceRange.levelCount = 1;
-		barrier.subresourceRange.baseArrayLayer = 0;
-		barrier.subresourceRange.layerCount = 1;
-
-		if (newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) 
-		{
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		TransitionImageLayout(commandBuffer, newLayout);
+	});
+}
 
-			if (DepthBuffer::HasStencilComponent(format_)) 
-			{
-				barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
-			}
-		}
-		else 
+void Image::TransitionImageLayout(VkCommandBuffer commandBuffer, VkImageLayout newLayout)
+{
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = imageLayout_;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image_;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = mipLevels_;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	if (newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) 
+	{
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+
+		if (DepthBuffer::HasStencilComponent(format_)) 
 		{
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
 		}
+	}
+	else 
+	{
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	}
 
-		VkPipelineStageFlags sourceStage;
-		VkPipelineStageFlags destinationStage;
+	VkPipelineStageFlags sourceStage;
+	VkPipelineStageFlags destinationStage;
 
-		if (imageLayout_ == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) 
-		{
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	if (imageLayout_ == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) 
+	{
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 
-			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		}
-		else if (imageLayout_ == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		{
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	}
+	else if (imageLayout_ == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+	{
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-			sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		}
-		else if (imageLayout_ == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) 
-		{
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	}
+	else if (imageLayout_ == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) 
+	{
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
-			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		}
-		else 
-		{
-			Throw(std::invalid_argument("unsupported layout transition"));
-		}
+		sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	}
+	else 
+	{
+		Throw(std::invalid_argument("unsupported layout transition"));
+	}
 
-		vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-	});
+	vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 
 	imageLayout_ = newLayout;
 }
@@ -152,19 +186,88 @@ void Image::CopyFrom(CommandPool& commandPool, const Buffer& buffer)
 {
 	SingleTimeCommands::Submit(commandPool, [&](VkCommandBuffer commandBuffer)
 	{
-		VkBufferImageCopy region = {};
-		region.bufferOffset = 0;
-		region.bufferRowLength = 0;
-		region.bufferImageHeight = 0;
-		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.imageSubresource.mipLevel = 0;
-		region.imageSubresource.baseArrayLayer = 0;
-		region.imageSubresource.layerCount = 1;
-		region.imageOffset = { 0, 0, 0 };
-		region.imageExtent = { extent_.width, extent_.height, 1 };
-
-		vkCmdCopyBufferToImage(commandBuffer, buffer.Handle(), image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+		CopyFrom(commandBuffer, buffer, 0);
 	});
 }
 
+void Image::CopyFrom(VkCommandBuffer commandBuffer, const Buffer& buffer, const VkDeviceSize bufferOffset)
+{
+	VkBufferImageCopy region = {};
+	region.bufferOffset = bufferOffset;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { extent_.width, extent_.height, 1 };
+
+	vkCmdCopyBufferToImage(commandBuffer, buffer.Handle(), image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+}
+
+void Image::GenerateMipmaps(VkCommandBuffer commandBuffer)
+{
+	if (imageLayout_ != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+	{
+		Throw(std::invalid_argument("mipmaps can only be generated from the transfer destination layout"));
+	}
+
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(device_.PhysicalDevice(), format_, &formatProperties);
+
+	const VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+	if ((formatProperties.optimalTilingFeatures & requiredFeatures) != requiredFeatures)
+	{
+		Throw(std::runtime_error("image format does not support linear blitting"));
+	}
+
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.levelCount = 1;
+	subresourceRange.baseArrayLayer = 0;
+	subresourceRange.layerCount = 1;
+
+	int32_t width = static_cast<int32_t>(extent_.width);
+	int32_t height = static_cast<int32_t>(extent_.height);
+
+	// Each level is read by the blit to the next one, then handed over to the shaders.
+	for (uint32_t level = 1; level != mipLevels_; ++level)
+	{
+		subresourceRange.baseMipLevel = level - 1;
+
+		ImageMemoryBarrier::Insert(commandBuffer, image_, subresourceRange, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+		const int32_t nextWidth = std::max(width / 2, 1);
+		const int32_t nextHeight = std::max(height / 2, 1);
+
+		VkImageBlit blit = {};
+		blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 };
+		blit.srcOffsets[1] = { width, height, 1 };
+		blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+		blit.dstOffsets[1] = { nextWidth, nextHeight, 1 };
+
+		vkCmdBlitImage(commandBuffer, 
+			image_, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 
+			image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
+			1, &blit, VK_FILTER_LINEAR);
+
+		ImageMemoryBarrier::Insert(commandBuffer, image_, subresourceRange, VK_ACCESS_TRANSFER_READ_BIT,
+			VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		width = nextWidth;
+		height = nextHeight;
+	}
+
+	// The last level is only written.
+	subresourceRange.baseMipLevel = mipLevels_ - 1;
+
+	ImageMemoryBarrier::Insert(commandBuffer, image_, subresourceRange, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	imageLayout_ = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
 }
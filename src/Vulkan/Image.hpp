@@ -19,24 +19,38 @@ namespace Vulkan
 
 		Image(const Device& device, VkExtent2D extent, VkFormat format);
 		Image(const Device& device, VkExtent2D extent, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage);
+		Image(const Device& device, VkExtent2D extent, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, uint32_t mipLevels);
 		Image(Image&& other) noexcept;
 		~Image();
 
 		const class Device& Device() const { return device_; }
 		VkExtent2D Extent() const { return extent_; }
 		VkFormat Format() const { return format_; }
+		uint32_t MipLevels() const { return mipLevels_; }
+
+		// Number of levels of a full mip chain, down to 1x1.
+		static uint32_t MipLevelCount(VkExtent2D extent);
 
 		DeviceMemory AllocateMemory(VkMemoryPropertyFlags properties) const;
 		VkMemoryRequirements GetMemoryRequirements() const;
 
 		void TransitionImageLayout(CommandPool& commandPool, VkImageLayout newLayout);
+		void TransitionImageLayout(VkCommandBuffer commandBuffer, VkImageLayout newLayout);
 		void CopyFrom(CommandPool& commandPool, const Buffer& buffer);
+		void CopyFrom(VkCommandBuffer commandBuffer, const Buffer& buffer, VkDeviceSize bufferOffset);
+
+		// Fills the other mip levels from the first one with a chain of linear blits, leaving the whole image ready to be
+		// sampled. The first level must have been copied in the transfer destination layout. The image needs the transfer
+		// source usage.
+		void GenerateMipmaps(VkCommandBuffer commandBuffer);
 
 	private:
 
 		const class Device& device_;
 		const VkExtent2D extent_;
 		const VkFormat format_;
+		const VkImageTiling tiling_;
+		const uint32_t mipLevels_;
 		VkImageLayout imageLayout_;
 
 		VULKAN_HANDLE(VkImage, image_)
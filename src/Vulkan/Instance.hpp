@@ -13,10 +13,11 @@ namespace Vulkan
 
 		VULKAN_NON_COPIABLE(Instance)
 
-		Instance(const Window& window, const std::vector<const char*>& validationLayers, uint32_t vulkanVersion);
+		// A null window creates a headless instance, without any surface extension.
+		Instance(const Window* window, const std::vector<const char*>& validationLayers, uint32_t vulkanVersion);
 		~Instance();
 
-		const class Window& Window() const { return window_; }
+		const class Window& Window() const { return *window_; }
 
 		const std::vector<VkExtensionProperties>& Extensions() const { return extensions_; }
 		const std::vector<VkLayerProperties>& Layers() const { return layers_; }
@@ -32,7 +33,7 @@ namespace Vulkan
 		static void CheckVulkanMinimumVersion(uint32_t minVersion);
 		static void CheckVulkanValidationLayerSupport(const std::vector<const char*>& validationLayers);
 
-		const class Window& window_;
+		const class Window* const window_;
 		const std::vector<const char*> validationLayers_;
 
 		VULKAN_HANDLE(VkInstance, instance_)
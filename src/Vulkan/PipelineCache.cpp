@@ -0,0 +1,183 @@
+#include "PipelineCache.hpp"
+#include "Device.hpp"
+#include "Utilities/Console.hpp"
+#include "Utilities/MappedFile.hpp"
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace Vulkan {
+
+namespace
+{
+	constexpr std::array<char, 8> Magic = { 'M', 'O', 'L', 'P', 'S', 'O', 'S', '\0' };
+	constexpr uint32_t Version = 1;
+
+	// The driver's own header has no driver version, so it is repeated along with everything else the data depends on.
+	struct Header final
+	{
+		std::array<char, 8> Magic;
+		uint32_t Version;
+		uint32_t VendorId;
+		uint32_t DeviceId;
+		uint32_t DriverVersion;
+		std::array<uint8_t, VK_UUID_SIZE> PipelineCacheUuid;
+		uint64_t DataSize;
+		uint64_t DataHash;
+	};
+
+	// 64-bit FNV-1a.
+	uint64_t Hash(const unsigned char* const data, const size_t size)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+
+		for (size_t i = 0; i != size; ++i)
+		{
+			hash ^= data[i];
+			hash *= 0x100000001b3ull;
+		}
+
+		return hash;
+	}
+
+	Header MakeHeader(const VkPhysicalDeviceProperties& properties)
+	{
+		Header header = {};
+		header.Magic = Magic;
+		header.Version = Version;
+		header.VendorId = properties.vendorID;
+		header.DeviceId = properties.deviceID;
+		header.DriverVersion = properties.driverVersion;
+		std::memcpy(header.PipelineCacheUuid.data(), properties.pipelineCacheUUID, VK_UUID_SIZE);
+		return header;
+	}
+
+	bool IsValid(const Header& header, const Header& expected, const unsigned char* const data, const size_t size)
+	{
+		if (header.Magic != expected.Magic ||
+			header.Version != expected.Version ||
+			header.VendorId != expected.VendorId ||
+			header.DeviceId != expected.DeviceId ||
+			header.DriverVersion != expected.DriverVersion ||
+			header.PipelineCacheUuid != expected.PipelineCacheUuid ||
+			header.DataSize != size ||
+			size < sizeof(VkPipelineCacheHeaderVersionOne))
+		{
+			return false;
+		}
+
+		// Double check the driver header, drivers are not all equally robust against foreign data.
+		VkPipelineCacheHeaderVersionOne driverHeader;
+		std::memcpy(&driverHeader, data, sizeof(driverHeader));
+
+		return
+			driverHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			driverHeader.vendorID == expected.VendorId &&
+			driverHeader.deviceID == expected.DeviceId &&
+			std::memcmp(driverHeader.pipelineCacheUUID, expected.PipelineCacheUuid.data(), VK_UUID_SIZE) == 0 &&
+			Hash(data, size) == header.DataHash;
+	}
+}
+
+PipelineCache::PipelineCache(const class Device& device, std::string filename) :
+	device_(device),
+	filename_(std::move(filename))
+{
+	vkGetPhysicalDeviceProperties(device.PhysicalDevice(), &properties_);
+
+	const auto expected = MakeHeader(properties_);
+	const Utilities::MappedFile file(filename_);
+
+	const unsigned char* initialData = nullptr;
+	size_t initialSize = 0;
+
+	if (file.IsOpen() && file.Size() >= sizeof(Header))
+	{
+		Header header;
+		std::memcpy(&header, file.Data(), sizeof(Header));
+
+		const auto* const data = file.Data() + sizeof(Header);
+		const auto size = file.Size() - sizeof(Header);
+
+		if (IsValid(header, expected, data, size))
+		{
+			initialData = data;
+			initialSize = size;
+		}
+	}
+
+	warm_ = initialData != nullptr;
+
+	std::cout << "- pipeline cache '" << filename_ << "': " << (warm_ ? "loaded " + std::to_string(initialSize / 1024) + " KiB" : std::string("cold")) << std::endl;
+
+	VkPipelineCacheCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = initialSize;
+	createInfo.pInitialData = initialData;
+
+	Check(vkCreatePipelineCache(device.Handle(), &createInfo, nullptr, &pipelineCache_),
+		"create pipeline cache");
+}
+
+PipelineCache::~PipelineCache()
+{
+	if (pipelineCache_ != nullptr)
+	{
+		vkDestroyPipelineCache(device_.Handle(), pipelineCache_, nullptr);
+		pipelineCache_ = nullptr;
+	}
+}
+
+void PipelineCache::Save() const
+{
+	size_t size = 0;
+	Check(vkGetPipelineCacheData(device_.Handle(), pipelineCache_, &size, nullptr),
+		"get pipeline cache size");
+
+	std::vector<unsigned char> data(size);
+	Check(vkGetPipelineCacheData(device_.Handle(), pipelineCache_, &size, data.data()),
+		"get pipeline cache data");
+
+	data.resize(size);
+
+	auto header = MakeHeader(properties_);
+	header.DataSize = data.size();
+	header.DataHash = Hash(data.data(), data.size());
+
+	// Write to a temporary file first so that an interrupted run never leaves a partial cache behind.
+	const auto tempPath = filename_ + ".tmp";
+
+	bool written;
+
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+		written = static_cast<bool>(file);
+	}
+
+	std::error_code error;
+
+	if (written)
+	{
+		std::filesystem::rename(tempPath, filename_, error);
+		written = !error;
+	}
+
+	if (!written)
+	{
+		std::filesystem::remove(tempPath, error);
+
+		Utilities::Console::Write(Utilities::Severity::Warning, [this]()
+		{
+			std::cout << "\nWARNING: failed to write pipeline cache '" << filename_ << "'" << std::flush;
+		});
+	}
+}
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include <string>
+
+namespace Vulkan
+{
+	class Device;
+
+	// A VkPipelineCache shared by every pipeline, persisted to disk between runs. The file is only used when it was
+	// written by the same vendor, device, driver version and pipeline cache UUID, otherwise the cache starts empty.
+	class PipelineCache final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(PipelineCache)
+
+		PipelineCache(const Device& device, std::string filename);
+		~PipelineCache();
+
+		const class Device& Device() const { return device_; }
+
+		// Whether the cache was loaded from disk. Pipelines added during this run do not make it warm.
+		bool IsWarm() const { return warm_; }
+
+		// Writes the cache to disk. Failures are reported as warnings, a missing cache only costs start-up time.
+		void Save() const;
+
+	private:
+
+		const class Device& device_;
+		const std::string filename_;
+
+		VkPhysicalDeviceProperties properties_{};
+		bool warm_{};
+
+		VULKAN_HANDLE(VkPipelineCache, pipelineCache_)
+	};
+
+}
@@ -0,0 +1,52 @@
+#include "QueryPool.hpp"
+#include "Device.hpp"
+
+namespace Vulkan {
+
+QueryPool::QueryPool(const class Device& device, const VkQueryType queryType, const uint32_t queryCount) :
+	device_(device),
+	queryCount_(queryCount)
+{
+	VkQueryPoolCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	createInfo.queryType = queryType;
+	createInfo.queryCount = queryCount;
+
+	Check(vkCreateQueryPool(device.Handle(), &createInfo, nullptr, &queryPool_),
+		"create query pool");
+}
+
+QueryPool::~QueryPool()
+{
+	if (queryPool_ != nullptr)
+	{
+		vkDestroyQueryPool(device_.Handle(), queryPool_, nullptr);
+		queryPool_ = nullptr;
+	}
+}
+
+void QueryPool::Reset(VkCommandBuffer commandBuffer, const uint32_t firstQuery, const uint32_t queryCount) const
+{
+	vkCmdResetQueryPool(commandBuffer, queryPool_, firstQuery, queryCount);
+}
+
+bool QueryPool::GetResults(const uint32_t firstQuery, const uint32_t queryCount, const VkQueryResultFlags flags, std::vector<uint64_t>& results) const
+{
+	results.resize(queryCount);
+
+	const auto result = vkGetQueryPoolResults(
+		device_.Handle(), queryPool_, firstQuery, queryCount,
+		results.size() * sizeof(uint64_t), results.data(), sizeof(uint64_t),
+		flags | VK_QUERY_RESULT_64_BIT);
+
+	if (result == VK_NOT_READY)
+	{
+		return false;
+	}
+
+	Check(result, "get query pool results");
+
+	return true;
+}
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include <vector>
+
+namespace Vulkan
+{
+	class Device;
+
+	class QueryPool final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(QueryPool)
+
+		QueryPool(const Device& device, VkQueryType queryType, uint32_t queryCount);
+		~QueryPool();
+
+		const class Device& Device() const { return device_; }
+		uint32_t QueryCount() const { return queryCount_; }
+
+		void Reset(VkCommandBuffer commandBuffer, uint32_t firstQuery, uint32_t queryCount) const;
+
+		// Returns false if any of the requested results is not yet available (unless flags contains VK_QUERY_RESULT_WAIT_BIT).
+		bool GetResults(uint32_t firstQuery, uint32_t queryCount, VkQueryResultFlags flags, std::vector<uint64_t>& results) const;
+
+	private:
+
+		const class Device& device_;
+		const uint32_t queryCount_;
+
+		VULKAN_HANDLE(VkQueryPool, queryPool_)
+	};
+
+}
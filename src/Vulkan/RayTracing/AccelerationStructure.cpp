@@ -17,9 +17,9 @@ namespace
 	}
 }
 
-AccelerationStructure::AccelerationStructure(const class DeviceProcedures& deviceProcedures, const RayTracingProperties& rayTracingProperties) :
+AccelerationStructure::AccelerationStructure(const class DeviceProcedures& deviceProcedures, const RayTracingProperties& rayTracingProperties, const VkBuildAccelerationStructureFlagsKHR flags) :
 	deviceProcedures_(deviceProcedures),
-	flags_(VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR),
+	flags_(flags),
 	device_(deviceProcedures.Device()),
 	rayTracingProperties_(rayTracingProperties)
 {
@@ -32,13 +32,17 @@ AccelerationStructure::AccelerationStructure(AccelerationStructure&& other) noex
 	buildSizesInfo_(other.buildSizesInfo_),
 	device_(other.device_),
 	rayTracingProperties_(other.rayTracingProperties_),
+	uncompacted_(other.uncompacted_),
 	accelerationStructure_(other.accelerationStructure_)
 {
+	other.uncompacted_ = nullptr;
 	other.accelerationStructure_ = nullptr;
 }
 
 AccelerationStructure::~AccelerationStructure()
 {
+	ReleaseUncompacted();
+
 	if (accelerationStructure_ != nullptr)
 	{
 		deviceProcedures_.vkDestroyAccelerationStructureKHR(device_.Handle(), accelerationStructure_, nullptr);
@@ -83,6 +87,39 @@ void AccelerationStructure::CreateAccelerationStructure(Buffer& resultBuffer, co
 		"create acceleration structure");
 }
 
+void AccelerationStructure::Compact(VkCommandBuffer commandBuffer, Buffer& resultBuffer, const VkDeviceSize resultOffset, const VkDeviceSize compactedSize)
+{
+	if (!(flags_ & VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR))
+	{
+		Throw(std::logic_error("acceleration structure was not built with compaction allowed"));
+	}
+
+	ReleaseUncompacted();
+
+	uncompacted_ = accelerationStructure_;
+	accelerationStructure_ = nullptr;
+	buildSizesInfo_.accelerationStructureSize = compactedSize;
+
+	CreateAccelerationStructure(resultBuffer, resultOffset);
+
+	VkCopyAccelerationStructureInfoKHR copyInfo = {};
+	copyInfo.sType = VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_INFO_KHR;
+	copyInfo.src = uncompacted_;
+	copyInfo.dst = accelerationStructure_;
+	copyInfo.mode = VK_COPY_ACCELERATION_STRUCTURE_MODE_COMPACT_KHR;
+
+	deviceProcedures_.vkCmdCopyAccelerationStructureKHR(commandBuffer, &copyInfo);
+}
+
+void AccelerationStructure::ReleaseUncompacted()
+{
+	if (uncompacted_ != nullptr)
+	{
+		deviceProcedures_.vkDestroyAccelerationStructureKHR(device_.Handle(), uncompacted_, nullptr);
+		uncompacted_ = nullptr;
+	}
+}
+
 void AccelerationStructure::MemoryBarrier(VkCommandBuffer commandBuffer)
 {
 	// Wait for the builder to complete by setting a barrier on the resulting buffer. This is
@@ -28,11 +28,17 @@ namespace Vulkan::RayTracing
 		const class DeviceProcedures& DeviceProcedures() const { return deviceProcedures_; }
 		const VkAccelerationStructureBuildSizesInfoKHR BuildSizes() const { return buildSizesInfo_; }
 
+		// Records a compacting copy into a new structure placed in the given buffer, which then replaces this one.
+		// The original structure is kept alive until ReleaseUncompacted() is called once the copy has executed.
+		// Requires the structure to have been built with VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR.
+		void Compact(VkCommandBuffer commandBuffer, Buffer& resultBuffer, VkDeviceSize resultOffset, VkDeviceSize compactedSize);
+		void ReleaseUncompacted();
+
 		static void MemoryBarrier(VkCommandBuffer commandBuffer);
 	
 	protected:
 
-		explicit AccelerationStructure(const class DeviceProcedures& deviceProcedures, const class RayTracingProperties& rayTracingProperties);
+		AccelerationStructure(const class DeviceProcedures& deviceProcedures, const class RayTracingProperties& rayTracingProperties, VkBuildAccelerationStructureFlagsKHR flags);
 
 		VkAccelerationStructureBuildSizesInfoKHR GetBuildSizes(const uint32_t* pMaxPrimitiveCounts) const;
 		void CreateAccelerationStructure(Buffer& resultBuffer, VkDeviceSize resultOffset);
@@ -47,6 +53,8 @@ namespace Vulkan::RayTracing
 
 		const class Device& device_;
 		const class RayTracingProperties& rayTracingProperties_;
+
+		VkAccelerationStructureKHR uncompacted_{};
 		
 		VULKAN_HANDLE(VkAccelerationStructureKHR, accelerationStructure_)
 	};
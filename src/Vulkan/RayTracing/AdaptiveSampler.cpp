@@ -0,0 +1,107 @@
+#include "AdaptiveSampler.hpp"
+#include "Utilities/Exception.hpp"
+#include "Vulkan/DescriptorBinding.hpp"
+#include "Vulkan/DescriptorSetManager.hpp"
+#include "Vulkan/DescriptorSets.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/ImageView.hpp"
+#include "Vulkan/PipelineCache.hpp"
+#include "Vulkan/PipelineLayout.hpp"
+#include "Vulkan/ShaderModule.hpp"
+
+namespace Vulkan::RayTracing {
+
+VkExtent2D AdaptiveSampler::TileExtent(const VkExtent2D extent)
+{
+	return { (extent.width + TileSize - 1) / TileSize, (extent.height + TileSize - 1) / TileSize };
+}
+
+AdaptiveSampler::AdaptiveSampler(
+	const class Device& device,
+	const PipelineCache& pipelineCache,
+	const VkExtent2D extent,
+	const RayTracingPipeline::StorageImages& storageImages) :
+	device_(device)
+{
+	const std::vector<DescriptorBinding> descriptorBindings =
+	{
+		// Accumulation and sample count, per tile sample budget.
+		{0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{2, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT}
+	};
+
+	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, 1));
+
+	const VkPushConstantRange pushConstantRange = { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants) };
+	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout(), { pushConstantRange }));
+
+	const ShaderModule shader(device, "../assets/shaders/AdaptiveSampling.comp.spv");
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = shader.CreateShaderStage(VK_SHADER_STAGE_COMPUTE_BIT);
+	pipelineInfo.layout = pipelineLayout_->Handle();
+
+	Check(vkCreateComputePipelines(device.Handle(), pipelineCache.Handle(), 1, &pipelineInfo, nullptr, &pipeline_),
+		"create adaptive sampling pipeline");
+
+	Resize(extent, storageImages);
+}
+
+AdaptiveSampler::~AdaptiveSampler()
+{
+	if (pipeline_ != nullptr)
+	{
+		vkDestroyPipeline(device_.Handle(), pipeline_, nullptr);
+		pipeline_ = nullptr;
+	}
+
+	pipelineLayout_.reset();
+	descriptorSetManager_.reset();
+}
+
+void AdaptiveSampler::Resize(const VkExtent2D extent, const RayTracingPipeline::StorageImages& storageImages)
+{
+	extent_ = extent;
+
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	const auto imageInfo = [](const ImageView& imageView)
+	{
+		VkDescriptorImageInfo info = {};
+		info.imageView = imageView.Handle();
+		info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		return info;
+	};
+
+	const auto accumulationImageInfo = imageInfo(storageImages.Accumulation);
+	const auto sampleCountImageInfo = imageInfo(storageImages.SampleCount);
+	const auto sampleBudgetImageInfo = imageInfo(storageImages.SampleBudget);
+
+	descriptorSets.UpdateDescriptors(
+	{
+		descriptorSets.Bind(0, 0, accumulationImageInfo),
+		descriptorSets.Bind(0, 1, sampleCountImageInfo),
+		descriptorSets.Bind(0, 2, sampleBudgetImageInfo)
+	});
+}
+
+void AdaptiveSampler::Render(VkCommandBuffer commandBuffer, const uint32_t numberOfSamples, const float threshold) const
+{
+	VkDescriptorSet descriptorSets[] = { descriptorSetManager_->DescriptorSets().Handle(0) };
+
+	PushConstants pushConstants = {};
+	pushConstants.NumberOfSamples = numberOfSamples;
+	pushConstants.Threshold = threshold;
+
+	// One work group per tile.
+	const auto tiles = TileExtent(extent_);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout_->Handle(), 0, 1, descriptorSets, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, pipelineLayout_->Handle(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+	vkCmdDispatch(commandBuffer, tiles.width, tiles.height, 1);
+}
+
+}
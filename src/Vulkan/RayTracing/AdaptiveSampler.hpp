@@ -0,0 +1,70 @@
+#pragma once
+
+#include "RayTracingPipeline.hpp"
+#include "Vulkan/Vulkan.hpp"
+#include <memory>
+
+namespace Vulkan
+{
+	class DescriptorSetManager;
+	class Device;
+	class PipelineCache;
+	class PipelineLayout;
+}
+
+namespace Vulkan::RayTracing
+{
+	// Spends the samples of a frame where the image is still noisy. A compute pass estimates, per tile of pixels, how
+	// many more samples the noisiest pixel needs for the standard error of its displayed value to drop below a threshold,
+	// from the luminance moments of the accumulation image. The ray generation shader then traces that many samples
+	// (at most the per frame number of samples), converged tiles are not traced at all.
+	class AdaptiveSampler final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(AdaptiveSampler)
+
+		// Must match RayTracing.rgen and AdaptiveSampling.comp.
+		static constexpr uint32_t TileSize = 8;
+
+		struct Settings final
+		{
+			bool Enabled;
+			float Threshold; // standard error of the displayed value, in [0, 1]
+		};
+
+		// Per pass data, see AdaptiveSampling.comp.
+		struct PushConstants final
+		{
+			uint32_t NumberOfSamples;
+			float Threshold;
+		};
+
+		static VkExtent2D TileExtent(VkExtent2D extent);
+
+		AdaptiveSampler(
+			const Device& device,
+			const PipelineCache& pipelineCache,
+			VkExtent2D extent,
+			const RayTracingPipeline::StorageImages& storageImages);
+		~AdaptiveSampler();
+
+		// Rebinds the storage images, e.g. after a resize. The pipeline is kept.
+		// The descriptor set must not be in use by the device.
+		void Resize(VkExtent2D extent, const RayTracingPipeline::StorageImages& storageImages);
+
+		// Writes the sample budget of each tile. The accumulation and sample count images must hold the previous frames.
+		void Render(VkCommandBuffer commandBuffer, uint32_t numberOfSamples, float threshold) const;
+
+	private:
+
+		const class Device& device_;
+		VkExtent2D extent_{};
+
+		std::unique_ptr<DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<PipelineLayout> pipelineLayout_;
+
+		VkPipeline pipeline_{};
+	};
+
+}
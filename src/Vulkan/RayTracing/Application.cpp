@@ -1,21 +1,32 @@
 #include "Application.hpp"
+#include "AdaptiveSampler.hpp"
 #include "BottomLevelAccelerationStructure.hpp"
 #include "DeviceProcedures.hpp"
+#include "PathCounters.hpp"
 #include "RayTracingPipeline.hpp"
 #include "ShaderBindingTable.hpp"
+#include "TemporalReprojection.hpp"
 #include "TopLevelAccelerationStructure.hpp"
+#include "WavefrontPathTracer.hpp"
 #include "Assets/Model.hpp"
 #include "Assets/Scene.hpp"
+#include "Utilities/Exception.hpp"
 #include "Utilities/Glm.hpp"
+#include "Utilities/StbImage.hpp"
 #include "Vulkan/Buffer.hpp"
 #include "Vulkan/BufferUtil.hpp"
+#include "Vulkan/Enumerate.hpp"
+#include "Vulkan/GpuProfiler.hpp"
 #include "Vulkan/Image.hpp"
 #include "Vulkan/ImageMemoryBarrier.hpp"
 #include "Vulkan/ImageView.hpp"
 #include "Vulkan/PipelineLayout.hpp"
+#include "Vulkan/QueryPool.hpp"
 #include "Vulkan/SingleTimeCommands.hpp"
 #include "Vulkan/SwapChain.hpp"
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <iostream>
 #include <numeric>
 
@@ -38,6 +49,11 @@ namespace
 
 		return total;
 	}
+
+	VkDeviceSize RoundUp(const VkDeviceSize size, const VkDeviceSize granularity)
+	{
+		return (size + granularity - 1) / granularity * granularity;
+	}
 }
 
 Application::Application(const WindowConfig& windowConfig, const VkPresentModeKHR presentMode, const bool enableValidationLayers) :
@@ -50,6 +66,10 @@ Application::~Application()
 	Application::DeleteSwapChain();
 	DeleteAccelerationStructures();
 
+	adaptiveSampler_.reset();
+	temporalReprojection_.reset();
+	denoiser_.reset();
+	pathCounters_.reset();
 	rayTracingProperties_.reset();
 	deviceProcedures_.reset();
 }
@@ -90,7 +110,39 @@ void Application::SetPhysicalDevice(
 	rayTracingFeatures.pNext = &accelerationStructureFeatures;
 	rayTracingFeatures.rayTracingPipeline = true;
 
-	Vulkan::Application::SetPhysicalDevice(physicalDevice, requiredExtensions, deviceFeatures, &rayTracingFeatures);
+	// Ray queries, for the wavefront path tracer, only when the device has them.
+	const auto extensions = GetEnumerateVector(physicalDevice, static_cast<const char*>(nullptr), vkEnumerateDeviceExtensionProperties);
+
+	const bool hasRayQueryExtension = std::any_of(extensions.begin(), extensions.end(), [](const VkExtensionProperties& extension)
+	{
+		return std::strcmp(extension.extensionName, VK_KHR_RAY_QUERY_EXTENSION_NAME) == 0;
+	});
+
+	VkPhysicalDeviceRayQueryFeaturesKHR rayQueryFeatures = {};
+	rayQueryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR;
+
+	if (hasRayQueryExtension)
+	{
+		VkPhysicalDeviceFeatures2 features = {};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &rayQueryFeatures;
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+	}
+
+	hasRayQuery_ = hasRayQueryExtension && rayQueryFeatures.rayQuery;
+
+	if (!hasRayQuery_)
+	{
+		Vulkan::Application::SetPhysicalDevice(physicalDevice, requiredExtensions, deviceFeatures, &rayTracingFeatures);
+		return;
+	}
+
+	requiredExtensions.push_back(VK_KHR_RAY_QUERY_EXTENSION_NAME);
+
+	rayQueryFeatures.pNext = &rayTracingFeatures;
+	rayQueryFeatures.rayQuery = true;
+
+	Vulkan::Application::SetPhysicalDevice(physicalDevice, requiredExtensions, deviceFeatures, &rayQueryFeatures);
 }
 
 void Application::OnDeviceSet()
@@ -101,13 +153,23 @@ void Application::OnDeviceSet()
 	rayTracingProperties_.reset(new RayTracingProperties(Device()));
 }
 
-void Application::CreateAccelerationStructures()
+void Application::CreateAccelerationStructures(const bool compactBottomLevelStructures)
 {
 	const auto timer = std::chrono::high_resolution_clock::now();
 
+	SingleTimeCommands::Submit(CommandPool(), [this, compactBottomLevelStructures](VkCommandBuffer commandBuffer)
+	{
+		CreateBottomLevelStructures(commandBuffer, compactBottomLevelStructures);
+	});
+
+	// The compacted sizes are only known once the builds have completed.
+	if (compactBottomLevelStructures)
+	{
+		CompactBottomLevelStructures();
+	}
+
 	SingleTimeCommands::Submit(CommandPool(), [this](VkCommandBuffer commandBuffer)
 	{
-		CreateBottomLevelStructures(commandBuffer);
 		CreateTopLevelStructures(commandBuffer);
 	});
 
@@ -122,6 +184,9 @@ void Application::CreateAccelerationStructures()
 
 void Application::DeleteAccelerationStructures()
 {
+	// The pipeline descriptors reference the top level structure and the scene buffers.
+	DeleteRayTracingPipeline();
+
 	topAs_.clear();
 	instancesBuffer_.reset();
 	instancesBufferMemory_.reset();
@@ -131,6 +196,7 @@ void Application::DeleteAccelerationStructures()
 	topBufferMemory_.reset();
 
 	bottomAs_.clear();
+	bottomCompactedSizeQueries_.reset();
 	bottomScratchBuffer_.reset();
 	bottomScratchBufferMemory_.reset();
 	bottomBuffer_.reset();
@@ -143,19 +209,62 @@ void Application::CreateSwapChain()
 
 	CreateOutputImage();
 
-	rayTracingPipeline_.reset(new RayTracingPipeline(*deviceProcedures_, SwapChain(), topAs_[0], *accumulationImageView_, *outputImageView_, UniformBuffers(), GetScene()));
+	// The compute passes only depend on the device, a resize re-creates their images and rebinds the storage images.
+	if (denoiser_)
+	{
+		denoiser_->Resize(Extent(), GetStorageImages());
+		temporalReprojection_->Resize(Extent(), GetStorageImages());
+		adaptiveSampler_->Resize(Extent(), GetStorageImages());
+	}
+	else
+	{
+		denoiser_.reset(new Denoiser(Device(), PipelineCache(), Extent(), GetStorageImages()));
+		temporalReprojection_.reset(new TemporalReprojection(Device(), PipelineCache(), Extent(), GetStorageImages()));
+		adaptiveSampler_.reset(new AdaptiveSampler(Device(), PipelineCache(), Extent(), GetStorageImages()));
+	}
 
-	const std::vector<ShaderBindingTable::Entry> rayGenPrograms = { {rayTracingPipeline_->RayGenShaderIndex(), {}} };
-	const std::vector<ShaderBindingTable::Entry> missPrograms = { {rayTracingPipeline_->MissShaderIndex(), {}} };
-	const std::vector<ShaderBindingTable::Entry> hitGroups = { {rayTracingPipeline_->TriangleHitGroupIndex(), {}}, {rayTracingPipeline_->ProceduralHitGroupIndex(), {}} };
+	// One path counter slice per frame in flight, like the uniform buffer. The pipeline is bound to the old slices.
+	if (!pathCounters_ || pathCounters_->SliceCount() != UniformBuffer().SliceCount())
+	{
+		DeleteRayTracingPipeline();
+		pathCounters_.reset(new PathCounters(Device(), UniformBuffer().SliceCount()));
+	}
 
-	shaderBindingTable_.reset(new ShaderBindingTable(*deviceProcedures_, *rayTracingPipeline_, *rayTracingProperties_, rayGenPrograms, missPrograms, hitGroups));
+	// The pipelines and the shader binding table only depend on the device and the scene (see DeleteAccelerationStructures()),
+	// a resize only needs the storage images to be rebound and the wavefront path buffers to be re-created.
+	// The device is idle during swap-chain recreation.
+	if (rayTracingPipeline_ && &rayTracingPipeline_->UniformBuffer() == &UniformBuffer())
+	{
+		rayTracingPipeline_->UpdateOutputImages(GetStorageImages());
+
+		if (wavefrontPathTracer_)
+		{
+			wavefrontPathTracer_->Resize(Extent(), GetStorageImages());
+		}
+
+		return;
+	}
+
+	CreateRayTracingPipeline();
 }
 
 void Application::DeleteSwapChain()
 {
-	shaderBindingTable_.reset();
-	rayTracingPipeline_.reset();
+	sampleBudgetImageView_.reset();
+	sampleBudgetImage_.reset();
+	sampleBudgetImageMemory_.reset();
+	motionImageView_.reset();
+	motionImage_.reset();
+	motionImageMemory_.reset();
+	sampleCountImageView_.reset();
+	sampleCountImage_.reset();
+	sampleCountImageMemory_.reset();
+	albedoImageView_.reset();
+	albedoImage_.reset();
+	albedoImageMemory_.reset();
+	normalDepthImageView_.reset();
+	normalDepthImage_.reset();
+	normalDepthImageMemory_.reset();
 	outputImageView_.reset();
 	outputImage_.reset();
 	outputImageMemory_.reset();
@@ -166,11 +275,21 @@ void Application::DeleteSwapChain()
 	Vulkan::Application::DeleteSwapChain();
 }
 
+void Application::DrawFrame()
+{
+	// The engine can be switched at any time, build the wavefront pipelines before the frame starts recording.
+	CreateWavefrontPathTracer();
+
+	Vulkan::Application::DrawFrame();
+}
+
 void Application::Render(VkCommandBuffer commandBuffer, const size_t currentFrame, const uint32_t imageIndex)
 {
-	const auto extent = SwapChain().Extent();
+	const auto extent = Extent();
 
-	VkDescriptorSet descriptorSets[] = { rayTracingPipeline_->DescriptorSet(currentFrame) };
+	VkDescriptorSet descriptorSets[] = { rayTracingPipeline_->DescriptorSet() };
+	const uint32_t dynamicOffsets[] = { UniformBuffer().SliceOffset(currentFrame), pathCounters_->SliceOffset(currentFrame) };
+	const auto pushConstants = GetPushConstants();
 
 	VkImageSubresourceRange subresourceRange = {};
 	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -179,44 +298,129 @@ void Application::Render(VkCommandBuffer commandBuffer, const size_t currentFram
 	subresourceRange.baseArrayLayer = 0;
 	subresourceRange.layerCount = 1;
 
-	// Acquire destination images for rendering.
-	ImageMemoryBarrier::Insert(commandBuffer, accumulationImage_->Handle(), subresourceRange, 0,
-		VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+	// The fence of this frame has been waited on, its counters hold the paths it traced last time around.
+	const auto averagePathLength = pathCounters_->AveragePathLength(currentFrame);
+	averagePathLength_ = averagePathLength != 0 ? averagePathLength : averagePathLength_;
+	pathCounters_->Reset(commandBuffer, currentFrame);
+
+	// The camera moved, keep the previous frame before the trace restarts the accumulation.
+	const auto reprojectionSettings = GetTemporalReprojectionSettings();
+
+	if (reprojectionSettings.Reproject)
+	{
+		temporalReprojection_->SaveHistory(commandBuffer, *accumulationImage_, *sampleCountImage_, *normalDepthImage_);
+	}
 
+	// Acquire destination images for rendering. The output image is overwritten, the others hold the history of the
+	// previous frames (see CreateOutputImage()), whose writes must be visible to this frame.
 	ImageMemoryBarrier::Insert(commandBuffer, outputImage_->Handle(), subresourceRange, 0,
 		VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
 
-	// Bind ray tracing pipeline.
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rayTracingPipeline_->Handle());
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rayTracingPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 0, nullptr);
+	for (const auto& image : { accumulationImage_.get(), normalDepthImage_.get(), albedoImage_.get(), sampleCountImage_.get(), motionImage_.get(), sampleBudgetImage_.get() })
+	{
+		ImageMemoryBarrier::Insert(commandBuffer, image->Handle(), subresourceRange, VK_ACCESS_SHADER_WRITE_BIT,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+	}
+
+	// Spend the samples of this frame where the accumulated image is still noisy (not on the first frame, there is no variance yet).
+	const auto adaptiveSamplingSettings = GetAdaptiveSamplingSettings();
+
+	if (adaptiveSamplingSettings.Enabled && pushConstants.NumberOfSamples != pushConstants.TotalNumberOfSamples)
+	{
+		GpuProfiler().BeginScope(commandBuffer, "Allocate");
+		adaptiveSampler_->Render(commandBuffer, pushConstants.NumberOfSamples, adaptiveSamplingSettings.Threshold);
+		GpuProfiler().EndScope(commandBuffer);
+
+		ImageMemoryBarrier::Insert(commandBuffer, sampleBudgetImage_->Handle(), subresourceRange,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+	}
+
+	// The wavefront path tracer traces the same paths with compute stages, into the same storage images.
+	const auto wavefrontSettings = GetWavefrontSettings();
 
-	// Describe the shader binding table.
-	VkStridedDeviceAddressRegionKHR raygenShaderBindingTable = {};
-	raygenShaderBindingTable.deviceAddress = shaderBindingTable_->RayGenDeviceAddress();
-	raygenShaderBindingTable.stride = shaderBindingTable_->RayGenEntrySize();
-	raygenShaderBindingTable.size = shaderBindingTable_->RayGenSize();
+	if (wavefrontSettings.Enabled)
+	{
+		GpuProfiler().BeginScope(commandBuffer, "Trace");
+		wavefrontPathTracer_->Render(commandBuffer, dynamicOffsets, pushConstants, wavefrontSettings.NumberOfBounces);
+		GpuProfiler().EndScope(commandBuffer);
+	}
+	else
+	{
+		// Bind ray tracing pipeline.
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rayTracingPipeline_->Handle());
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rayTracingPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 2, dynamicOffsets);
+		vkCmdPushConstants(commandBuffer, rayTracingPipeline_->PipelineLayout().Handle(), VK_SHADER_STAGE_RAYGEN_BIT_KHR, 0, sizeof(pushConstants), &pushConstants);
+
+		// Describe the shader binding table.
+		VkStridedDeviceAddressRegionKHR raygenShaderBindingTable = {};
+		raygenShaderBindingTable.deviceAddress = shaderBindingTable_->RayGenDeviceAddress();
+		raygenShaderBindingTable.stride = shaderBindingTable_->RayGenEntrySize();
+		raygenShaderBindingTable.size = shaderBindingTable_->RayGenSize();
+
+		VkStridedDeviceAddressRegionKHR missShaderBindingTable = {};
+		missShaderBindingTable.deviceAddress = shaderBindingTable_->MissDeviceAddress();
+		missShaderBindingTable.stride = shaderBindingTable_->MissEntrySize();
+		missShaderBindingTable.size = shaderBindingTable_->MissSize();
+
+		VkStridedDeviceAddressRegionKHR hitShaderBindingTable = {};
+		hitShaderBindingTable.deviceAddress = shaderBindingTable_->HitGroupDeviceAddress();
+		hitShaderBindingTable.stride = shaderBindingTable_->HitGroupEntrySize();
+		hitShaderBindingTable.size = shaderBindingTable_->HitGroupSize();
+
+		VkStridedDeviceAddressRegionKHR callableShaderBindingTable = {};
+
+		// Execute ray tracing shaders.
+		GpuProfiler().BeginScope(commandBuffer, "Trace");
+		deviceProcedures_->vkCmdTraceRaysKHR(commandBuffer,
+			&raygenShaderBindingTable, &missShaderBindingTable, &hitShaderBindingTable, &callableShaderBindingTable,
+			extent.width, extent.height, 1);
+		GpuProfiler().EndScope(commandBuffer);
+	}
 
-	VkStridedDeviceAddressRegionKHR missShaderBindingTable = {};
-	missShaderBindingTable.deviceAddress = shaderBindingTable_->MissDeviceAddress();
-	missShaderBindingTable.stride = shaderBindingTable_->MissEntrySize();
-	missShaderBindingTable.size = shaderBindingTable_->MissSize();
+	pathCounters_->Release(commandBuffer, currentFrame);
 
-	VkStridedDeviceAddressRegionKHR hitShaderBindingTable = {};
-	hitShaderBindingTable.deviceAddress = shaderBindingTable_->HitGroupDeviceAddress();
-	hitShaderBindingTable.stride = shaderBindingTable_->HitGroupEntrySize();
-	hitShaderBindingTable.size = shaderBindingTable_->HitGroupSize();
+	// Add the reprojected history to the new samples.
+	if (reprojectionSettings.Reproject)
+	{
+		for (const auto& image : { accumulationImage_.get(), sampleCountImage_.get(), normalDepthImage_.get(), motionImage_.get(), outputImage_.get() })
+		{
+			ImageMemoryBarrier::Insert(commandBuffer, image->Handle(), subresourceRange,
+				VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+		}
 
-	VkStridedDeviceAddressRegionKHR callableShaderBindingTable = {};
+		GpuProfiler().BeginScope(commandBuffer, "Reproject");
+		temporalReprojection_->Render(commandBuffer, reprojectionSettings.MaxHistoryLength);
+		GpuProfiler().EndScope(commandBuffer);
+	}
+
+	// Filter the accumulated image into the output image.
+	const auto denoiserSettings = GetDenoiserSettings();
 
-	// Execute ray tracing shaders.
-	deviceProcedures_->vkCmdTraceRaysKHR(commandBuffer,
-		&raygenShaderBindingTable, &missShaderBindingTable, &hitShaderBindingTable, &callableShaderBindingTable,
-		extent.width, extent.height, 1);
+	if (denoiserSettings.Enabled)
+	{
+		for (const auto& image : { accumulationImage_.get(), normalDepthImage_.get(), albedoImage_.get(), sampleCountImage_.get(), outputImage_.get() })
+		{
+			ImageMemoryBarrier::Insert(commandBuffer, image->Handle(), subresourceRange,
+				VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+		}
+
+		GpuProfiler().BeginScope(commandBuffer, "Denoise");
+		denoiser_->Render(commandBuffer, denoiserSettings.Iterations);
+		GpuProfiler().EndScope(commandBuffer);
+	}
 
 	// Acquire output image and swap-chain image for copying.
 	ImageMemoryBarrier::Insert(commandBuffer, outputImage_->Handle(), subresourceRange, 
 		VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
 
+	// Offscreen rendering has no swap-chain, the output image is left for SaveOutputImage() to read back.
+	if (IsHeadless())
+	{
+		return;
+	}
+
+	GpuProfiler().BeginScope(commandBuffer, "Copy");
+
 	ImageMemoryBarrier::Insert(commandBuffer, SwapChain().Images()[imageIndex], subresourceRange, 0,
 		VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
@@ -235,34 +439,59 @@ void Application::Render(VkCommandBuffer commandBuffer, const size_t currentFram
 
 	ImageMemoryBarrier::Insert(commandBuffer, SwapChain().Images()[imageIndex], subresourceRange, VK_ACCESS_TRANSFER_WRITE_BIT,
 		0, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+
+	GpuProfiler().EndScope(commandBuffer);
+}
+
+void Application::UpdateTextureDescriptors()
+{
+	Vulkan::Application::UpdateTextureDescriptors();
+
+	if (rayTracingPipeline_)
+	{
+		rayTracingPipeline_->UpdateTextures(GetScene());
+	}
+
+	if (wavefrontPathTracer_)
+	{
+		wavefrontPathTracer_->UpdateTextures(GetScene());
+	}
 }
 
-void Application::CreateBottomLevelStructures(VkCommandBuffer commandBuffer)
+void Application::CreateBottomLevelStructures(VkCommandBuffer commandBuffer, const bool allowCompaction)
 {
 	const auto& scene = GetScene();
 	const auto& debugUtils = Device().DebugUtils();
 	
 	// Bottom level acceleration structure
-	// Triangles via vertex buffers. Procedurals via AABBs.
+	// Triangles via vertex buffers, one BLAS per triangle model, with 16 or 32-bit indices.
 	uint32_t vertexOffset = 0;
-	uint32_t indexOffset = 0;
-	uint32_t aabbOffset = 0;
 
-	for (const auto& model : scene.Models())
+	for (size_t i = 0; i != scene.Models().size(); ++i)
 	{
+		const auto& model = scene.Models()[i];
+		const auto& indices = scene.ModelIndexRanges()[i];
 		const auto vertexCount = static_cast<uint32_t>(model.NumberOfVertices());
 		const auto indexCount = static_cast<uint32_t>(model.NumberOfIndices());
-		BottomLevelGeometry geometries;
-		
-		model.Procedural()
-			? geometries.AddGeometryAabb(scene, aabbOffset, 1, true)
-			: geometries.AddGeometryTriangles(scene, vertexOffset, vertexCount, indexOffset, indexCount, true);
 
-		bottomAs_.emplace_back(*deviceProcedures_, *rayTracingProperties_, geometries);
+		if (!model.Procedural())
+		{
+			BottomLevelGeometry geometries;
+			geometries.AddGeometryTriangles(scene, vertexOffset, vertexCount, static_cast<uint32_t>(indices.ByteOffset()), indexCount, indices.IndexType, true);
+
+			bottomAs_.emplace_back(*deviceProcedures_, *rayTracingProperties_, geometries, allowCompaction);
+		}
+
+		vertexOffset += vertexCount * sizeof(glm::vec3);
+	}
+
+	// Procedurals via AABBs, all of them in a single BLAS placed last.
+	if (scene.HasProcedurals())
+	{
+		BottomLevelGeometry geometries;
+		geometries.AddGeometryAabb(scene, 0, scene.NumberOfProcedurals(), true);
 
-		vertexOffset += vertexCount * sizeof(Assets::Vertex);
-		indexOffset += indexCount * sizeof(uint32_t);
-		aabbOffset += sizeof(VkAabbPositionsKHR);
+		bottomAs_.emplace_back(*deviceProcedures_, *rayTracingProperties_, geometries, allowCompaction);
 	}
 
 	// Allocate the structures memory.
@@ -274,9 +503,7 @@ void Application::CreateBottomLevelStructures(VkCommandBuffer commandBuffer)
 	bottomScratchBufferMemory_.reset(new DeviceMemory(bottomScratchBuffer_->AllocateMemory(VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
 
 	debugUtils.SetObjectName(bottomBuffer_->Handle(), "BLAS Buffer");
-	debugUtils.SetObjectName(bottomBufferMemory_->Handle(), "BLAS Memory");
 	debugUtils.SetObjectName(bottomScratchBuffer_->Handle(), "BLAS Scratch Buffer");
-	debugUtils.SetObjectName(bottomScratchBufferMemory_->Handle(), "BLAS Scratch Memory");
 
 	// Generate the structures.
 	VkDeviceSize resultOffset = 0;
@@ -291,6 +518,82 @@ void Application::CreateBottomLevelStructures(VkCommandBuffer commandBuffer)
 
 		debugUtils.SetObjectName(bottomAs_[i].Handle(), ("BLAS #" + std::to_string(i)).c_str());
 	}
+
+	// Query the compacted sizes once the builds are done.
+	if (allowCompaction)
+	{
+		std::vector<VkAccelerationStructureKHR> structures;
+
+		for (const auto& blas : bottomAs_)
+		{
+			structures.push_back(blas.Handle());
+		}
+
+		const auto count = static_cast<uint32_t>(structures.size());
+
+		bottomCompactedSizeQueries_.reset(new QueryPool(Device(), VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR, count));
+		bottomCompactedSizeQueries_->Reset(commandBuffer, 0, count);
+
+		AccelerationStructure::MemoryBarrier(commandBuffer);
+
+		deviceProcedures_->vkCmdWriteAccelerationStructuresPropertiesKHR(commandBuffer, count, structures.data(), 
+			VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR, bottomCompactedSizeQueries_->Handle(), 0);
+	}
+}
+
+void Application::CompactBottomLevelStructures()
+{
+	const auto& debugUtils = Device().DebugUtils();
+
+	std::vector<uint64_t> compactedSizes;
+	bottomCompactedSizeQueries_->GetResults(0, bottomCompactedSizeQueries_->QueryCount(), VK_QUERY_RESULT_WAIT_BIT, compactedSizes);
+	bottomCompactedSizeQueries_.reset();
+
+	// Same 256 bytes alignment as the original structures.
+	VkDeviceSize totalSize = 0;
+
+	for (const auto size : compactedSizes)
+	{
+		totalSize += RoundUp(size, 256);
+	}
+
+	std::unique_ptr<Buffer> compactedBuffer(new Buffer(Device(), totalSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT));
+	std::unique_ptr<DeviceMemory> compactedBufferMemory(new DeviceMemory(compactedBuffer->AllocateMemory(VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+
+	std::vector<VkDeviceSize> originalSizes;
+
+	SingleTimeCommands::Submit(CommandPool(), [&](VkCommandBuffer commandBuffer)
+	{
+		VkDeviceSize resultOffset = 0;
+
+		for (size_t i = 0; i != bottomAs_.size(); ++i)
+		{
+			originalSizes.push_back(bottomAs_[i].BuildSizes().accelerationStructureSize);
+			bottomAs_[i].Compact(commandBuffer, *compactedBuffer, resultOffset, compactedSizes[i]);
+			resultOffset += RoundUp(compactedSizes[i], 256);
+		}
+	});
+
+	// The copies have completed, release the original structures and their memory.
+	for (size_t i = 0; i != bottomAs_.size(); ++i)
+	{
+		bottomAs_[i].ReleaseUncompacted();
+		debugUtils.SetObjectName(bottomAs_[i].Handle(), ("BLAS #" + std::to_string(i)).c_str());
+	}
+
+	const auto totalOriginalSize = bottomBuffer_->GetMemoryRequirements().size;
+
+	bottomBuffer_ = std::move(compactedBuffer);
+	bottomBufferMemory_ = std::move(compactedBufferMemory);
+
+	debugUtils.SetObjectName(bottomBuffer_->Handle(), "BLAS Buffer");
+
+	for (size_t i = 0; i != bottomAs_.size(); ++i)
+	{
+		std::cout << "- compacted BLAS #" << i << ": " << originalSizes[i] / 1024 << " KiB -> " << compactedSizes[i] / 1024 << " KiB" << std::endl;
+	}
+
+	std::cout << "- compacted BLAS memory: " << totalOriginalSize / 1024 << " KiB -> " << totalSize / 1024 << " KiB" << std::endl;
 }
 
 void Application::CreateTopLevelStructures(VkCommandBuffer commandBuffer)
@@ -303,15 +606,38 @@ void Application::CreateTopLevelStructures(VkCommandBuffer commandBuffer)
 
 	// Hit group 0: triangles
 	// Hit group 1: procedurals
-	uint32_t instanceId = 0;
+	// Hit group 2+: triangles of a single material (see GetHitGroupMaterials())
+	// Instances of the same model share its BLAS. Procedural instances are already baked in their own BLAS.
+	const auto hitGroupMaterials = GetHitGroupMaterials();
+	std::vector<uint32_t> modelBottomAs;
+	uint32_t triangleModels = 0;
 
 	for (const auto& model : scene.Models())
 	{
-		instances.push_back(TopLevelAccelerationStructure::CreateInstance(
-			bottomAs_[instanceId], glm::mat4(1), instanceId, model.Procedural() ? 1 : 0));
+		modelBottomAs.push_back(model.Procedural() ? 0 : triangleModels++);
+	}
+
+	uint32_t instanceId = 0;
+
+	for (const auto& instance : scene.Instances())
+	{
+		if (!scene.Models()[instance.ModelId].Procedural())
+		{
+			const auto material = std::find(hitGroupMaterials.begin(), hitGroupMaterials.end(), static_cast<uint32_t>(scene.InstanceMaterials()[instanceId]));
+			const auto hitGroup = material != hitGroupMaterials.end() ? 2 + static_cast<uint32_t>(material - hitGroupMaterials.begin()) : 0;
+
+			instances.push_back(TopLevelAccelerationStructure::CreateInstance(
+				bottomAs_[modelBottomAs[instance.ModelId]], instance.Transform, instanceId, hitGroup));
+		}
+
 		instanceId++;
 	}
 
+	if (scene.HasProcedurals())
+	{
+		instances.push_back(TopLevelAccelerationStructure::CreateInstance(bottomAs_.back(), glm::mat4(1), 0, 1));
+	}
+
 	// Create and copy instances buffer (do it in a separate one-time synchronous command buffer).
 	BufferUtil::CreateDeviceBuffer(CommandPool(), "TLAS Instances", VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, instances, instancesBuffer_, instancesBufferMemory_);
 
@@ -331,11 +657,8 @@ void Application::CreateTopLevelStructures(VkCommandBuffer commandBuffer)
 
 	
 	debugUtils.SetObjectName(topBuffer_->Handle(), "TLAS Buffer");
-	debugUtils.SetObjectName(topBufferMemory_->Handle(), "TLAS Memory");
 	debugUtils.SetObjectName(topScratchBuffer_->Handle(), "TLAS Scratch Buffer");
-	debugUtils.SetObjectName(topScratchBufferMemory_->Handle(), "TLAS Scratch Memory");
 	debugUtils.SetObjectName(instancesBuffer_->Handle(), "TLAS Instances Buffer");
-	debugUtils.SetObjectName(instancesBufferMemory_->Handle(), "TLAS Instances Memory");
 
 	// Generate the structures.
 	topAs_[0].Generate(commandBuffer, *topScratchBuffer_, 0, *topBuffer_, 0);
@@ -343,13 +666,77 @@ void Application::CreateTopLevelStructures(VkCommandBuffer commandBuffer)
 	debugUtils.SetObjectName(topAs_[0].Handle(), "TLAS");
 }
 
+std::vector<uint32_t> Application::GetHitGroupMaterials() const
+{
+	// The distinct materials of the triangle instances that use a single one, if its model has a specialized hit group.
+	const auto& scene = GetScene();
+	std::vector<uint32_t> materials;
+
+	for (const auto materialIndex : scene.InstanceMaterials())
+	{
+		if (materialIndex < 0 || std::find(materials.begin(), materials.end(), static_cast<uint32_t>(materialIndex)) != materials.end())
+		{
+			continue;
+		}
+
+		if (scene.Materials()[materialIndex].MaterialModel != Assets::Material::Enum::Isotropic)
+		{
+			materials.push_back(static_cast<uint32_t>(materialIndex));
+		}
+	}
+
+	return materials;
+}
+
+void Application::CreateRayTracingPipeline()
+{
+	DeleteRayTracingPipeline();
+
+	rayTracingPipeline_.reset(new RayTracingPipeline(*deviceProcedures_, Device(), PipelineCache(), topAs_[0], GetStorageImages(), UniformBuffer(), *pathCounters_, GetScene()));
+
+	const std::vector<ShaderBindingTable::Entry> rayGenPrograms = { {rayTracingPipeline_->RayGenShaderIndex(), {}} };
+	const std::vector<ShaderBindingTable::Entry> missPrograms = { {rayTracingPipeline_->MissShaderIndex(), {}}, {rayTracingPipeline_->ShadowMissShaderIndex(), {}} };
+	std::vector<ShaderBindingTable::Entry> hitGroups = { {rayTracingPipeline_->TriangleHitGroupIndex(), {}}, {rayTracingPipeline_->ProceduralHitGroupIndex(), {}} };
+
+	// One record per material of the instances with a single material, in the order of GetHitGroupMaterials().
+	for (const auto materialIndex : GetHitGroupMaterials())
+	{
+		const auto& material = GetScene().Materials()[materialIndex];
+		const auto* const data = reinterpret_cast<const unsigned char*>(&material);
+
+		hitGroups.push_back({ rayTracingPipeline_->MaterialHitGroupIndex(material.MaterialModel), std::vector<unsigned char>(data, data + sizeof(material)) });
+	}
+
+	shaderBindingTable_.reset(new ShaderBindingTable(*deviceProcedures_, *rayTracingPipeline_, *rayTracingProperties_, rayGenPrograms, missPrograms, hitGroups));
+
+	CreateWavefrontPathTracer();
+}
+
+void Application::CreateWavefrontPathTracer()
+{
+	// Only when selected, its path buffers take a lot of memory at high resolutions.
+	if (wavefrontPathTracer_ || !GetWavefrontSettings().Enabled)
+	{
+		return;
+	}
+
+	wavefrontPathTracer_.reset(new WavefrontPathTracer(Device(), PipelineCache(), Extent(), topAs_[0], GetStorageImages(), UniformBuffer(), *pathCounters_, GetScene()));
+}
+
+void Application::DeleteRayTracingPipeline()
+{
+	wavefrontPathTracer_.reset();
+	shaderBindingTable_.reset();
+	rayTracingPipeline_.reset();
+}
+
 void Application::CreateOutputImage()
 {
-	const auto extent = SwapChain().Extent();
-	const auto format = SwapChain().Format();
+	const auto extent = Extent();
+	const auto format = IsHeadless() ? VK_FORMAT_R8G8B8A8_UNORM : SwapChain().Format();
 	const auto tiling = VK_IMAGE_TILING_OPTIMAL;
 
-	accumulationImage_.reset(new Image(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT));
+	accumulationImage_.reset(new Image(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT));
 	accumulationImageMemory_.reset(new DeviceMemory(accumulationImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
 	accumulationImageView_.reset(new ImageView(Device(), accumulationImage_->Handle(), VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
 
@@ -357,16 +744,117 @@ void Application::CreateOutputImage()
 	outputImageMemory_.reset(new DeviceMemory(outputImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
 	outputImageView_.reset(new ImageView(Device(), outputImage_->Handle(), format, VK_IMAGE_ASPECT_COLOR_BIT));
 
+	normalDepthImage_.reset(new Image(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, tiling, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT));
+	normalDepthImageMemory_.reset(new DeviceMemory(normalDepthImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	normalDepthImageView_.reset(new ImageView(Device(), normalDepthImage_->Handle(), VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	albedoImage_.reset(new Image(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, tiling, VK_IMAGE_USAGE_STORAGE_BIT));
+	albedoImageMemory_.reset(new DeviceMemory(albedoImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	albedoImageView_.reset(new ImageView(Device(), albedoImage_->Handle(), VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	sampleCountImage_.reset(new Image(Device(), extent, VK_FORMAT_R32_SFLOAT, tiling, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT));
+	sampleCountImageMemory_.reset(new DeviceMemory(sampleCountImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	sampleCountImageView_.reset(new ImageView(Device(), sampleCountImage_->Handle(), VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	motionImage_.reset(new Image(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, tiling, VK_IMAGE_USAGE_STORAGE_BIT));
+	motionImageMemory_.reset(new DeviceMemory(motionImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	motionImageView_.reset(new ImageView(Device(), motionImage_->Handle(), VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	const auto tileExtent = AdaptiveSampler::TileExtent(extent);
+
+	sampleBudgetImage_.reset(new Image(Device(), tileExtent, VK_FORMAT_R32_UINT, tiling, VK_IMAGE_USAGE_STORAGE_BIT));
+	sampleBudgetImageMemory_.reset(new DeviceMemory(sampleBudgetImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	sampleBudgetImageView_.reset(new ImageView(Device(), sampleBudgetImage_->Handle(), VK_FORMAT_R32_UINT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	// All but the output image are read back by the following frames, they stay in the general layout from now on.
+	SingleTimeCommands::Submit(CommandPool(), [&](VkCommandBuffer commandBuffer)
+	{
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.levelCount = 1;
+		subresourceRange.layerCount = 1;
+
+		for (const auto& image : { accumulationImage_.get(), normalDepthImage_.get(), albedoImage_.get(), sampleCountImage_.get(), motionImage_.get(), sampleBudgetImage_.get() })
+		{
+			ImageMemoryBarrier::Insert(commandBuffer, image->Handle(), subresourceRange, 0,
+				VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+		}
+	});
+
 	const auto& debugUtils = Device().DebugUtils();
 	
 	debugUtils.SetObjectName(accumulationImage_->Handle(), "Accumulation Image");
-	debugUtils.SetObjectName(accumulationImageMemory_->Handle(), "Accumulation Image Memory");
 	debugUtils.SetObjectName(accumulationImageView_->Handle(), "Accumulation ImageView");
 	
 	debugUtils.SetObjectName(outputImage_->Handle(), "Output Image");
-	debugUtils.SetObjectName(outputImageMemory_->Handle(), "Output Image Memory");
 	debugUtils.SetObjectName(outputImageView_->Handle(), "Output ImageView");
 
+	debugUtils.SetObjectName(normalDepthImage_->Handle(), "Normal Depth Image");
+	debugUtils.SetObjectName(normalDepthImageView_->Handle(), "Normal Depth ImageView");
+
+	debugUtils.SetObjectName(albedoImage_->Handle(), "Albedo Image");
+	debugUtils.SetObjectName(albedoImageView_->Handle(), "Albedo ImageView");
+
+	debugUtils.SetObjectName(sampleCountImage_->Handle(), "Sample Count Image");
+	debugUtils.SetObjectName(sampleCountImageView_->Handle(), "Sample Count ImageView");
+
+	debugUtils.SetObjectName(motionImage_->Handle(), "Motion Image");
+	debugUtils.SetObjectName(motionImageView_->Handle(), "Motion ImageView");
+
+	debugUtils.SetObjectName(sampleBudgetImage_->Handle(), "Sample Budget Image");
+	debugUtils.SetObjectName(sampleBudgetImageView_->Handle(), "Sample Budget ImageView");
+}
+
+RayTracingPipeline::StorageImages Application::GetStorageImages() const
+{
+	return { *accumulationImageView_, *outputImageView_, *normalDepthImageView_, *albedoImageView_, *sampleCountImageView_, *motionImageView_, *sampleBudgetImageView_ };
+}
+
+void Application::SaveOutputImage(const std::string& filename)
+{
+	const auto extent = Extent();
+	const auto pixels = ReadOutputImage();
+
+	if (!stbi_write_png(filename.c_str(), static_cast<int>(extent.width), static_cast<int>(extent.height), 4, pixels.data(), static_cast<int>(extent.width * 4)))
+	{
+		Throw(std::runtime_error("failed to write image '" + filename + "'"));
+	}
+}
+
+std::vector<uint8_t> Application::ReadOutputImage()
+{
+	const auto extent = Extent();
+	const auto rowPitch = extent.width * 4;
+	const auto size = static_cast<size_t>(rowPitch) * extent.height;
+
+	Buffer readbackBuffer(Device(), size, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+	auto readbackBufferMemory = readbackBuffer.AllocateStagingMemory();
+
+	Device().WaitIdle();
+
+	// The last frame left the output image in the transfer source layout.
+	SingleTimeCommands::Submit(CommandPool(), [&](VkCommandBuffer commandBuffer)
+	{
+		VkBufferImageCopy region = {};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageExtent = { extent.width, extent.height, 1 };
+
+		vkCmdCopyImageToBuffer(commandBuffer, outputImage_->Handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer.Handle(), 1, &region);
+
+		VkMemoryBarrier memoryBarrier = {};
+		memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+	});
+
+	const auto data = static_cast<const uint8_t*>(readbackBufferMemory.Map(0, size));
+	std::vector<uint8_t> pixels(data, data + size);
+
+	readbackBufferMemory.Unmap();
+
+	return pixels;
 }
 
 }
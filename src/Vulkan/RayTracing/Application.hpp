@@ -1,7 +1,14 @@
 #pragma once
 
 #include "Vulkan/Application.hpp"
+#include "AdaptiveSampler.hpp"
+#include "Denoiser.hpp"
+#include "RayTracingPipeline.hpp"
 #include "RayTracingProperties.hpp"
+#include "TemporalReprojection.hpp"
+#include "WavefrontPathTracer.hpp"
+#include <string>
+#include <vector>
 
 namespace Vulkan
 {
@@ -10,6 +17,7 @@ namespace Vulkan
 	class DeviceMemory;
 	class Image;
 	class ImageView;
+	class QueryPool;
 }
 
 namespace Vulkan::RayTracing
@@ -20,28 +28,54 @@ namespace Vulkan::RayTracing
 
 		VULKAN_NON_COPIABLE(Application);
 
+		// Reads back the output image of the last frame and writes it as a PNG file (headless rendering).
+		void SaveOutputImage(const std::string& filename);
+
+		// Reads back the output image of the last frame as tightly packed RGBA8 pixels (headless rendering).
+		std::vector<uint8_t> ReadOutputImage();
+
 	protected:
 
 		Application(const WindowConfig& windowConfig, VkPresentModeKHR presentMode, bool enableValidationLayers);
 		~Application();
 
+		virtual RayTracingPipeline::PushConstants GetPushConstants() const = 0;
+		virtual Denoiser::Settings GetDenoiserSettings() const = 0;
+		virtual TemporalReprojection::Settings GetTemporalReprojectionSettings() const = 0;
+		virtual AdaptiveSampler::Settings GetAdaptiveSamplingSettings() const = 0;
+		virtual WavefrontPathTracer::Settings GetWavefrontSettings() const = 0;
+
+		// Mean number of segments per camera path, a few frames behind (shadow rays are not counted).
+		double AveragePathLength() const { return averagePathLength_; }
+
+		// Ray queries are optional, only the wavefront path tracer needs them. Known once the device is set.
+		bool HasRayQuery() const { return hasRayQuery_; }
+
 		void SetPhysicalDevice(VkPhysicalDevice physicalDevice,
 			std::vector<const char*>& requiredExtensions,
 			VkPhysicalDeviceFeatures& deviceFeatures,
 			void* nextDeviceFeatures) override;
 		
 		void OnDeviceSet() override;
-		void CreateAccelerationStructures();
+		void CreateAccelerationStructures(bool compactBottomLevelStructures);
 		void DeleteAccelerationStructures();
 		void CreateSwapChain() override;
 		void DeleteSwapChain() override;
+		void DrawFrame() override;
 		void Render(VkCommandBuffer commandBuffer, size_t currentFrame, uint32_t imageIndex) override;
+		void UpdateTextureDescriptors() override;
 			   
 	private:
 
-		void CreateBottomLevelStructures(VkCommandBuffer commandBuffer);
+		void CreateBottomLevelStructures(VkCommandBuffer commandBuffer, bool allowCompaction);
+		void CompactBottomLevelStructures();
 		void CreateTopLevelStructures(VkCommandBuffer commandBuffer);
+		std::vector<uint32_t> GetHitGroupMaterials() const;
 		void CreateOutputImage();
+		RayTracingPipeline::StorageImages GetStorageImages() const;
+		void CreateRayTracingPipeline();
+		void DeleteRayTracingPipeline();
+		void CreateWavefrontPathTracer();
 
 		std::unique_ptr<class DeviceProcedures> deviceProcedures_;
 		std::unique_ptr<class RayTracingProperties> rayTracingProperties_;
@@ -51,6 +85,7 @@ namespace Vulkan::RayTracing
 		std::unique_ptr<DeviceMemory> bottomBufferMemory_;
 		std::unique_ptr<Buffer> bottomScratchBuffer_;
 		std::unique_ptr<DeviceMemory> bottomScratchBufferMemory_;
+		std::unique_ptr<QueryPool> bottomCompactedSizeQueries_;
 		std::vector<class TopLevelAccelerationStructure> topAs_;
 		std::unique_ptr<Buffer> topBuffer_;
 		std::unique_ptr<DeviceMemory> topBufferMemory_;
@@ -66,9 +101,41 @@ namespace Vulkan::RayTracing
 		std::unique_ptr<Image> outputImage_;
 		std::unique_ptr<DeviceMemory> outputImageMemory_;
 		std::unique_ptr<ImageView> outputImageView_;
+
+		std::unique_ptr<Image> normalDepthImage_;
+		std::unique_ptr<DeviceMemory> normalDepthImageMemory_;
+		std::unique_ptr<ImageView> normalDepthImageView_;
+
+		std::unique_ptr<Image> albedoImage_;
+		std::unique_ptr<DeviceMemory> albedoImageMemory_;
+		std::unique_ptr<ImageView> albedoImageView_;
+
+		std::unique_ptr<Image> sampleCountImage_;
+		std::unique_ptr<DeviceMemory> sampleCountImageMemory_;
+		std::unique_ptr<ImageView> sampleCountImageView_;
+
+		std::unique_ptr<Image> motionImage_;
+		std::unique_ptr<DeviceMemory> motionImageMemory_;
+		std::unique_ptr<ImageView> motionImageView_;
+
+		std::unique_ptr<Image> sampleBudgetImage_;
+		std::unique_ptr<DeviceMemory> sampleBudgetImageMemory_;
+		std::unique_ptr<ImageView> sampleBudgetImageView_;
+
+		std::unique_ptr<Denoiser> denoiser_;
+		std::unique_ptr<TemporalReprojection> temporalReprojection_;
+		std::unique_ptr<AdaptiveSampler> adaptiveSampler_;
 		
-		std::unique_ptr<class RayTracingPipeline> rayTracingPipeline_;
+		std::unique_ptr<class PathCounters> pathCounters_;
+		double averagePathLength_{};
+		bool hasRayQuery_{};
+
+		std::unique_ptr<RayTracingPipeline> rayTracingPipeline_;
 		std::unique_ptr<class ShaderBindingTable> shaderBindingTable_;
+
+		// Created once the wavefront engine is selected and kept with the ray tracing pipeline, its buffers hold a path per
+		// pixel (resized with the swap-chain).
+		std::unique_ptr<WavefrontPathTracer> wavefrontPathTracer_;
 	};
 
 }
@@ -10,8 +10,11 @@ namespace Vulkan::RayTracing {
 BottomLevelAccelerationStructure::BottomLevelAccelerationStructure(
 	const class DeviceProcedures& deviceProcedures,
 	const class RayTracingProperties& rayTracingProperties,
-	const BottomLevelGeometry& geometries) :
-	AccelerationStructure(deviceProcedures, rayTracingProperties),
+	const BottomLevelGeometry& geometries,
+	const bool allowCompaction) :
+	AccelerationStructure(deviceProcedures, rayTracingProperties, 
+		VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR | 
+		(allowCompaction ? VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR : 0)),
 	geometries_(geometries)
 {
 	buildGeometryInfo_.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR;
@@ -23,7 +23,8 @@ namespace Vulkan::RayTracing
 		BottomLevelAccelerationStructure(
 			const class DeviceProcedures& deviceProcedures, 
 			const class RayTracingProperties& rayTracingProperties, 
-			const BottomLevelGeometry& geometries);
+			const BottomLevelGeometry& geometries,
+			bool allowCompaction);
 		BottomLevelAccelerationStructure(BottomLevelAccelerationStructure&& other) noexcept;
 		~BottomLevelAccelerationStructure();
 
@@ -1,7 +1,7 @@
 #include "BottomLevelGeometry.hpp"
 #include "DeviceProcedures.hpp"
 #include "Assets/Scene.hpp"
-#include "Assets/Vertex.hpp"
+#include "Utilities/Glm.hpp"
 #include "Vulkan/Buffer.hpp"
 
 namespace Vulkan::RayTracing {
@@ -10,6 +10,7 @@ void BottomLevelGeometry::AddGeometryTriangles(
 	const Assets::Scene& scene,
 	const uint32_t vertexOffset, const uint32_t vertexCount,
 	const uint32_t indexOffset, const uint32_t indexCount,
+	const VkIndexType indexType,
 	const bool isOpaque)
 {
 	VkAccelerationStructureGeometryKHR geometry = {};
@@ -19,16 +20,16 @@ void BottomLevelGeometry::AddGeometryTriangles(
 	geometry.geometry.triangles.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
 	geometry.geometry.triangles.pNext = nullptr;
 	geometry.geometry.triangles.vertexData.deviceAddress = scene.VertexBuffer().GetDeviceAddress();
-	geometry.geometry.triangles.vertexStride = sizeof(Assets::Vertex);
+	geometry.geometry.triangles.vertexStride = sizeof(glm::vec3);
 	geometry.geometry.triangles.maxVertex = vertexCount;
 	geometry.geometry.triangles.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
 	geometry.geometry.triangles.indexData.deviceAddress = scene.IndexBuffer().GetDeviceAddress();
-	geometry.geometry.triangles.indexType = VK_INDEX_TYPE_UINT32;
+	geometry.geometry.triangles.indexType = indexType;
 	geometry.geometry.triangles.transformData = {};
 	geometry.flags = isOpaque ? VK_GEOMETRY_OPAQUE_BIT_KHR : 0;
 
 	VkAccelerationStructureBuildRangeInfoKHR buildOffsetInfo = {};
-	buildOffsetInfo.firstVertex = vertexOffset / sizeof(Assets::Vertex);
+	buildOffsetInfo.firstVertex = vertexOffset / sizeof(glm::vec3);
 	buildOffsetInfo.primitiveOffset = indexOffset;
 	buildOffsetInfo.primitiveCount = indexCount / 3;
 	buildOffsetInfo.transformOffset = 0;
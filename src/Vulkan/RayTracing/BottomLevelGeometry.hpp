@@ -27,6 +27,7 @@ namespace Vulkan::RayTracing
 			uint32_t vertexCount,
 			uint32_t indexOffset, 
 			uint32_t indexCount,
+			VkIndexType indexType,
 			bool isOpaque);
 
 		void AddGeometryAabb(
@@ -0,0 +1,188 @@
+#include "Denoiser.hpp"
+#include "Utilities/Exception.hpp"
+#include "Vulkan/DescriptorBinding.hpp"
+#include "Vulkan/DescriptorSetManager.hpp"
+#include "Vulkan/DescriptorSets.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/Image.hpp"
+#include "Vulkan/ImageMemoryBarrier.hpp"
+#include "Vulkan/ImageView.hpp"
+#include "Vulkan/PipelineCache.hpp"
+#include "Vulkan/PipelineLayout.hpp"
+#include "Vulkan/ShaderModule.hpp"
+
+namespace Vulkan::RayTracing {
+
+namespace
+{
+	// Must match the local size in Denoiser.glsl.
+	constexpr uint32_t GroupSize = 8;
+}
+
+Denoiser::Denoiser(
+	const class Device& device,
+	const PipelineCache& pipelineCache,
+	const VkExtent2D extent,
+	const RayTracingPipeline::StorageImages& storageImages) :
+	device_(device)
+{
+	const std::vector<DescriptorBinding> descriptorBindings =
+	{
+		// Ray generation shader outputs.
+		{0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{2, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// Ping-pong filter images, and the final output.
+		{3, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{4, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{5, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// Per pixel sample count.
+		{6, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT}
+	};
+
+	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, 1));
+
+	const VkPushConstantRange pushConstantRange = { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants) };
+	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout(), { pushConstantRange }));
+
+	variancePipeline_ = CreatePipeline(pipelineCache, "../assets/shaders/Denoiser.Variance.comp.spv");
+	aTrousPipeline_ = CreatePipeline(pipelineCache, "../assets/shaders/Denoiser.ATrous.comp.spv");
+
+	Resize(extent, storageImages);
+}
+
+Denoiser::~Denoiser()
+{
+	for (auto* pipeline : { &variancePipeline_, &aTrousPipeline_ })
+	{
+		if (*pipeline != nullptr)
+		{
+			vkDestroyPipeline(device_.Handle(), *pipeline, nullptr);
+			*pipeline = nullptr;
+		}
+	}
+
+	pipelineLayout_.reset();
+	descriptorSetManager_.reset();
+	filterImageViews_.clear();
+	filterImages_.clear();
+	filterImageMemories_.clear(); // release memory after bound images have been destroyed
+}
+
+void Denoiser::Resize(const VkExtent2D extent, const RayTracingPipeline::StorageImages& storageImages)
+{
+	const auto format = VK_FORMAT_R32G32B32A32_SFLOAT;
+
+	extent_ = extent;
+	filterImageViews_.clear();
+	filterImages_.clear();
+	filterImageMemories_.clear();
+
+	for (size_t i = 0; i != 2; ++i)
+	{
+		filterImages_.emplace_back(new Image(device_, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT));
+		filterImageMemories_.emplace_back(new DeviceMemory(filterImages_.back()->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+		filterImageViews_.emplace_back(new ImageView(device_, filterImages_.back()->Handle(), format, VK_IMAGE_ASPECT_COLOR_BIT));
+
+		device_.DebugUtils().SetObjectName(filterImages_.back()->Handle(), "Denoiser Filter Image");
+	}
+
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	const auto imageInfo = [](const ImageView& imageView)
+	{
+		VkDescriptorImageInfo info = {};
+		info.imageView = imageView.Handle();
+		info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		return info;
+	};
+
+	const auto accumulationImageInfo = imageInfo(storageImages.Accumulation);
+	const auto normalDepthImageInfo = imageInfo(storageImages.NormalDepth);
+	const auto albedoImageInfo = imageInfo(storageImages.Albedo);
+	const auto filterImage0Info = imageInfo(*filterImageViews_[0]);
+	const auto filterImage1Info = imageInfo(*filterImageViews_[1]);
+	const auto outputImageInfo = imageInfo(storageImages.Output);
+	const auto sampleCountImageInfo = imageInfo(storageImages.SampleCount);
+
+	descriptorSets.UpdateDescriptors(
+	{
+		descriptorSets.Bind(0, 0, accumulationImageInfo),
+		descriptorSets.Bind(0, 1, normalDepthImageInfo),
+		descriptorSets.Bind(0, 2, albedoImageInfo),
+		descriptorSets.Bind(0, 3, filterImage0Info),
+		descriptorSets.Bind(0, 4, filterImage1Info),
+		descriptorSets.Bind(0, 5, outputImageInfo),
+		descriptorSets.Bind(0, 6, sampleCountImageInfo)
+	});
+}
+
+void Denoiser::Render(VkCommandBuffer commandBuffer, const uint32_t iterations) const
+{
+	if (iterations == 0 || iterations > MaxIterations)
+	{
+		Throw(std::out_of_range("invalid number of denoiser iterations"));
+	}
+
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.baseMipLevel = 0;
+	subresourceRange.levelCount = 1;
+	subresourceRange.baseArrayLayer = 0;
+	subresourceRange.layerCount = 1;
+
+	for (const auto& image : filterImages_)
+	{
+		ImageMemoryBarrier::Insert(commandBuffer, image->Handle(), subresourceRange, 0,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+	}
+
+	VkDescriptorSet descriptorSets[] = { descriptorSetManager_->DescriptorSets().Handle(0) };
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout_->Handle(), 0, 1, descriptorSets, 0, nullptr);
+
+	const auto groupCountX = (extent_.width + GroupSize - 1) / GroupSize;
+	const auto groupCountY = (extent_.height + GroupSize - 1) / GroupSize;
+
+	// Variance estimation, into the first filter image.
+	PushConstants pushConstants = {};
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, variancePipeline_);
+	vkCmdPushConstants(commandBuffer, pipelineLayout_->Handle(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+	vkCmdDispatch(commandBuffer, groupCountX, groupCountY, 1);
+
+	// A-trous iterations with growing holes between the taps, the last one writes the output image.
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, aTrousPipeline_);
+
+	for (uint32_t i = 0; i != iterations; ++i)
+	{
+		ImageMemoryBarrier::Insert(commandBuffer, filterImages_[i % 2]->Handle(), subresourceRange,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+
+		pushConstants.StepSize = 1u << i;
+		pushConstants.Source = i % 2;
+		pushConstants.IsLastIteration = i + 1 == iterations;
+
+		vkCmdPushConstants(commandBuffer, pipelineLayout_->Handle(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+		vkCmdDispatch(commandBuffer, groupCountX, groupCountY, 1);
+	}
+}
+
+VkPipeline Denoiser::CreatePipeline(const PipelineCache& pipelineCache, const char* const filename) const
+{
+	const ShaderModule shader(device_, filename);
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = shader.CreateShaderStage(VK_SHADER_STAGE_COMPUTE_BIT);
+	pipelineInfo.layout = pipelineLayout_->Handle();
+
+	VkPipeline pipeline;
+	Check(vkCreateComputePipelines(device_.Handle(), pipelineCache.Handle(), 1, &pipelineInfo, nullptr, &pipeline),
+		"create denoiser pipeline");
+
+	return pipeline;
+}
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "RayTracingPipeline.hpp"
+#include "Vulkan/Vulkan.hpp"
+#include <memory>
+#include <vector>
+
+namespace Vulkan
+{
+	class DescriptorSetManager;
+	class Device;
+	class DeviceMemory;
+	class Image;
+	class ImageView;
+	class PipelineCache;
+	class PipelineLayout;
+}
+
+namespace Vulkan::RayTracing
+{
+	// Edge-avoiding a-trous wavelet filter (Dammertz et al. 2010) with the variance guided luminance weights of SVGF
+	// (Schied et al. 2017), run as compute passes between the trace and the copy to the swap-chain.
+	// The variance comes from the luminance moments accumulated by the ray generation shader, or from the neighbourhood
+	// of pixels that have too few samples. Normals, depths and albedos of the first hits stop the filter at edges.
+	class Denoiser final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(Denoiser)
+
+		static constexpr uint32_t MaxIterations = 5;
+
+		struct Settings final
+		{
+			bool Enabled;
+			uint32_t Iterations;
+		};
+
+		// Per pass data, see Denoiser.glsl.
+		struct PushConstants final
+		{
+			uint32_t StepSize;
+			uint32_t Source;
+			uint32_t IsLastIteration;
+		};
+
+		Denoiser(
+			const Device& device,
+			const PipelineCache& pipelineCache,
+			VkExtent2D extent,
+			const RayTracingPipeline::StorageImages& storageImages);
+		~Denoiser();
+
+		// Re-creates the filter images and rebinds the storage images, e.g. after a resize. The pipelines are kept.
+		// The descriptor set must not be in use by the device.
+		void Resize(VkExtent2D extent, const RayTracingPipeline::StorageImages& storageImages);
+
+		// Filters the accumulated image into the output image, both in the general layout. The ray generation shader writes
+		// must have been made visible to compute shaders.
+		void Render(VkCommandBuffer commandBuffer, uint32_t iterations) const;
+
+	private:
+
+		VkPipeline CreatePipeline(const PipelineCache& pipelineCache, const char* filename) const;
+
+		const class Device& device_;
+		VkExtent2D extent_{};
+
+		// Ping-pong images between the filter iterations, colour and variance.
+		std::vector<std::unique_ptr<Image>> filterImages_;
+		std::vector<std::unique_ptr<DeviceMemory>> filterImageMemories_;
+		std::vector<std::unique_ptr<ImageView>> filterImageViews_;
+
+		std::unique_ptr<DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<PipelineLayout> pipelineLayout_;
+
+		VkPipeline variancePipeline_{};
+		VkPipeline aTrousPipeline_{};
+	};
+
+}
@@ -0,0 +1,88 @@
+#include "PathCounters.hpp"
+#include "Vulkan/Buffer.hpp"
+#include "Vulkan/Device.hpp"
+#include <cstring>
+
+namespace Vulkan::RayTracing {
+
+namespace
+{
+	void InsertBarrier(
+		VkCommandBuffer commandBuffer, const Buffer& buffer, const VkDeviceSize offset, const VkDeviceSize size,
+		const VkAccessFlags srcAccessMask, const VkAccessFlags dstAccessMask,
+		const VkPipelineStageFlags srcStageMask, const VkPipelineStageFlags dstStageMask)
+	{
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = buffer.Handle();
+		barrier.offset = offset;
+		barrier.size = size;
+
+		vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+}
+
+PathCounters::PathCounters(const class Device& device, const size_t sliceCount) :
+	sliceCount_(sliceCount)
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device.PhysicalDevice(), &properties);
+
+	// Dynamic offsets must be multiples of minStorageBufferOffsetAlignment, which is a power of two.
+	const auto alignment = properties.limits.minStorageBufferOffsetAlignment;
+	sliceStride_ = (SliceSize() + alignment - 1) & ~(alignment - 1);
+
+	const auto bufferSize = sliceStride_ * sliceCount;
+
+	buffer_.reset(new class Buffer(device, bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+	memory_.reset(new DeviceMemory(buffer_->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)));
+
+	auto* const data = memory_->Map(0, bufferSize);
+	std::memset(data, 0, bufferSize);
+	mappedData_ = static_cast<const Counter*>(data);
+}
+
+PathCounters::~PathCounters()
+{
+	memory_->Unmap();
+	buffer_.reset();
+	memory_.reset(); // release memory after bound buffer has been destroyed
+}
+
+void PathCounters::Reset(VkCommandBuffer commandBuffer, const size_t slice) const
+{
+	vkCmdFillBuffer(commandBuffer, buffer_->Handle(), SliceOffset(slice), SliceSize(), 0);
+
+	InsertBarrier(commandBuffer, *buffer_, SliceOffset(slice), SliceSize(),
+		VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+}
+
+void PathCounters::Release(VkCommandBuffer commandBuffer, const size_t slice) const
+{
+	InsertBarrier(commandBuffer, *buffer_, SliceOffset(slice), SliceSize(),
+		VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT,
+		VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT);
+}
+
+double PathCounters::AveragePathLength(const size_t slice) const
+{
+	const auto* const counters = reinterpret_cast<const Counter*>(reinterpret_cast<const char*>(mappedData_) + SliceOffset(slice));
+
+	uint64_t paths = 0;
+	uint64_t segments = 0;
+
+	for (size_t i = 0; i != CountersPerSlice; ++i)
+	{
+		paths += counters[i].Paths;
+		segments += counters[i].Segments;
+	}
+
+	return paths != 0 ? static_cast<double>(segments) / static_cast<double>(paths) : 0.0;
+}
+
+}
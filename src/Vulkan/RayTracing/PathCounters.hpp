@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Vulkan/Vulkan.hpp"
+#include <memory>
+
+namespace Vulkan
+{
+	class Buffer;
+	class Device;
+	class DeviceMemory;
+}
+
+namespace Vulkan::RayTracing
+{
+	// Counts the paths and path segments traced by RayTracing.rgen (or WavefrontPathTracer), one slice per frame in flight in a persistently mapped
+	// host coherent buffer. A slice is spread over several counters so that the shader atomics do not all hit the same address.
+	class PathCounters final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(PathCounters)
+
+		PathCounters(const Device& device, size_t sliceCount);
+		~PathCounters();
+
+		const class Buffer& Buffer() const { return *buffer_; }
+
+		size_t SliceCount() const { return sliceCount_; }
+		VkDeviceSize SliceSize() const { return sizeof(Counter) * CountersPerSlice; }
+		uint32_t SliceOffset(size_t slice) const { return static_cast<uint32_t>(slice * sliceStride_); }
+
+		// Clears the slice before the trace, must be called outside a render pass.
+		void Reset(VkCommandBuffer commandBuffer, size_t slice) const;
+
+		// Makes the shader writes to the slice visible to the host once the frame fence has been waited on.
+		void Release(VkCommandBuffer commandBuffer, size_t slice) const;
+
+		// Mean number of segments per path counted in the slice, 0 if no path was traced.
+		double AveragePathLength(size_t slice) const;
+
+	private:
+
+		struct Counter final
+		{
+			uint32_t Paths;
+			uint32_t Segments;
+		};
+
+		static constexpr size_t CountersPerSlice = 64;
+
+		const size_t sliceCount_;
+		VkDeviceSize sliceStride_{};
+		const Counter* mappedData_{};
+
+		std::unique_ptr<class Buffer> buffer_;
+		std::unique_ptr<DeviceMemory> memory_;
+	};
+
+}
@@ -1,5 +1,6 @@
 #include "RayTracingPipeline.hpp"
 #include "DeviceProcedures.hpp"
+#include "PathCounters.hpp"
 #include "TopLevelAccelerationStructure.hpp"
 #include "Assets/Scene.hpp"
 #include "Assets/UniformBuffer.hpp"
@@ -10,24 +11,27 @@
 #include "Vulkan/DescriptorSetManager.hpp"
 #include "Vulkan/DescriptorSets.hpp"
 #include "Vulkan/ImageView.hpp"
+#include "Vulkan/PipelineCache.hpp"
 #include "Vulkan/PipelineLayout.hpp"
 #include "Vulkan/ShaderModule.hpp"
-#include "Vulkan/SwapChain.hpp"
+#include <chrono>
+#include <iostream>
 
 namespace Vulkan::RayTracing {
 
 RayTracingPipeline::RayTracingPipeline(
 	const DeviceProcedures& deviceProcedures,
-	const SwapChain& swapChain,
+	const class Device& device,
+	const PipelineCache& pipelineCache,
 	const TopLevelAccelerationStructure& accelerationStructure,
-	const ImageView& accumulationImageView,
-	const ImageView& outputImageView,
-	const std::vector<Assets::UniformBuffer>& uniformBuffers,
+	const StorageImages& storageImages,
+	const Assets::UniformBuffer& uniformBuffer,
+	const PathCounters& pathCounters,
 	const Assets::Scene& scene) :
-	swapChain_(swapChain)
+	device_(device),
+	uniformBuffer_(uniformBuffer)
 {
 	// Create descriptor pool/sets.
-	const auto& device = swapChain.Device();
 	const std::vector<DescriptorBinding> descriptorBindings =
 	{
 		// Top level acceleration structure.
@@ -38,7 +42,7 @@ RayTracingPipeline::RayTracingPipeline(
 		{2, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
 
 		// Camera information & co
-		{3, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_MISS_BIT_KHR},
+		{3, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_MISS_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
 
 		// Vertex buffer, Index buffer, Material buffer, Offset buffer
 		{4, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
@@ -50,101 +54,126 @@ RayTracingPipeline::RayTracingPipeline(
 		{8, static_cast<uint32_t>(scene.TextureSamplers().size()), VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
 
 		// The Procedural buffer.
-		{9, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_INTERSECTION_BIT_KHR}
+		{9, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_INTERSECTION_BIT_KHR},
+
+		// Emissive triangles, for next event estimation.
+		{10, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+
+		// Path statistics.
+		{11, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+
+		// First hit normal & depth, and albedo, for the denoiser.
+		{12, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{13, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+
+		// Sample count and motion vectors, for the temporal reprojection.
+		{14, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{15, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+
+		// Adaptive sampling budgets.
+		{16, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+
+		// Vertex attribute buffer, Primitive material buffer
+		{17, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
+		{18, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR}
 	};
 
-	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, uniformBuffers.size()));
+	// A single descriptor set, the uniform buffer and path counter slices of the frame are selected with dynamic offsets when binding.
+	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, 1));
 
 	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
 
-	for (uint32_t i = 0; i != swapChain.Images().size(); ++i)
+	// Top level acceleration structure.
+	const auto accelerationStructureHandle = accelerationStructure.Handle();
+	VkWriteDescriptorSetAccelerationStructureKHR structureInfo = {};
+	structureInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
+	structureInfo.pNext = nullptr;
+	structureInfo.accelerationStructureCount = 1;
+	structureInfo.pAccelerationStructures = &accelerationStructureHandle;
+
+	// Uniform buffer
+	VkDescriptorBufferInfo uniformBufferInfo = {};
+	uniformBufferInfo.buffer = uniformBuffer.Buffer().Handle();
+	uniformBufferInfo.range = uniformBuffer.SliceSize();
+
+	// Vertex buffer
+	VkDescriptorBufferInfo vertexBufferInfo = {};
+	vertexBufferInfo.buffer = scene.VertexBuffer().Handle();
+	vertexBufferInfo.range = VK_WHOLE_SIZE;
+
+	// Vertex attribute buffer
+	VkDescriptorBufferInfo vertexAttributeBufferInfo = {};
+	vertexAttributeBufferInfo.buffer = scene.VertexAttributeBuffer().Handle();
+	vertexAttributeBufferInfo.range = VK_WHOLE_SIZE;
+
+	// Index buffer
+	VkDescriptorBufferInfo indexBufferInfo = {};
+	indexBufferInfo.buffer = scene.IndexBuffer().Handle();
+	indexBufferInfo.range = VK_WHOLE_SIZE;
+
+	// Material buffer
+	VkDescriptorBufferInfo materialBufferInfo = {};
+	materialBufferInfo.buffer = scene.MaterialBuffer().Handle();
+	materialBufferInfo.range = VK_WHOLE_SIZE;
+
+	// Primitive material buffer
+	VkDescriptorBufferInfo primitiveMaterialBufferInfo = {};
+	primitiveMaterialBufferInfo.buffer = scene.PrimitiveMaterialBuffer().Handle();
+	primitiveMaterialBufferInfo.range = VK_WHOLE_SIZE;
+
+	// Offsets buffer
+	VkDescriptorBufferInfo offsetsBufferInfo = {};
+	offsetsBufferInfo.buffer = scene.OffsetsBuffer().Handle();
+	offsetsBufferInfo.range = VK_WHOLE_SIZE;
+
+	// Light buffer
+	VkDescriptorBufferInfo lightBufferInfo = {};
+	lightBufferInfo.buffer = scene.LightBuffer().Handle();
+	lightBufferInfo.range = VK_WHOLE_SIZE;
+
+	// Path counters
+	VkDescriptorBufferInfo pathCountersInfo = {};
+	pathCountersInfo.buffer = pathCounters.Buffer().Handle();
+	pathCountersInfo.range = pathCounters.SliceSize();
+
+	std::vector<VkWriteDescriptorSet> descriptorWrites =
 	{
-		// Top level acceleration structure.
-		const auto accelerationStructureHandle = accelerationStructure.Handle();
-		VkWriteDescriptorSetAccelerationStructureKHR structureInfo = {};
-		structureInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
-		structureInfo.pNext = nullptr;
-		structureInfo.accelerationStructureCount = 1;
-		structureInfo.pAccelerationStructures = &accelerationStructureHandle;
-
-		// Accumulation image
-		VkDescriptorImageInfo accumulationImageInfo = {};
-		accumulationImageInfo.imageView = accumulationImageView.Handle();
-		accumulationImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
-		// Output image
-		VkDescriptorImageInfo outputImageInfo = {};
-		outputImageInfo.imageView = outputImageView.Handle();
-		outputImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
-		// Uniform buffer
-		VkDescriptorBufferInfo uniformBufferInfo = {};
-		uniformBufferInfo.buffer = uniformBuffers[i].Buffer().Handle();
-		uniformBufferInfo.range = VK_WHOLE_SIZE;
-
-		// Vertex buffer
-		VkDescriptorBufferInfo vertexBufferInfo = {};
-		vertexBufferInfo.buffer = scene.VertexBuffer().Handle();
-		vertexBufferInfo.range = VK_WHOLE_SIZE;
-
-		// Index buffer
-		VkDescriptorBufferInfo indexBufferInfo = {};
-		indexBufferInfo.buffer = scene.IndexBuffer().Handle();
-		indexBufferInfo.range = VK_WHOLE_SIZE;
-
-		// Material buffer
-		VkDescriptorBufferInfo materialBufferInfo = {};
-		materialBufferInfo.buffer = scene.MaterialBuffer().Handle();
-		materialBufferInfo.range = VK_WHOLE_SIZE;
-
-		// Offsets buffer
-		VkDescriptorBufferInfo offsetsBufferInfo = {};
-		offsetsBufferInfo.buffer = scene.OffsetsBuffer().Handle();
-		offsetsBufferInfo.range = VK_WHOLE_SIZE;
-
-		// Image and texture samplers.
-		std::vector<VkDescriptorImageInfo> imageInfos(scene.TextureSamplers().size());
-
-		for (size_t t = 0; t != imageInfos.size(); ++t)
-		{
-			auto& imageInfo = imageInfos[t];
-			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			imageInfo.imageView = scene.TextureImageViews()[t];
-			imageInfo.sampler = scene.TextureSamplers()[t];
-		}
-
-		std::vector<VkWriteDescriptorSet> descriptorWrites =
-		{
-			descriptorSets.Bind(i, 0, structureInfo),
-			descriptorSets.Bind(i, 1, accumulationImageInfo),
-			descriptorSets.Bind(i, 2, outputImageInfo),
-			descriptorSets.Bind(i, 3, uniformBufferInfo),
-			descriptorSets.Bind(i, 4, vertexBufferInfo),
-			descriptorSets.Bind(i, 5, indexBufferInfo),
-			descriptorSets.Bind(i, 6, materialBufferInfo),
-			descriptorSets.Bind(i, 7, offsetsBufferInfo),
-			descriptorSets.Bind(i, 8, *imageInfos.data(), static_cast<uint32_t>(imageInfos.size()))
-		};
-
-		// Procedural buffer (optional)
-		VkDescriptorBufferInfo proceduralBufferInfo = {};
-		
-		if (scene.HasProcedurals())
-		{
-			proceduralBufferInfo.buffer = scene.ProceduralBuffer().Handle();
-			proceduralBufferInfo.range = VK_WHOLE_SIZE;
-
-			descriptorWrites.push_back(descriptorSets.Bind(i, 9, proceduralBufferInfo));
-		}
-
-		descriptorSets.UpdateDescriptors(descriptorWrites);
+		descriptorSets.Bind(0, 0, structureInfo),
+		descriptorSets.Bind(0, 3, uniformBufferInfo),
+		descriptorSets.Bind(0, 4, vertexBufferInfo),
+		descriptorSets.Bind(0, 5, indexBufferInfo),
+		descriptorSets.Bind(0, 6, materialBufferInfo),
+		descriptorSets.Bind(0, 7, offsetsBufferInfo),
+		descriptorSets.Bind(0, 10, lightBufferInfo),
+		descriptorSets.Bind(0, 11, pathCountersInfo),
+		descriptorSets.Bind(0, 17, vertexAttributeBufferInfo),
+		descriptorSets.Bind(0, 18, primitiveMaterialBufferInfo)
+	};
+
+	// Procedural buffer (optional)
+	VkDescriptorBufferInfo proceduralBufferInfo = {};
+	
+	if (scene.HasProcedurals())
+	{
+		proceduralBufferInfo.buffer = scene.ProceduralBuffer().Handle();
+		proceduralBufferInfo.range = VK_WHOLE_SIZE;
+
+		descriptorWrites.push_back(descriptorSets.Bind(0, 9, proceduralBufferInfo));
 	}
 
-	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout()));
+	descriptorSets.UpdateDescriptors(descriptorWrites);
+
+	UpdateOutputImages(storageImages);
+	UpdateTextures(scene);
+
+	const VkPushConstantRange pushConstantRange = { VK_SHADER_STAGE_RAYGEN_BIT_KHR, 0, sizeof(PushConstants) };
+
+	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout(), { pushConstantRange }));
 
 	// Load shaders.
 	const ShaderModule rayGenShader(device, "../assets/shaders/RayTracing.rgen.spv");
 	const ShaderModule missShader(device, "../assets/shaders/RayTracing.rmiss.spv");
+	const ShaderModule shadowMissShader(device, "../assets/shaders/RayTracing.Shadow.rmiss.spv");
 	const ShaderModule closestHitShader(device, "../assets/shaders/RayTracing.rchit.spv");
 	const ShaderModule proceduralClosestHitShader(device, "../assets/shaders/RayTracing.Procedural.rchit.spv");
 	const ShaderModule proceduralIntersectionShader(device, "../assets/shaders/RayTracing.Procedural.rint.spv");
@@ -155,9 +184,36 @@ RayTracingPipeline::RayTracingPipeline(
 		missShader.CreateShaderStage(VK_SHADER_STAGE_MISS_BIT_KHR),
 		closestHitShader.CreateShaderStage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR),
 		proceduralClosestHitShader.CreateShaderStage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR),
-		proceduralIntersectionShader.CreateShaderStage(VK_SHADER_STAGE_INTERSECTION_BIT_KHR)
+		proceduralIntersectionShader.CreateShaderStage(VK_SHADER_STAGE_INTERSECTION_BIT_KHR),
+		shadowMissShader.CreateShaderStage(VK_SHADER_STAGE_MISS_BIT_KHR)
+	};
+
+	// Triangle closest hit shaders specialized for each material model but the isotropic one.
+	constexpr std::array<Assets::Material::Enum, 4> specializedModels =
+	{
+		Assets::Material::Enum::Lambertian,
+		Assets::Material::Enum::Metallic,
+		Assets::Material::Enum::Dielectric,
+		Assets::Material::Enum::DiffuseLight
 	};
 
+	const VkSpecializationMapEntry specializationEntry = { 0, 0, sizeof(uint32_t) };
+	std::array<VkSpecializationInfo, specializedModels.size()> specializationInfos{};
+	std::array<uint32_t, specializedModels.size()> specializedStages{};
+
+	for (size_t i = 0; i != specializedModels.size(); ++i)
+	{
+		auto& specializationInfo = specializationInfos[i];
+		specializationInfo.mapEntryCount = 1;
+		specializationInfo.pMapEntries = &specializationEntry;
+		specializationInfo.dataSize = sizeof(Assets::Material::Enum);
+		specializationInfo.pData = &specializedModels[i];
+
+		specializedStages[i] = static_cast<uint32_t>(shaderStages.size());
+		shaderStages.push_back(closestHitShader.CreateShaderStage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR));
+		shaderStages.back().pSpecializationInfo = &specializationInfo;
+	}
+
 	// Shader groups
 	VkRayTracingShaderGroupCreateInfoKHR rayGenGroupInfo = {};
 	rayGenGroupInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
@@ -179,6 +235,16 @@ RayTracingPipeline::RayTracingPipeline(
 	missGroupInfo.intersectionShader = VK_SHADER_UNUSED_KHR;
 	missIndex_ = 1;
 
+	VkRayTracingShaderGroupCreateInfoKHR shadowMissGroupInfo = {};
+	shadowMissGroupInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
+	shadowMissGroupInfo.pNext = nullptr;
+	shadowMissGroupInfo.type = VK_RAY_TRACING_SHADER_GROUP_TYPE_GENERAL_KHR;
+	shadowMissGroupInfo.generalShader = 5;
+	shadowMissGroupInfo.closestHitShader = VK_SHADER_UNUSED_KHR;
+	shadowMissGroupInfo.anyHitShader = VK_SHADER_UNUSED_KHR;
+	shadowMissGroupInfo.intersectionShader = VK_SHADER_UNUSED_KHR;
+	shadowMissIndex_ = 2;
+
 	VkRayTracingShaderGroupCreateInfoKHR triangleHitGroupInfo = {};
 	triangleHitGroupInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
 	triangleHitGroupInfo.pNext = nullptr;
@@ -187,7 +253,7 @@ RayTracingPipeline::RayTracingPipeline(
 	triangleHitGroupInfo.closestHitShader = 2;
 	triangleHitGroupInfo.anyHitShader = VK_SHADER_UNUSED_KHR;
 	triangleHitGroupInfo.intersectionShader = VK_SHADER_UNUSED_KHR;
-	triangleHitGroupIndex_ = 2;
+	triangleHitGroupIndex_ = 3;
 
 	VkRayTracingShaderGroupCreateInfoKHR proceduralHitGroupInfo = {};
 	proceduralHitGroupInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
@@ -197,16 +263,31 @@ RayTracingPipeline::RayTracingPipeline(
 	proceduralHitGroupInfo.closestHitShader = 3;
 	proceduralHitGroupInfo.anyHitShader = VK_SHADER_UNUSED_KHR;
 	proceduralHitGroupInfo.intersectionShader = 4;
-	proceduralHitGroupIndex_ = 3;
+	proceduralHitGroupIndex_ = 4;
 
 	std::vector<VkRayTracingShaderGroupCreateInfoKHR> groups =
 	{
 		rayGenGroupInfo, 
 		missGroupInfo, 
+		shadowMissGroupInfo,
 		triangleHitGroupInfo, 
 		proceduralHitGroupInfo,
 	};
 
+	// Material hit groups, after the generic ones.
+	materialHitGroupIndices_.fill(triangleHitGroupIndex_);
+
+	for (size_t i = 0; i != specializedModels.size(); ++i)
+	{
+		VkRayTracingShaderGroupCreateInfoKHR materialHitGroupInfo = triangleHitGroupInfo;
+		materialHitGroupInfo.closestHitShader = specializedStages[i];
+
+		materialHitGroupIndices_[static_cast<size_t>(specializedModels[i])] = static_cast<uint32_t>(groups.size());
+		groups.push_back(materialHitGroupInfo);
+	}
+
+	groupCount_ = static_cast<uint32_t>(groups.size());
+
 	// Create graphic pipeline
 	VkRayTracingPipelineCreateInfoKHR pipelineInfo = {};
 	pipelineInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR;
@@ -221,15 +302,21 @@ RayTracingPipeline::RayTracingPipeline(
 	pipelineInfo.basePipelineHandle = nullptr;
 	pipelineInfo.basePipelineIndex = 0;
 
-	Check(deviceProcedures.vkCreateRayTracingPipelinesKHR(device.Handle(), nullptr, nullptr, 1, &pipelineInfo, nullptr, &pipeline_), 
+	// Shaders are compiled here, time it to see what the pipeline cache saves.
+	const auto timer = std::chrono::high_resolution_clock::now();
+
+	Check(deviceProcedures.vkCreateRayTracingPipelinesKHR(device.Handle(), nullptr, pipelineCache.Handle(), 1, &pipelineInfo, nullptr, &pipeline_), 
 		"create ray tracing pipeline");
+
+	const auto elapsed = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - timer).count();
+	std::cout << "- created ray tracing pipeline in " << elapsed << "ms (" << (pipelineCache.IsWarm() ? "warm" : "cold") << " pipeline cache)" << std::endl;
 }
 
 RayTracingPipeline::~RayTracingPipeline()
 {
 	if (pipeline_ != nullptr)
 	{
-		vkDestroyPipeline(swapChain_.Device().Handle(), pipeline_, nullptr);
+		vkDestroyPipeline(device_.Handle(), pipeline_, nullptr);
 		pipeline_ = nullptr;
 	}
 
@@ -237,9 +324,76 @@ RayTracingPipeline::~RayTracingPipeline()
 	descriptorSetManager_.reset();
 }
 
-VkDescriptorSet RayTracingPipeline::DescriptorSet(const size_t index) const
+VkDescriptorSet RayTracingPipeline::DescriptorSet() const
+{
+	return descriptorSetManager_->DescriptorSets().Handle(0);
+}
+
+void RayTracingPipeline::UpdateOutputImages(const StorageImages& storageImages)
+{
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	// Accumulation image
+	VkDescriptorImageInfo accumulationImageInfo = {};
+	accumulationImageInfo.imageView = storageImages.Accumulation.Handle();
+	accumulationImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	// Output image
+	VkDescriptorImageInfo outputImageInfo = {};
+	outputImageInfo.imageView = storageImages.Output.Handle();
+	outputImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	// Denoiser guides
+	VkDescriptorImageInfo normalDepthImageInfo = {};
+	normalDepthImageInfo.imageView = storageImages.NormalDepth.Handle();
+	normalDepthImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	VkDescriptorImageInfo albedoImageInfo = {};
+	albedoImageInfo.imageView = storageImages.Albedo.Handle();
+	albedoImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	// Temporal reprojection
+	VkDescriptorImageInfo sampleCountImageInfo = {};
+	sampleCountImageInfo.imageView = storageImages.SampleCount.Handle();
+	sampleCountImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	VkDescriptorImageInfo motionImageInfo = {};
+	motionImageInfo.imageView = storageImages.Motion.Handle();
+	motionImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	// Adaptive sampling
+	VkDescriptorImageInfo sampleBudgetImageInfo = {};
+	sampleBudgetImageInfo.imageView = storageImages.SampleBudget.Handle();
+	sampleBudgetImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	descriptorSets.UpdateDescriptors(
+	{
+		descriptorSets.Bind(0, 1, accumulationImageInfo),
+		descriptorSets.Bind(0, 2, outputImageInfo),
+		descriptorSets.Bind(0, 12, normalDepthImageInfo),
+		descriptorSets.Bind(0, 13, albedoImageInfo),
+		descriptorSets.Bind(0, 14, sampleCountImageInfo),
+		descriptorSets.Bind(0, 15, motionImageInfo),
+		descriptorSets.Bind(0, 16, sampleBudgetImageInfo)
+	});
+}
+
+void RayTracingPipeline::UpdateTextures(const Assets::Scene& scene)
 {
-	return descriptorSetManager_->DescriptorSets().Handle(index);
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	// Image and texture samplers.
+	std::vector<VkDescriptorImageInfo> imageInfos(scene.TextureSamplers().size());
+
+	for (size_t t = 0; t != imageInfos.size(); ++t)
+	{
+		auto& imageInfo = imageInfos[t];
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = scene.TextureImageViews()[t];
+		imageInfo.sampler = scene.TextureSamplers()[t];
+	}
+
+	descriptorSets.UpdateDescriptors({ descriptorSets.Bind(0, 8, *imageInfos.data(), static_cast<uint32_t>(imageInfos.size())) });
 }
 
 }
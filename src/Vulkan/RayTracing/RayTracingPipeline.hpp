@@ -1,6 +1,8 @@
 #pragma once
 
+#include "Assets/Material.hpp"
 #include "Vulkan/Vulkan.hpp"
+#include <array>
 #include <memory>
 #include <vector>
 
@@ -13,14 +15,16 @@ namespace Assets
 namespace Vulkan
 {
 	class DescriptorSetManager;
+	class Device;
 	class ImageView;
+	class PipelineCache;
 	class PipelineLayout;
-	class SwapChain;
 }
 
 namespace Vulkan::RayTracing
 {
 	class DeviceProcedures;
+	class PathCounters;
 	class TopLevelAccelerationStructure;
 
 	class RayTracingPipeline final
@@ -29,27 +33,66 @@ namespace Vulkan::RayTracing
 
 		VULKAN_NON_COPIABLE(RayTracingPipeline)
 
+		// Per dispatch data that changes every frame, see RayTracing.rgen.
+		struct PushConstants final
+		{
+			uint32_t TotalNumberOfSamples;
+			uint32_t NumberOfSamples;
+			uint32_t RandomSeed;
+			uint32_t SampleOffset; // samples drawn before the current (reprojected) history
+		};
+
+		// Storage images written by the ray generation shader, re-created with the swap-chain.
+		struct StorageImages final
+		{
+			const ImageView& Accumulation;
+			const ImageView& Output;
+			const ImageView& NormalDepth; // denoiser guides
+			const ImageView& Albedo;
+			const ImageView& SampleCount; // per pixel, they differ once a history has been reprojected
+			const ImageView& Motion;
+			const ImageView& SampleBudget; // per tile, see AdaptiveSampler
+		};
+
 		RayTracingPipeline(
 			const DeviceProcedures& deviceProcedures,
-			const SwapChain& swapChain,
+			const Device& device,
+			const PipelineCache& pipelineCache,
 			const TopLevelAccelerationStructure& accelerationStructure,
-			const ImageView& accumulationImageView,
-			const ImageView& outputImageView,
-			const std::vector<Assets::UniformBuffer>& uniformBuffers,
+			const StorageImages& storageImages,
+			const Assets::UniformBuffer& uniformBuffer,
+			const PathCounters& pathCounters,
 			const Assets::Scene& scene);
 		~RayTracingPipeline();
 
 		uint32_t RayGenShaderIndex() const { return rayGenIndex_; }
 		uint32_t MissShaderIndex() const { return missIndex_; }
+		uint32_t ShadowMissShaderIndex() const { return shadowMissIndex_; }
 		uint32_t TriangleHitGroupIndex() const { return triangleHitGroupIndex_; }
 		uint32_t ProceduralHitGroupIndex() const { return proceduralHitGroupIndex_; }
 
-		VkDescriptorSet DescriptorSet(size_t index) const;
+		// Triangle hit group specialized for the material model, whose shader binding table records hold the material
+		// (see RayTracing.rchit). The generic triangle hit group for models without one.
+		uint32_t MaterialHitGroupIndex(Assets::Material::Enum materialModel) const { return materialHitGroupIndices_[static_cast<size_t>(materialModel)]; }
+
+		uint32_t GroupCount() const { return groupCount_; }
+
+		VkDescriptorSet DescriptorSet() const;
 		const class PipelineLayout& PipelineLayout() const { return *pipelineLayout_; }
+		const Assets::UniformBuffer& UniformBuffer() const { return uniformBuffer_; }
+
+		// Rebinds the storage images (bindings 1, 2 and 12 to 16) once they have been re-created, e.g. after a resize.
+		// The descriptor set must not be in use by the device.
+		void UpdateOutputImages(const StorageImages& storageImages);
+
+		// Rebinds the scene textures (binding 8), e.g. once streamed textures have replaced their placeholder.
+		// The descriptor set must not be in use by the device.
+		void UpdateTextures(const Assets::Scene& scene);
 
 	private:
 
-		const SwapChain& swapChain_;
+		const class Device& device_;
+		const Assets::UniformBuffer& uniformBuffer_;
 
 		VULKAN_HANDLE(VkPipeline, pipeline_)
 
@@ -58,8 +101,11 @@ namespace Vulkan::RayTracing
 
 		uint32_t rayGenIndex_;
 		uint32_t missIndex_;
+		uint32_t shadowMissIndex_;
 		uint32_t triangleHitGroupIndex_;
 		uint32_t proceduralHitGroupIndex_;
+		std::array<uint32_t, 5> materialHitGroupIndices_{};
+		uint32_t groupCount_;
 	};
 
 }
@@ -90,9 +90,9 @@ ShaderBindingTable::ShaderBindingTable(
 	buffer_.reset(new class Buffer(device, sbtSize, VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_BINDING_TABLE_BIT_KHR));
 	bufferMemory_.reset(new DeviceMemory(buffer_->AllocateMemory(VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)));
 
-	// Generate the table.
+	// Generate the table. Several entries can refer to the same group, with different inline data.
 	const uint32_t handleSize = rayTracingProperties.ShaderGroupHandleSize();
-	const size_t groupCount = rayGenPrograms.size() + missPrograms.size() + hitGroups.size();
+	const size_t groupCount = rayTracingPipeline.GroupCount();
 	std::vector<uint8_t> shaderHandleStorage(groupCount * handleSize);
 
 	Check(deviceProcedures.vkGetRayTracingShaderGroupHandlesKHR(
@@ -26,7 +26,7 @@ namespace Vulkan::RayTracing
 		struct Entry
 		{
 			uint32_t GroupIndex;
-			std::vector<unsigned char> InlineData;
+			std::vector<unsigned char> InlineData; // read through shaderRecordEXT, e.g. the material of a material hit group
 		};
 
 		VULKAN_NON_COPIABLE(ShaderBindingTable)
@@ -0,0 +1,185 @@
+#include "TemporalReprojection.hpp"
+#include "Utilities/Exception.hpp"
+#include "Vulkan/DescriptorBinding.hpp"
+#include "Vulkan/DescriptorSetManager.hpp"
+#include "Vulkan/DescriptorSets.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/Image.hpp"
+#include "Vulkan/ImageMemoryBarrier.hpp"
+#include "Vulkan/ImageView.hpp"
+#include "Vulkan/PipelineCache.hpp"
+#include "Vulkan/PipelineLayout.hpp"
+#include "Vulkan/ShaderModule.hpp"
+#include <array>
+
+namespace Vulkan::RayTracing {
+
+namespace
+{
+	// Must match the local size in TemporalReprojection.comp.
+	constexpr uint32_t GroupSize = 8;
+
+	constexpr std::array<VkFormat, 3> HistoryFormats =
+	{
+		VK_FORMAT_R32G32B32A32_SFLOAT, // accumulation
+		VK_FORMAT_R32_SFLOAT, // sample count
+		VK_FORMAT_R16G16B16A16_SFLOAT // normal & depth
+	};
+}
+
+TemporalReprojection::TemporalReprojection(
+	const class Device& device,
+	const PipelineCache& pipelineCache,
+	const VkExtent2D extent,
+	const RayTracingPipeline::StorageImages& storageImages) :
+	device_(device)
+{
+	const std::vector<DescriptorBinding> descriptorBindings =
+	{
+		// Ray generation shader outputs, the accumulation and sample count images are updated in place.
+		{0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{2, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{3, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// History of the previous frame.
+		{4, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{5, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{6, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// Output image.
+		{7, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT}
+	};
+
+	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, 1));
+
+	const VkPushConstantRange pushConstantRange = { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants) };
+	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout(), { pushConstantRange }));
+
+	const ShaderModule shader(device, "../assets/shaders/TemporalReprojection.comp.spv");
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = shader.CreateShaderStage(VK_SHADER_STAGE_COMPUTE_BIT);
+	pipelineInfo.layout = pipelineLayout_->Handle();
+
+	Check(vkCreateComputePipelines(device.Handle(), pipelineCache.Handle(), 1, &pipelineInfo, nullptr, &pipeline_),
+		"create temporal reprojection pipeline");
+
+	Resize(extent, storageImages);
+}
+
+TemporalReprojection::~TemporalReprojection()
+{
+	if (pipeline_ != nullptr)
+	{
+		vkDestroyPipeline(device_.Handle(), pipeline_, nullptr);
+		pipeline_ = nullptr;
+	}
+
+	pipelineLayout_.reset();
+	descriptorSetManager_.reset();
+	historyImageViews_.clear();
+	historyImages_.clear();
+	historyImageMemories_.clear(); // release memory after bound images have been destroyed
+}
+
+void TemporalReprojection::Resize(const VkExtent2D extent, const RayTracingPipeline::StorageImages& storageImages)
+{
+	extent_ = extent;
+	historyImageViews_.clear();
+	historyImages_.clear();
+	historyImageMemories_.clear();
+
+	for (const auto format : HistoryFormats)
+	{
+		historyImages_.emplace_back(new Image(device_, extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT));
+		historyImageMemories_.emplace_back(new DeviceMemory(historyImages_.back()->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+		historyImageViews_.emplace_back(new ImageView(device_, historyImages_.back()->Handle(), format, VK_IMAGE_ASPECT_COLOR_BIT));
+
+		device_.DebugUtils().SetObjectName(historyImages_.back()->Handle(), "History Image");
+	}
+
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	const auto imageInfo = [](const ImageView& imageView)
+	{
+		VkDescriptorImageInfo info = {};
+		info.imageView = imageView.Handle();
+		info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		return info;
+	};
+
+	const auto accumulationImageInfo = imageInfo(storageImages.Accumulation);
+	const auto sampleCountImageInfo = imageInfo(storageImages.SampleCount);
+	const auto normalDepthImageInfo = imageInfo(storageImages.NormalDepth);
+	const auto motionImageInfo = imageInfo(storageImages.Motion);
+	const auto historyAccumulationImageInfo = imageInfo(*historyImageViews_[0]);
+	const auto historySampleCountImageInfo = imageInfo(*historyImageViews_[1]);
+	const auto historyNormalDepthImageInfo = imageInfo(*historyImageViews_[2]);
+	const auto outputImageInfo = imageInfo(storageImages.Output);
+
+	descriptorSets.UpdateDescriptors(
+	{
+		descriptorSets.Bind(0, 0, accumulationImageInfo),
+		descriptorSets.Bind(0, 1, sampleCountImageInfo),
+		descriptorSets.Bind(0, 2, normalDepthImageInfo),
+		descriptorSets.Bind(0, 3, motionImageInfo),
+		descriptorSets.Bind(0, 4, historyAccumulationImageInfo),
+		descriptorSets.Bind(0, 5, historySampleCountImageInfo),
+		descriptorSets.Bind(0, 6, historyNormalDepthImageInfo),
+		descriptorSets.Bind(0, 7, outputImageInfo)
+	});
+}
+
+void TemporalReprojection::SaveHistory(VkCommandBuffer commandBuffer, const Image& accumulationImage, const Image& sampleCountImage, const Image& normalDepthImage) const
+{
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.baseMipLevel = 0;
+	subresourceRange.levelCount = 1;
+	subresourceRange.baseArrayLayer = 0;
+	subresourceRange.layerCount = 1;
+
+	VkImageCopy copyRegion = {};
+	copyRegion.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	copyRegion.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	copyRegion.extent = { extent_.width, extent_.height, 1 };
+
+	const Image* const sources[] = { &accumulationImage, &sampleCountImage, &normalDepthImage };
+
+	for (size_t i = 0; i != historyImages_.size(); ++i)
+	{
+		const auto source = sources[i]->Handle();
+		const auto history = historyImages_[i]->Handle();
+
+		ImageMemoryBarrier::Insert(commandBuffer, source, subresourceRange,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+
+		ImageMemoryBarrier::Insert(commandBuffer, history, subresourceRange, 0,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+		vkCmdCopyImage(commandBuffer,
+			source, VK_IMAGE_LAYOUT_GENERAL,
+			history, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &copyRegion);
+
+		ImageMemoryBarrier::Insert(commandBuffer, history, subresourceRange, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+	}
+}
+
+void TemporalReprojection::Render(VkCommandBuffer commandBuffer, const uint32_t maxHistoryLength) const
+{
+	VkDescriptorSet descriptorSets[] = { descriptorSetManager_->DescriptorSets().Handle(0) };
+
+	PushConstants pushConstants = {};
+	pushConstants.MaxHistoryLength = maxHistoryLength;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout_->Handle(), 0, 1, descriptorSets, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, pipelineLayout_->Handle(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+	vkCmdDispatch(commandBuffer, (extent_.width + GroupSize - 1) / GroupSize, (extent_.height + GroupSize - 1) / GroupSize, 1);
+}
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "RayTracingPipeline.hpp"
+#include "Vulkan/Vulkan.hpp"
+#include <memory>
+#include <vector>
+
+namespace Vulkan
+{
+	class DescriptorSetManager;
+	class Device;
+	class DeviceMemory;
+	class Image;
+	class ImageView;
+	class PipelineCache;
+	class PipelineLayout;
+}
+
+namespace Vulkan::RayTracing
+{
+	// Carries the accumulated samples over when the camera moves, instead of restarting from the samples of a single frame.
+	// The history is saved before the trace, which then restarts the accumulation. A compute pass follows the motion
+	// vectors written by the ray generation shader back into the history, rejects the pixels that were not visible in the
+	// previous frame (depth and normal tests), and adds what remains to the new samples.
+	class TemporalReprojection final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(TemporalReprojection)
+
+		struct Settings final
+		{
+			bool Reproject; // the camera moved since the previous frame
+			uint32_t MaxHistoryLength;
+		};
+
+		// Per pass data, see TemporalReprojection.comp.
+		struct PushConstants final
+		{
+			uint32_t MaxHistoryLength;
+		};
+
+		TemporalReprojection(
+			const Device& device,
+			const PipelineCache& pipelineCache,
+			VkExtent2D extent,
+			const RayTracingPipeline::StorageImages& storageImages);
+		~TemporalReprojection();
+
+		// Re-creates the history images and rebinds the storage images, e.g. after a resize. The pipeline is kept.
+		// The descriptor set must not be in use by the device.
+		void Resize(VkExtent2D extent, const RayTracingPipeline::StorageImages& storageImages);
+
+		// Copies the accumulation, sample count and normal & depth images of the previous frame, in the general layout.
+		void SaveHistory(VkCommandBuffer commandBuffer, const Image& accumulationImage, const Image& sampleCountImage, const Image& normalDepthImage) const;
+
+		// Adds the reprojected history to the samples of this frame, and rewrites the output image. The ray generation
+		// shader writes must have been made visible to compute shaders.
+		void Render(VkCommandBuffer commandBuffer, uint32_t maxHistoryLength) const;
+
+	private:
+
+		const class Device& device_;
+		VkExtent2D extent_{};
+
+		// Accumulation, sample count, normal & depth.
+		std::vector<std::unique_ptr<Image>> historyImages_;
+		std::vector<std::unique_ptr<DeviceMemory>> historyImageMemories_;
+		std::vector<std::unique_ptr<ImageView>> historyImageViews_;
+
+		std::unique_ptr<DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<PipelineLayout> pipelineLayout_;
+
+		VkPipeline pipeline_{};
+	};
+
+}
@@ -13,7 +13,7 @@ TopLevelAccelerationStructure::TopLevelAccelerationStructure(
 	const class RayTracingProperties& rayTracingProperties,
 	const VkDeviceAddress instanceAddress,
 	const uint32_t instancesCount) :
-	AccelerationStructure(deviceProcedures, rayTracingProperties),
+	AccelerationStructure(deviceProcedures, rayTracingProperties, VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR),
 	instancesCount_(instancesCount)
 {
 	// Create VkAccelerationStructureGeometryInstancesDataKHR. This wraps a device pointer to the above uploaded instances.
@@ -92,10 +92,11 @@ VkAccelerationStructureInstanceKHR TopLevelAccelerationStructure::CreateInstance
 	instance.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR; // Disable culling - more fine control could be provided by the application
 	instance.accelerationStructureReference = address;
 
-	// The instance.transform value only contains 12 values, corresponding to a 4x3 matrix,
+	// The instance.transform value only contains 12 values, corresponding to a 3x4 row-major matrix,
 	// hence saving the last row that is anyway always (0,0,0,1).
-	// Since the matrix is row-major, we simply copy the first 12 values of the original 4x4 matrix
-	std::memcpy(&instance.transform, &transform, sizeof(instance.transform));
+	// GLM matrices are column-major, so transpose first and copy the first 12 values of the 4x4 matrix.
+	const auto rowMajor = glm::transpose(transform);
+	std::memcpy(&instance.transform, &rowMajor, sizeof(instance.transform));
 
 	return instance;
 }
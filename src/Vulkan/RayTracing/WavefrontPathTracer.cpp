@@ -0,0 +1,419 @@
+#include "WavefrontPathTracer.hpp"
+#include "PathCounters.hpp"
+#include "TopLevelAccelerationStructure.hpp"
+#include "Assets/Material.hpp"
+#include "Assets/Scene.hpp"
+#include "Assets/UniformBuffer.hpp"
+#include "Utilities/Exception.hpp"
+#include "Vulkan/Buffer.hpp"
+#include "Vulkan/DescriptorBinding.hpp"
+#include "Vulkan/DescriptorSetManager.hpp"
+#include "Vulkan/DescriptorSets.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/ImageView.hpp"
+#include "Vulkan/PipelineCache.hpp"
+#include "Vulkan/PipelineLayout.hpp"
+#include "Vulkan/ShaderModule.hpp"
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace Vulkan::RayTracing {
+
+namespace
+{
+	// Must match the local size of the per pixel stages, Wavefront.Generate.comp and Wavefront.Accumulate.comp.
+	constexpr uint32_t GroupSize = 8;
+
+	// The material model of each shading stage, in the order of their queues (see ShadingStage() in Wavefront.glsl).
+	constexpr std::array<Assets::Material::Enum, 5> ShadingModels =
+	{
+		Assets::Material::Enum::Lambertian,
+		Assets::Material::Enum::Metallic,
+		Assets::Material::Enum::Dielectric,
+		Assets::Material::Enum::DiffuseLight,
+		Assets::Material::Enum::Isotropic
+	};
+
+	// Per path sizes of the buffers, see Wavefront.glsl.
+	constexpr VkDeviceSize PathSize = 48;
+	constexpr VkDeviceSize HitSize = 48;
+	constexpr VkDeviceSize ShadowRaySize = 32;
+	constexpr VkDeviceSize RadianceSize = 16;
+
+	// Makes the queues and the path data written by a stage (or reset by a transfer) visible to the next one, including
+	// to the indirect dispatches that read the queue counts.
+	void InsertBarrier(VkCommandBuffer commandBuffer)
+	{
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		const VkPipelineStageFlags stages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, stages, stages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+}
+
+WavefrontPathTracer::WavefrontPathTracer(
+	const class Device& device,
+	const PipelineCache& pipelineCache,
+	const VkExtent2D extent,
+	const TopLevelAccelerationStructure& accelerationStructure,
+	const RayTracingPipeline::StorageImages& storageImages,
+	const Assets::UniformBuffer& uniformBuffer,
+	const PathCounters& pathCounters,
+	const Assets::Scene& scene) :
+	device_(device)
+{
+	static_assert(sizeof(Queue) == 16, "Queue must match Wavefront.glsl");
+	static_assert(ShadingModels.size() == ShadingStageCount, "one shading pipeline per material model");
+
+	const auto stages = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	const std::vector<DescriptorBinding> descriptorBindings =
+	{
+		// The bindings of the ray tracing pipeline, less the ones of the temporal reprojection and the adaptive sampling.
+		{0, 1, VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, stages},
+		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stages},
+		{2, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stages},
+		{3, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, stages},
+		{4, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages},
+		{5, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages},
+		{6, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages},
+		{7, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages},
+		{8, static_cast<uint32_t>(scene.TextureSamplers().size()), VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, stages},
+		{9, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages},
+		{10, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages},
+		{11, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, stages},
+		{12, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stages},
+		{13, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stages},
+		{14, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stages},
+
+		// Paths, hits, shadow rays, queues, queue items and radiance (FirstBufferBinding onwards).
+		{15, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages},
+		{16, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages},
+		{17, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages},
+		{18, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages},
+		{19, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages},
+		{20, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages},
+
+		// Vertex attributes and primitive materials, bindings 17 and 18 of the ray tracing pipeline.
+		{21, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages},
+		{22, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages}
+	};
+
+	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, 1));
+
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	const auto accelerationStructureHandle = accelerationStructure.Handle();
+	VkWriteDescriptorSetAccelerationStructureKHR structureInfo = {};
+	structureInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
+	structureInfo.accelerationStructureCount = 1;
+	structureInfo.pAccelerationStructures = &accelerationStructureHandle;
+
+	const auto bufferInfo = [](const Buffer& buffer, const VkDeviceSize range)
+	{
+		VkDescriptorBufferInfo info = {};
+		info.buffer = buffer.Handle();
+		info.range = range;
+		return info;
+	};
+
+	const auto uniformBufferInfo = bufferInfo(uniformBuffer.Buffer(), uniformBuffer.SliceSize());
+	const auto vertexBufferInfo = bufferInfo(scene.VertexBuffer(), VK_WHOLE_SIZE);
+	const auto vertexAttributeBufferInfo = bufferInfo(scene.VertexAttributeBuffer(), VK_WHOLE_SIZE);
+	const auto primitiveMaterialBufferInfo = bufferInfo(scene.PrimitiveMaterialBuffer(), VK_WHOLE_SIZE);
+	const auto indexBufferInfo = bufferInfo(scene.IndexBuffer(), VK_WHOLE_SIZE);
+	const auto materialBufferInfo = bufferInfo(scene.MaterialBuffer(), VK_WHOLE_SIZE);
+	const auto offsetsBufferInfo = bufferInfo(scene.OffsetsBuffer(), VK_WHOLE_SIZE);
+	const auto lightBufferInfo = bufferInfo(scene.LightBuffer(), VK_WHOLE_SIZE);
+	const auto pathCountersInfo = bufferInfo(pathCounters.Buffer(), pathCounters.SliceSize());
+
+	std::vector<VkWriteDescriptorSet> descriptorWrites =
+	{
+		descriptorSets.Bind(0, 0, structureInfo),
+		descriptorSets.Bind(0, 3, uniformBufferInfo),
+		descriptorSets.Bind(0, 4, vertexBufferInfo),
+		descriptorSets.Bind(0, 5, indexBufferInfo),
+		descriptorSets.Bind(0, 6, materialBufferInfo),
+		descriptorSets.Bind(0, 7, offsetsBufferInfo),
+		descriptorSets.Bind(0, 10, lightBufferInfo),
+		descriptorSets.Bind(0, 11, pathCountersInfo),
+		descriptorSets.Bind(0, 21, vertexAttributeBufferInfo),
+		descriptorSets.Bind(0, 22, primitiveMaterialBufferInfo)
+	};
+
+	// Procedural buffer (optional)
+	VkDescriptorBufferInfo proceduralBufferInfo = {};
+
+	if (scene.HasProcedurals())
+	{
+		proceduralBufferInfo = bufferInfo(scene.ProceduralBuffer(), VK_WHOLE_SIZE);
+		descriptorWrites.push_back(descriptorSets.Bind(0, 9, proceduralBufferInfo));
+	}
+
+	descriptorSets.UpdateDescriptors(descriptorWrites);
+	UpdateTextures(scene);
+	Resize(extent, storageImages);
+
+	const VkPushConstantRange pushConstantRange = { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants) };
+	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout(), { pushConstantRange }));
+
+	generatePipeline_ = CreatePipeline(pipelineCache, "../assets/shaders/Wavefront.Generate.comp.spv", nullptr);
+	extendPipeline_ = CreatePipeline(pipelineCache, "../assets/shaders/Wavefront.Extend.comp.spv", nullptr);
+	shadowPipeline_ = CreatePipeline(pipelineCache, "../assets/shaders/Wavefront.Shadow.comp.spv", nullptr);
+	accumulatePipeline_ = CreatePipeline(pipelineCache, "../assets/shaders/Wavefront.Accumulate.comp.spv", nullptr);
+
+	// The shading stages only differ by the material model they are specialized for.
+	const VkSpecializationMapEntry specializationEntry = { 0, 0, sizeof(uint32_t) };
+
+	for (size_t i = 0; i != ShadingModels.size(); ++i)
+	{
+		const auto materialModel = static_cast<uint32_t>(ShadingModels[i]);
+
+		VkSpecializationInfo specializationInfo = {};
+		specializationInfo.mapEntryCount = 1;
+		specializationInfo.pMapEntries = &specializationEntry;
+		specializationInfo.dataSize = sizeof(materialModel);
+		specializationInfo.pData = &materialModel;
+
+		shadePipelines_[i] = CreatePipeline(pipelineCache, "../assets/shaders/Wavefront.Shade.comp.spv", &specializationInfo);
+	}
+}
+
+WavefrontPathTracer::~WavefrontPathTracer()
+{
+	std::vector<VkPipeline*> pipelines = { &generatePipeline_, &extendPipeline_, &shadowPipeline_, &accumulatePipeline_ };
+
+	for (auto& pipeline : shadePipelines_)
+	{
+		pipelines.push_back(&pipeline);
+	}
+
+	for (auto* pipeline : pipelines)
+	{
+		if (*pipeline != nullptr)
+		{
+			vkDestroyPipeline(device_.Handle(), *pipeline, nullptr);
+			*pipeline = nullptr;
+		}
+	}
+
+	pipelineLayout_.reset();
+	descriptorSetManager_.reset();
+	buffers_.clear();
+	bufferMemories_.clear(); // release memory after bound buffers have been destroyed
+}
+
+void WavefrontPathTracer::Resize(const VkExtent2D extent, const RayTracingPipeline::StorageImages& storageImages)
+{
+	const VkDeviceSize pathCount = static_cast<VkDeviceSize>(extent.width) * extent.height;
+
+	// Push() in Wavefront.glsl grows a queue's indirect dispatch by one group every WorkGroupSize paths.
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device_.PhysicalDevice(), &properties);
+
+	const VkDeviceSize maxGroupCount = (pathCount + WorkGroupSize - 1) / WorkGroupSize;
+	if (maxGroupCount > properties.limits.maxComputeWorkGroupCount[0])
+	{
+		Throw(std::runtime_error(
+			"wavefront queues need up to " + std::to_string(maxGroupCount) + " work groups at " +
+			std::to_string(extent.width) + "x" + std::to_string(extent.height) + ", the device supports " +
+			std::to_string(properties.limits.maxComputeWorkGroupCount[0])));
+	}
+
+	extent_ = extent;
+	buffers_.clear();
+	bufferMemories_.clear();
+
+	std::array<std::pair<VkDeviceSize, const char*>, BufferCount> bufferSizes{};
+	bufferSizes[PathBuffer] = { pathCount * PathSize, "Wavefront Paths" };
+	bufferSizes[HitBuffer] = { pathCount * HitSize, "Wavefront Hits" };
+	bufferSizes[ShadowRayBuffer] = { pathCount * ShadowRaySize, "Wavefront Shadow Rays" };
+	bufferSizes[QueueBuffer] = { QueueCount * sizeof(Queue), "Wavefront Queues" };
+	bufferSizes[QueueItemBuffer] = { QueueCount * pathCount * sizeof(uint32_t), "Wavefront Queue Items" };
+	bufferSizes[RadianceBuffer] = { pathCount * RadianceSize, "Wavefront Radiance" };
+
+	for (const auto& bufferSize : bufferSizes)
+	{
+		// The queues are reset with transfers, and double as the indirect dispatch arguments of the stages.
+		const bool isQueue = buffers_.size() == QueueBuffer;
+		const VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | (isQueue ? VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT : 0);
+
+		buffers_.emplace_back(new Buffer(device_, bufferSize.first, usage));
+		bufferMemories_.emplace_back(new DeviceMemory(buffers_.back()->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+
+		device_.DebugUtils().SetObjectName(buffers_.back()->Handle(), bufferSize.second);
+	}
+
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	const auto imageInfo = [](const ImageView& imageView)
+	{
+		VkDescriptorImageInfo info = {};
+		info.imageView = imageView.Handle();
+		info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		return info;
+	};
+
+	const auto accumulationImageInfo = imageInfo(storageImages.Accumulation);
+	const auto outputImageInfo = imageInfo(storageImages.Output);
+	const auto normalDepthImageInfo = imageInfo(storageImages.NormalDepth);
+	const auto albedoImageInfo = imageInfo(storageImages.Albedo);
+	const auto sampleCountImageInfo = imageInfo(storageImages.SampleCount);
+
+	std::vector<VkDescriptorBufferInfo> wavefrontBufferInfos;
+
+	for (const auto& buffer : buffers_)
+	{
+		VkDescriptorBufferInfo info = {};
+		info.buffer = buffer->Handle();
+		info.range = VK_WHOLE_SIZE;
+		wavefrontBufferInfos.push_back(info);
+	}
+
+	std::vector<VkWriteDescriptorSet> descriptorWrites =
+	{
+		descriptorSets.Bind(0, 1, accumulationImageInfo),
+		descriptorSets.Bind(0, 2, outputImageInfo),
+		descriptorSets.Bind(0, 12, normalDepthImageInfo),
+		descriptorSets.Bind(0, 13, albedoImageInfo),
+		descriptorSets.Bind(0, 14, sampleCountImageInfo)
+	};
+
+	for (size_t i = 0; i != wavefrontBufferInfos.size(); ++i)
+	{
+		descriptorWrites.push_back(descriptorSets.Bind(0, FirstBufferBinding + static_cast<uint32_t>(i), wavefrontBufferInfos[i]));
+	}
+
+	descriptorSets.UpdateDescriptors(descriptorWrites);
+}
+
+void WavefrontPathTracer::Render(
+	VkCommandBuffer commandBuffer,
+	const uint32_t dynamicOffsets[2],
+	const RayTracingPipeline::PushConstants& frame,
+	const uint32_t numberOfBounces) const
+{
+	VkDescriptorSet descriptorSets[] = { descriptorSetManager_->DescriptorSets().Handle(0) };
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout_->Handle(), 0, 1, descriptorSets, 2, dynamicOffsets);
+
+	const auto groupCountX = (extent_.width + GroupSize - 1) / GroupSize;
+	const auto groupCountY = (extent_.height + GroupSize - 1) / GroupSize;
+
+	PushConstants pushConstants = {};
+	pushConstants.TotalNumberOfSamples = frame.TotalNumberOfSamples;
+	pushConstants.NumberOfSamples = frame.NumberOfSamples;
+	pushConstants.SampleOffset = frame.SampleOffset;
+	pushConstants.Width = extent_.width;
+	pushConstants.Height = extent_.height;
+
+	// A frame without samples (e.g. when converged) still resolves the output image.
+	const uint32_t sampleCount = frame.NumberOfSamples != 0 ? frame.NumberOfSamples : 1;
+
+	for (uint32_t sample = 0; sample != sampleCount; ++sample)
+	{
+		pushConstants.Sample = sample;
+		pushConstants.Bounce = 0;
+
+		if (sample < frame.NumberOfSamples)
+		{
+			ResetQueues(commandBuffer, 0, QueueCount);
+			InsertBarrier(commandBuffer);
+
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, generatePipeline_);
+			vkCmdPushConstants(commandBuffer, pipelineLayout_->Handle(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+			vkCmdDispatch(commandBuffer, groupCountX, groupCountY, 1);
+			InsertBarrier(commandBuffer);
+
+			// Queues left empty once every path has terminated cost an empty indirect dispatch per stage.
+			for (uint32_t bounce = 0; bounce != numberOfBounces; ++bounce)
+			{
+				pushConstants.Bounce = bounce;
+
+				// The extension queue of the next bounce, and the shading and shadow queues, which are contiguous.
+				ResetQueues(commandBuffer, QueueExtend + (bounce + 1) % 2, 1);
+				ResetQueues(commandBuffer, QueueShade, QueueCount - QueueShade);
+				InsertBarrier(commandBuffer);
+
+				Dispatch(commandBuffer, extendPipeline_, pushConstants, QueueExtend + bounce % 2);
+				InsertBarrier(commandBuffer);
+
+				for (uint32_t stage = 0; stage != ShadingStageCount; ++stage)
+				{
+					Dispatch(commandBuffer, shadePipelines_[stage], pushConstants, QueueShade + stage);
+				}
+
+				InsertBarrier(commandBuffer);
+
+				Dispatch(commandBuffer, shadowPipeline_, pushConstants, QueueShadow);
+				InsertBarrier(commandBuffer);
+			}
+		}
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, accumulatePipeline_);
+		vkCmdPushConstants(commandBuffer, pipelineLayout_->Handle(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+		vkCmdDispatch(commandBuffer, groupCountX, groupCountY, 1);
+		InsertBarrier(commandBuffer);
+	}
+}
+
+VkPipeline WavefrontPathTracer::CreatePipeline(const PipelineCache& pipelineCache, const char* const filename, const VkSpecializationInfo* const specializationInfo) const
+{
+	const ShaderModule shader(device_, filename);
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = shader.CreateShaderStage(VK_SHADER_STAGE_COMPUTE_BIT);
+	pipelineInfo.stage.pSpecializationInfo = specializationInfo;
+	pipelineInfo.layout = pipelineLayout_->Handle();
+
+	VkPipeline pipeline;
+	Check(vkCreateComputePipelines(device_.Handle(), pipelineCache.Handle(), 1, &pipelineInfo, nullptr, &pipeline),
+		"create wavefront pipeline");
+
+	return pipeline;
+}
+
+void WavefrontPathTracer::ResetQueues(VkCommandBuffer commandBuffer, const uint32_t first, const uint32_t count) const
+{
+	// Empty queues, dispatched as zero work groups of one row.
+	std::array<Queue, QueueCount> queues{};
+
+	for (auto& queue : queues)
+	{
+		queue.Dispatch = { 0, 1, 1 };
+	}
+
+	vkCmdUpdateBuffer(commandBuffer, buffers_[QueueBuffer]->Handle(), first * sizeof(Queue), count * sizeof(Queue), queues.data());
+}
+
+void WavefrontPathTracer::Dispatch(VkCommandBuffer commandBuffer, const VkPipeline pipeline, const PushConstants& pushConstants, const uint32_t queue) const
+{
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	vkCmdPushConstants(commandBuffer, pipelineLayout_->Handle(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+	vkCmdDispatchIndirect(commandBuffer, buffers_[QueueBuffer]->Handle(), queue * sizeof(Queue) + offsetof(Queue, Dispatch));
+}
+
+void WavefrontPathTracer::UpdateTextures(const Assets::Scene& scene)
+{
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	// Image and texture samplers.
+	std::vector<VkDescriptorImageInfo> textureInfos(scene.TextureSamplers().size());
+
+	for (size_t t = 0; t != textureInfos.size(); ++t)
+	{
+		auto& textureInfo = textureInfos[t];
+		textureInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		textureInfo.imageView = scene.TextureImageViews()[t];
+		textureInfo.sampler = scene.TextureSamplers()[t];
+	}
+
+	descriptorSets.UpdateDescriptors({ descriptorSets.Bind(0, 8, *textureInfos.data(), static_cast<uint32_t>(textureInfos.size())) });
+}
+
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "RayTracingPipeline.hpp"
+#include "Vulkan/Vulkan.hpp"
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace Assets
+{
+	class Scene;
+	class UniformBuffer;
+}
+
+namespace Vulkan
+{
+	class Buffer;
+	class DescriptorSetManager;
+	class Device;
+	class DeviceMemory;
+	class PipelineCache;
+	class PipelineLayout;
+}
+
+namespace Vulkan::RayTracing
+{
+	class PathCounters;
+	class TopLevelAccelerationStructure;
+
+	// Path tracing split into compute stages that trace with ray queries (Laine et al. 2013, "Megakernels Considered
+	// Harmful"), an alternative to the single ray generation shader of RayTracingPipeline. The samples of a frame are
+	// traced one after the other, with one path per pixel:
+	// - Generate: camera rays, queued for extension.
+	// - Extend: closest hits, sorted into one shading queue per material model.
+	// - Shade: one pipeline per material model, queues a shadow ray to a light sample and the scattered path.
+	// - Shadow: adds the unoccluded light samples.
+	// - Accumulate: adds the sample to the accumulation image.
+	// Stages only run over the live paths of their queue, which are dispatched indirectly.
+	class WavefrontPathTracer final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(WavefrontPathTracer)
+
+		struct Settings final
+		{
+			bool Enabled;
+			uint32_t NumberOfBounces;
+		};
+
+		// Per dispatch data, see Wavefront.glsl.
+		struct PushConstants final
+		{
+			uint32_t TotalNumberOfSamples;
+			uint32_t NumberOfSamples;
+			uint32_t SampleOffset;
+			uint32_t Sample;
+			uint32_t Bounce;
+			uint32_t Width;
+			uint32_t Height;
+		};
+
+		WavefrontPathTracer(
+			const Device& device,
+			const PipelineCache& pipelineCache,
+			VkExtent2D extent,
+			const TopLevelAccelerationStructure& accelerationStructure,
+			const RayTracingPipeline::StorageImages& storageImages,
+			const Assets::UniformBuffer& uniformBuffer,
+			const PathCounters& pathCounters,
+			const Assets::Scene& scene);
+		~WavefrontPathTracer();
+
+		// Re-creates the per path buffers and rebinds the storage images, e.g. after a resize. The pipelines are kept.
+		// The descriptor set must not be in use by the device.
+		void Resize(VkExtent2D extent, const RayTracingPipeline::StorageImages& storageImages);
+
+		// Traces the samples of the frame into the storage images, like vkCmdTraceRaysKHR() with the ray tracing pipeline.
+		// The dynamic offsets select the uniform buffer and path counter slices of the frame.
+		void Render(
+			VkCommandBuffer commandBuffer,
+			const uint32_t dynamicOffsets[2],
+			const RayTracingPipeline::PushConstants& frame,
+			uint32_t numberOfBounces) const;
+
+		// Rebinds the scene textures (binding 8), see RayTracingPipeline::UpdateTextures().
+		void UpdateTextures(const Assets::Scene& scene);
+
+	private:
+
+		// Must match Wavefront.glsl.
+		static constexpr uint32_t WorkGroupSize = 64;
+		static constexpr uint32_t QueueExtend = 0;
+		static constexpr uint32_t QueueShade = 2;
+		static constexpr uint32_t QueueShadow = 7;
+		static constexpr uint32_t QueueCount = 8;
+		static constexpr uint32_t ShadingStageCount = 5; // one per material model
+
+		// Index of each buffer in buffers_, bound to FirstBufferBinding + index.
+		static constexpr size_t PathBuffer = 0;
+		static constexpr size_t HitBuffer = 1;
+		static constexpr size_t ShadowRayBuffer = 2;
+		static constexpr size_t QueueBuffer = 3;
+		static constexpr size_t QueueItemBuffer = 4;
+		static constexpr size_t RadianceBuffer = 5;
+		static constexpr size_t BufferCount = 6;
+		static constexpr uint32_t FirstBufferBinding = 15;
+
+		struct Queue final
+		{
+			uint32_t Count;
+			VkDispatchIndirectCommand Dispatch;
+		};
+
+		VkPipeline CreatePipeline(const PipelineCache& pipelineCache, const char* filename, const VkSpecializationInfo* specializationInfo) const;
+		void ResetQueues(VkCommandBuffer commandBuffer, uint32_t first, uint32_t count) const;
+		void Dispatch(VkCommandBuffer commandBuffer, VkPipeline pipeline, const PushConstants& pushConstants, uint32_t queue) const;
+
+		const class Device& device_;
+		VkExtent2D extent_{};
+
+		// Paths, hits, shadow rays, queues, queue items and radiance.
+		std::vector<std::unique_ptr<Buffer>> buffers_;
+		std::vector<std::unique_ptr<DeviceMemory>> bufferMemories_;
+
+		std::unique_ptr<DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<PipelineLayout> pipelineLayout_;
+
+		VkPipeline generatePipeline_{};
+		VkPipeline extendPipeline_{};
+		std::array<VkPipeline, ShadingStageCount> shadePipelines_{};
+		VkPipeline shadowPipeline_{};
+		VkPipeline accumulatePipeline_{};
+	};
+
+}
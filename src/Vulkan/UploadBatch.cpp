@@ -0,0 +1,200 @@
+#include "UploadBatch.hpp"
+#include "Buffer.hpp"
+#include "CommandBuffers.hpp"
+#include "CommandPool.hpp"
+#include "Device.hpp"
+#include "DeviceMemory.hpp"
+#include "Fence.hpp"
+#include "Image.hpp"
+#include <cstring>
+#include <limits>
+
+namespace Vulkan {
+
+namespace
+{
+	// Satisfies the 4 bytes and texel size alignment requirements of vkCmdCopyBufferToImage for all formats used here.
+	constexpr VkDeviceSize CopyAlignment = 16;
+
+	VkDeviceSize RoundUp(const VkDeviceSize size, const VkDeviceSize powerOf2Alignment)
+	{
+		return (size + powerOf2Alignment - 1) & ~(powerOf2Alignment - 1);
+	}
+}
+
+UploadBatch::UploadBatch(CommandPool& commandPool, const VkDeviceSize stagingSize) :
+	commandPool_(commandPool),
+	stagingSize_(stagingSize)
+{
+	const auto& device = commandPool.Device();
+
+	stagingBuffer_.reset(new Buffer(device, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT));
+	stagingBufferMemory_.reset(new DeviceMemory(stagingBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)));
+	fence_.reset(new Fence(device, false));
+
+	device.DebugUtils().SetObjectName(stagingBuffer_->Handle(), "Upload Staging Ring");
+}
+
+UploadBatch::~UploadBatch()
+{
+	Wait();
+
+	fence_.reset();
+	stagingBuffer_.reset();
+	stagingBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+}
+
+const Device& UploadBatch::Device() const
+{
+	return commandPool_.Device();
+}
+
+void UploadBatch::CopyToBuffer(const void* const data, const VkDeviceSize size, const Buffer& dstBuffer)
+{
+	VkDeviceSize offset;
+	const auto& stagingBuffer = Stage(data, size, offset);
+
+	VkBufferCopy copyRegion = {};
+	copyRegion.srcOffset = offset;
+	copyRegion.dstOffset = 0;
+	copyRegion.size = size;
+
+	vkCmdCopyBuffer(CommandBuffer(), stagingBuffer.Handle(), dstBuffer.Handle(), 1, &copyRegion);
+}
+
+void UploadBatch::CopyToImage(const void* const data, const VkDeviceSize size, Image& dstImage)
+{
+	VkDeviceSize offset;
+	const auto& stagingBuffer = Stage(data, size, offset);
+
+	dstImage.CopyFrom(CommandBuffer(), stagingBuffer, offset);
+}
+
+void UploadBatch::TransitionImageLayout(Image& image, const VkImageLayout newLayout)
+{
+	image.TransitionImageLayout(CommandBuffer(), newLayout);
+}
+
+void UploadBatch::GenerateMipmaps(Image& image)
+{
+	image.GenerateMipmaps(CommandBuffer());
+}
+
+void UploadBatch::Submit()
+{
+	if (!commandBuffers_ || submitted_)
+	{
+		return;
+	}
+
+	const auto commandBuffer = (*commandBuffers_)[0];
+
+	// Make the uploads visible to any command submitted later on this queue.
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	Check(vkEndCommandBuffer(commandBuffer),
+		"record upload command buffer");
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	fence_->Reset();
+
+	Check(vkQueueSubmit(commandPool_.Device().GraphicsQueue(), 1, &submitInfo, fence_->Handle()),
+		"submit upload command buffer");
+
+	submitted_ = true;
+}
+
+bool UploadBatch::IsComplete() const
+{
+	if (!commandBuffers_)
+	{
+		return true;
+	}
+
+	return submitted_ && vkGetFenceStatus(commandPool_.Device().Handle(), fence_->Handle()) == VK_SUCCESS;
+}
+
+void UploadBatch::Wait()
+{
+	Submit();
+
+	if (submitted_)
+	{
+		fence_->Wait(std::numeric_limits<uint64_t>::max());
+		submitted_ = false;
+	}
+
+	commandBuffers_.reset();
+	oversizedBuffers_.clear();
+	oversizedBufferMemories_.clear(); // release memory after bound buffers have been destroyed
+	stagingHead_ = 0;
+}
+
+VkCommandBuffer UploadBatch::CommandBuffer()
+{
+	// Only one submission in flight at a time, wait for it before recording more.
+	if (submitted_)
+	{
+		Wait();
+	}
+
+	if (!commandBuffers_)
+	{
+		commandBuffers_.reset(new CommandBuffers(commandPool_, 1));
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		Check(vkBeginCommandBuffer((*commandBuffers_)[0], &beginInfo),
+			"begin recording upload command buffer");
+	}
+
+	return (*commandBuffers_)[0];
+}
+
+const Buffer& UploadBatch::Stage(const void* const data, const VkDeviceSize size, VkDeviceSize& offset)
+{
+	if (submitted_)
+	{
+		Wait();
+	}
+
+	if (size > stagingSize_)
+	{
+		const auto& device = commandPool_.Device();
+
+		oversizedBuffers_.emplace_back(new Buffer(device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT));
+		oversizedBufferMemories_.emplace_back(new DeviceMemory(oversizedBuffers_.back()->AllocateStagingMemory()));
+
+		std::memcpy(oversizedBufferMemories_.back()->Map(0, size), data, size);
+
+		offset = 0;
+		return *oversizedBuffers_.back();
+	}
+
+	offset = RoundUp(stagingHead_, CopyAlignment);
+
+	// The ring is full, flush what has been recorded so far before reusing it.
+	if (offset + size > stagingSize_)
+	{
+		Wait();
+		offset = 0;
+	}
+
+	std::memcpy(stagingBufferMemory_->Map(offset, size), data, size);
+	stagingHead_ = offset + size;
+
+	return *stagingBuffer_;
+}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Vulkan
+{
+	class Buffer;
+	class CommandBuffers;
+	class CommandPool;
+	class DeviceMemory;
+	class Fence;
+	class Image;
+
+	// Records staging copies and layout transitions for many resources into as few command buffers as possible.
+	// Data goes through a persistently mapped staging ring; when it fills up the pending commands are submitted
+	// and waited for before the ring is reused. Uploads larger than the ring get a staging buffer of their own.
+	class UploadBatch final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(UploadBatch)
+
+		UploadBatch(CommandPool& commandPool, VkDeviceSize stagingSize);
+		~UploadBatch();
+
+		const class Device& Device() const;
+
+		void CopyToBuffer(const void* data, VkDeviceSize size, const Buffer& dstBuffer);
+		void CopyToImage(const void* data, VkDeviceSize size, Image& dstImage);
+		void TransitionImageLayout(Image& image, VkImageLayout newLayout);
+		void GenerateMipmaps(Image& image);
+
+		// Submits everything recorded so far. Later submissions on the same queue are ordered after the uploads.
+		void Submit();
+
+		// Polls the last submission, never blocks.
+		bool IsComplete() const;
+
+		// Submits anything still pending, blocks until it has completed and recycles the staging memory.
+		void Wait();
+
+	private:
+
+		VkCommandBuffer CommandBuffer();
+		const Buffer& Stage(const void* data, VkDeviceSize size, VkDeviceSize& offset);
+
+		CommandPool& commandPool_;
+
+		const VkDeviceSize stagingSize_;
+		std::unique_ptr<Buffer> stagingBuffer_;
+		std::unique_ptr<DeviceMemory> stagingBufferMemory_;
+		VkDeviceSize stagingHead_{};
+
+		std::unique_ptr<CommandBuffers> commandBuffers_;
+		std::unique_ptr<Fence> fence_;
+		bool submitted_{};
+
+		// Oversized uploads, released once the submission using them has completed.
+		std::vector<std::unique_ptr<Buffer>> oversizedBuffers_;
+		std::vector<std::unique_ptr<DeviceMemory>> oversizedBufferMemories_;
+	};
+
+}
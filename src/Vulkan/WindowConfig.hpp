@@ -14,5 +14,8 @@ namespace Vulkan
 		bool Fullscreen;
 		bool Resizable;
 		bool Maximized;
+
+		// No window, surface or swap chain, Width and Height are the size of the offscreen render target.
+		bool Headless;
 	};
 }
@@ -5,6 +5,8 @@
 #include "Vulkan/Version.hpp"
 #include "Utilities/Console.hpp"
 #include "Utilities/Exception.hpp"
+#include "Assets/Model.hpp"
+#include "Assets/TextureLoader.hpp"
 #include "Options.hpp"
 #include "RayTracer.hpp"
 
@@ -29,6 +31,10 @@ int main(int argc, const char* argv[]) noexcept
 	{
 		const Options options(argc, argv);
 		const UserSettings userSettings = CreateUserSettings(options);
+
+		Assets::Model::SetLoaderOptions(options.LoaderThreads, !options.NoModelCache);
+		Assets::TextureLoader::SetNumberOfThreads(options.LoaderThreads);
+
 		const Vulkan::WindowConfig windowConfig
 		{
 			"Museum of Light - Vulkan Ray Tracer",
@@ -37,7 +43,8 @@ int main(int argc, const char* argv[]) noexcept
 			options.Benchmark && options.Fullscreen,
 			options.Fullscreen,
 			!options.Fullscreen,
-			true  // Maximized by default
+			true, // Maximized by default
+			options.Headless
 		};
 
 		RayTracer application(userSettings, windowConfig, static_cast<VkPresentModeKHR>(options.PresentMode));
@@ -53,6 +60,12 @@ int main(int argc, const char* argv[]) noexcept
 
 		application.Run();
 
+		if (options.Headless)
+		{
+			std::cout << "Writing '" << options.Output << "'" << std::endl;
+			application.SaveOutputImage(options.Output);
+		}
+
 		return EXIT_SUCCESS;
 	}
 
@@ -97,6 +110,11 @@ namespace
 		userSettings.Benchmark = options.Benchmark;
 		userSettings.BenchmarkNextScenes = options.BenchmarkNextScenes;
 		userSettings.BenchmarkMaxTime = options.BenchmarkMaxTime;
+		userSettings.BenchmarkWarmupFrames = options.BenchmarkWarmupFrames;
+		userSettings.BenchmarkReport = options.BenchmarkReport;
+
+		userSettings.ReferenceImage = options.Reference;
+		userSettings.ConvergenceReport = options.ConvergenceReport;
 		
 		userSettings.SceneIndex = options.SceneIndex;
 
@@ -105,6 +123,23 @@ namespace
 		userSettings.NumberOfSamples = options.Samples;
 		userSettings.NumberOfBounces = options.Bounces;
 		userSettings.MaxNumberOfSamples = options.MaxSamples;
+		userSettings.CompactAccelerationStructures = options.CompactBlas;
+		userSettings.NextEventEstimation = options.NextEventEstimation;
+		userSettings.RussianRoulette = options.RussianRoulette;
+		userSettings.RussianRouletteMinDepth = options.RussianRouletteMinDepth;
+		userSettings.RussianRouletteMaxSurvival = options.RussianRouletteMaxSurvival;
+		userSettings.Sampler = options.Sampler;
+		userSettings.Engine = options.Engine;
+
+		userSettings.Denoise = options.Denoise;
+		userSettings.DenoiseIterations = options.DenoiseIterations;
+
+		userSettings.TemporalReprojection = options.TemporalReprojection;
+		userSettings.MaxHistoryLength = options.MaxHistoryLength;
+
+		userSettings.AdaptiveSampling = options.AdaptiveSampling;
+		userSettings.AdaptiveThreshold = options.AdaptiveThreshold;
+		userSettings.ShowSampleDistribution = false;
 
 		userSettings.ShowSettings = !options.Benchmark;
 		userSettings.ShowOverlay = true;
@@ -201,6 +236,11 @@ namespace
 
 	void PrintVulkanSwapChainInformation(const Vulkan::Application& application, const bool benchmark)
 	{
+		if (!application.HasSwapChain())
+		{
+			return;
+		}
+
 		const auto& swapChain = application.SwapChain();
 
 		std::cout << "Swap Chain: " << std::endl;
@@ -233,14 +273,17 @@ namespace
 				return false;
 			}
 
-			// We want a device that supports the ray tracing extension.
+			// We want a device that supports the ray tracing extensions (ray queries are optional, see HasRayQuery()).
 			const auto extensions = Vulkan::GetEnumerateVector(device, static_cast<const char*>(nullptr), vkEnumerateDeviceExtensionProperties);
-			const auto hasRayTracing = std::any_of(extensions.begin(), extensions.end(), [](const VkExtensionProperties& extension)
+			const auto hasExtension = [&extensions](const char* const name)
 			{
-				return strcmp(extension.extensionName, VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME) == 0;
-			});
+				return std::any_of(extensions.begin(), extensions.end(), [name](const VkExtensionProperties& extension)
+				{
+					return strcmp(extension.extensionName, name) == 0;
+				});
+			};
 
-			if (!hasRayTracing)
+			if (!hasExtension(VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME))
 			{
 				return false;
 			}